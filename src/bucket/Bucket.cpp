@@ -8,6 +8,8 @@
 #include "util/asio.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndex.h"
+#include "bucket/BucketKeyIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketOutputIterator.h"
@@ -64,6 +66,75 @@ Bucket::getFilename() const
     return mFilename;
 }
 
+std::shared_ptr<BucketIndex const>
+Bucket::getIndex(bool buildIfMissing) const
+{
+    if (mFilename.empty())
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mIndexMutex);
+        if (mIndex || (mIndexLoaded && !buildIfMissing))
+        {
+            return mIndex;
+        }
+    }
+
+    // One thread at a time reads or writes the index file; the others wait
+    // for it here and then find the index published.
+    std::lock_guard<std::mutex> buildLock(mIndexBuildMutex);
+    std::shared_ptr<BucketIndex const> index;
+    bool loaded;
+    {
+        std::lock_guard<std::mutex> lock(mIndexMutex);
+        if (mIndex || (mIndexLoaded && !buildIfMissing))
+        {
+            return mIndex;
+        }
+        loaded = mIndexLoaded;
+    }
+    if (!loaded)
+    {
+        index = BucketIndex::load(mFilename);
+    }
+    if (!index && buildIfMissing)
+    {
+        index = BucketIndex::build(mFilename);
+    }
+
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    mIndexLoaded = true;
+    mIndex.swap(index);
+    return mIndex;
+}
+
+bool
+Bucket::getEntry(LedgerKey const& key, BucketEntry& entry) const
+{
+    using xdr::operator==;
+
+    if (mFilename.empty())
+    {
+        return false;
+    }
+    auto index = getIndex(true);
+    if (!index->mayContain(key))
+    {
+        return false;
+    }
+
+    BucketKeyIterator iter(shared_from_this());
+    iter.advanceTo(key);
+    if (!iter || !(*iter == key))
+    {
+        return false;
+    }
+    iter.readEntry(entry);
+    return true;
+}
+
 bool
 Bucket::containsBucketIdentity(BucketEntry const& id) const
 {
@@ -139,8 +210,11 @@ Bucket::fresh(BucketManager& bucketManager,
 
     std::sort(dead.begin(), dead.end(), BucketEntryIdCmp());
 
-    BucketOutputIterator liveOut(bucketManager.getTmpDir(), true);
-    BucketOutputIterator deadOut(bucketManager.getTmpDir(), true);
+    // This runs on the main thread during ledger close, which should not
+    // wait for three fsyncs. Only the merged bucket is referenced by the
+    // bucket list, and it is flushed on a worker thread.
+    BucketOutputIterator liveOut(bucketManager.getTmpDir(), true, false);
+    BucketOutputIterator deadOut(bucketManager.getTmpDir(), true, false);
     for (auto const& e : live)
     {
         liveOut.put(e);
@@ -152,35 +226,46 @@ Bucket::fresh(BucketManager& bucketManager,
 
     auto liveBucket = liveOut.getBucket(bucketManager);
     auto deadBucket = deadOut.getBucket(bucketManager);
-    return Bucket::merge(bucketManager, liveBucket, deadBucket);
+    auto bucket = Bucket::merge(bucketManager, liveBucket, deadBucket, {},
+                                true, false);
+    bucketManager.fsyncBucketInBackground(bucket);
+    return bucket;
 }
 
-inline void
-maybePut(BucketOutputIterator& out, BucketEntry const& entry,
-         std::vector<BucketInputIterator>& shadowIterators)
+template <typename T>
+inline bool
+isShadowed(T const& id, std::vector<BucketKeyIterator>& shadowIterators)
 {
-    BucketEntryIdCmp cmp;
+    LedgerEntryIdCmp cmp;
     for (auto& si : shadowIterators)
     {
         // Advance the shadowIterator while it's less than the candidate
-        while (si && cmp(*si, entry))
-        {
-            ++si;
-        }
+        si.advanceTo(id);
         // We have stepped si forward to the point that either si is exhausted,
-        // or else *si >= entry; we now check the opposite direction to see if
+        // or else *si >= id; we now check the opposite direction to see if
         // we have equality.
-        if (si && !cmp(entry, *si))
+        if (si && !cmp(id, *si))
         {
-            // If so, then entry is shadowed in at least one level and we will
-            // not be doing a 'put'; we return early. There is no need to
-            // advance the other iterators, they will advance as and if
-            // necessary in future calls to maybePut.
-            return;
+            // If so, then id is shadowed in at least one level. There is no
+            // need to advance the other iterators, they will advance as and
+            // if necessary in future calls.
+            return true;
         }
     }
-    // Nothing shadowed.
-    out.put(entry);
+    return false;
+}
+
+inline void
+maybePut(BucketOutputIterator& out, BucketEntry const& entry,
+         std::vector<BucketKeyIterator>& shadowIterators)
+{
+    bool shadowed = entry.type() == LIVEENTRY
+                        ? isShadowed(entry.liveEntry().data, shadowIterators)
+                        : isShadowed(entry.deadEntry(), shadowIterators);
+    if (!shadowed)
+    {
+        out.put(entry);
+    }
 }
 
 std::shared_ptr<Bucket>
@@ -188,7 +273,7 @@ Bucket::merge(BucketManager& bucketManager,
               std::shared_ptr<Bucket> const& oldBucket,
               std::shared_ptr<Bucket> const& newBucket,
               std::vector<std::shared_ptr<Bucket>> const& shadows,
-              bool keepDeadEntries)
+              bool keepDeadEntries, bool doFsync)
 {
     // This is the key operation in the scheme: merging two (read-only)
     // buckets together into a new 3rd bucket, while calculating its hash,
@@ -200,11 +285,13 @@ Bucket::merge(BucketManager& bucketManager,
     BucketInputIterator oi(oldBucket);
     BucketInputIterator ni(newBucket);
 
-    std::vector<BucketInputIterator> shadowIterators(shadows.begin(),
-                                                     shadows.end());
+    // Shadows are only ever compared against, so only their keys are read.
+    std::vector<BucketKeyIterator> shadowIterators(shadows.begin(),
+                                                   shadows.end());
 
     auto timer = bucketManager.getMergeTimer().TimeScope();
-    BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries);
+    BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries,
+                             doFsync && bucketManager.shouldFsyncBucketFiles());
 
     BucketEntryIdCmp cmp;
     while (oi || ni)
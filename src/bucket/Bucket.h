@@ -9,6 +9,8 @@
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/XDRStream.h"
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace medida
@@ -30,6 +32,7 @@ namespace stellar
  * merged in sorted order, and all elements are hashed while being added.
  */
 
+class BucketIndex;
 class BucketManager;
 class BucketList;
 class Database;
@@ -41,6 +44,14 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     std::string const mFilename;
     Hash const mHash;
 
+    // mIndexMutex only guards the two fields below; loading or building the
+    // index is done under mIndexBuildMutex, so that it does not hold up
+    // readers of an index that is already there.
+    mutable std::mutex mIndexMutex;
+    mutable bool mIndexLoaded{false};
+    mutable std::shared_ptr<BucketIndex const> mIndex;
+    mutable std::mutex mIndexBuildMutex;
+
   public:
     // Create an empty bucket. The empty bucket has hash '000000...' and its
     // filename is the empty string.
@@ -54,6 +65,19 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     Hash const& getHash() const;
     std::string const& getFilename() const;
 
+    // Return the bucket's index, loading it on first use, or nullptr if it
+    // has none. If `buildIfMissing`, a bucket without an index gets one,
+    // which takes a pass over the bucket; BucketManager starts that in the
+    // background when adopting such a bucket. Safe to call from any thread.
+    std::shared_ptr<BucketIndex const>
+    getIndex(bool buildIfMissing = false) const;
+
+    // Look up the entry for `key`: return true and set `entry` if the bucket
+    // holds a live or dead entry for it. Builds the bucket's index if it has
+    // none, then only reads the bucket if its bloom filter lets `key`
+    // through, and then from the index sample preceding `key`.
+    bool getEntry(LedgerKey const& key, BucketEntry& entry) const;
+
     // Returns true if a BucketEntry that is key-wise identical to the given
     // BucketEntry exists in the bucket. For testing.
     bool containsBucketIdentity(BucketEntry const& id) const;
@@ -70,7 +94,8 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
 
     // Create a fresh bucket from a given vector of live LedgerEntries and
     // dead LedgerEntryKeys. The bucket will be sorted, hashed, and adopted
-    // in the provided BucketManager.
+    // in the provided BucketManager. It is written without fsync, and flushed
+    // to disk later on a worker thread.
     static std::shared_ptr<Bucket>
     fresh(BucketManager& bucketManager,
           std::vector<LedgerEntry> const& liveEntries,
@@ -79,14 +104,16 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // Merge two buckets together, producing a fresh one. Entries in `oldBucket`
     // are overridden in the fresh bucket by keywise-equal entries in
     // `newBucket`. Entries are inhibited from the fresh bucket by keywise-equal
-    // entries in any of the buckets in the provided `shadows` vector.
+    // entries in any of the buckets in the provided `shadows` vector. The
+    // output is flushed to disk if `doFsync` is set and
+    // BucketManager::shouldFsyncBucketFiles() allows it.
     static std::shared_ptr<Bucket>
     merge(BucketManager& bucketManager,
           std::shared_ptr<Bucket> const& oldBucket,
           std::shared_ptr<Bucket> const& newBucket,
           std::vector<std::shared_ptr<Bucket>> const& shadows =
               std::vector<std::shared_ptr<Bucket>>(),
-          bool keepDeadEntries = true);
+          bool keepDeadEntries = true, bool doFsync = true);
 };
 
 void checkDBAgainstBuckets(medida::MetricsRegistry& metrics,
@@ -5,15 +5,97 @@
 #include "util/asio.h"
 #include "bucket/BucketApplicator.h"
 #include "bucket/Bucket.h"
-#include "ledger/LedgerDelta.h"
+#include "ledger/AccountFrame.h"
+#include "ledger/DataFrame.h"
+#include "ledger/OfferFrame.h"
+#include "ledger/TrustFrame.h"
 #include "util/Logging.h"
 
 namespace stellar
 {
 
+// Number of bucket entries written per SQL transaction (and per call to
+// advance()). Entries are grouped by type and each group is written with a
+// handful of multi-row statements, so this can be much larger than it would
+// be for per-entry writes while still keeping each advance() short.
+static const size_t LEDGER_ENTRY_BATCH_COMMIT_SIZE = 0x1000;
+
+// Initial number of slots of a BucketApplyKeySet, a power of two.
+static const size_t KEY_SET_INITIAL_SLOTS = 0x10000;
+
+BucketApplyKeySet::BucketApplyKeySet() : mSlots(KEY_SET_INITIAL_SLOTS)
+{
+}
+
+static bool
+isZero(EntryCache::Digest const& d)
+{
+    return d.mLo == 0 && d.mHi == 0;
+}
+
+bool
+BucketApplyKeySet::insert(EntryCache::Digest const& d)
+{
+    if (isZero(d))
+    {
+        bool inserted = !mHasZero;
+        mHasZero = true;
+        return inserted;
+    }
+
+    // keep the load factor at most 1/2 so that probe sequences stay short
+    if (2 * (mSize + 1) > mSlots.size())
+    {
+        grow();
+    }
+
+    size_t mask = mSlots.size() - 1;
+    for (size_t i = d.mLo & mask;; i = (i + 1) & mask)
+    {
+        if (mSlots[i] == d)
+        {
+            return false;
+        }
+        if (isZero(mSlots[i]))
+        {
+            mSlots[i] = d;
+            ++mSize;
+            return true;
+        }
+    }
+}
+
+void
+BucketApplyKeySet::grow()
+{
+    std::vector<EntryCache::Digest> old(mSlots.size() * 2);
+    old.swap(mSlots);
+    size_t mask = mSlots.size() - 1;
+    for (auto const& d : old)
+    {
+        if (isZero(d))
+        {
+            continue;
+        }
+        size_t i = d.mLo & mask;
+        while (!isZero(mSlots[i]))
+        {
+            i = (i + 1) & mask;
+        }
+        mSlots[i] = d;
+    }
+}
+
+size_t
+BucketApplyKeySet::size() const
+{
+    return mSize + (mHasZero ? 1 : 0);
+}
+
 BucketApplicator::BucketApplicator(Database& db,
-                                   std::shared_ptr<const Bucket> bucket)
-    : mDb(db), mBucketIter(bucket)
+                                   std::shared_ptr<const Bucket> bucket,
+                                   BucketApplyKeySet* applied)
+    : mDb(db), mBucketIter(bucket), mApplied(applied)
 {
 }
 
@@ -25,36 +107,65 @@ BucketApplicator::operator bool() const
 void
 BucketApplicator::advance()
 {
+    // Live and dead entries of this batch, indexed by LedgerEntryType. A
+    // bucket holds at most one entry per key, so the order in which the
+    // groups are written does not matter.
+    std::vector<LedgerEntry> live[4];
+    std::vector<LedgerKey> dead[4];
+
     soci::transaction sqlTx(mDb.getSession());
-    for (; mBucketIter; ++mBucketIter)
+    for (size_t n = 0; mBucketIter && n < LEDGER_ENTRY_BATCH_COMMIT_SIZE;
+         ++mBucketIter, ++n)
     {
-        LedgerHeader lh;
-        LedgerDelta delta(lh, mDb, false);
-
         auto const& entry = *mBucketIter;
-        if (entry.type() == LIVEENTRY)
+        if (mApplied)
         {
-            EntryFrame::pointer ep = EntryFrame::FromXDR(entry.liveEntry());
-            ep->storeAddOrChange(delta, mDb);
+            // a newer bucket already wrote or deleted this key. A dead entry
+            // seen first is still deleted: deeper buckets that are not
+            // applied again may have left an older version in the database.
+            auto key = entry.type() == LIVEENTRY
+                           ? LedgerEntryKey(entry.liveEntry())
+                           : entry.deadEntry();
+            if (!mApplied->insert(mDb.getEntryCache().digest(key)))
+            {
+                ++mSkipped;
+                continue;
+            }
         }
-        else
+        if (entry.type() == LIVEENTRY)
         {
-            EntryFrame::storeDelete(delta, mDb, entry.deadEntry());
+            live[entry.liveEntry().data.type()].emplace_back(
+                entry.liveEntry());
         }
-        // No-op, just to avoid needless rollback.
-        delta.commit();
-        if ((++mSize & 0xff) == 0xff)
+        else
         {
-            break;
+            dead[entry.deadEntry().type()].emplace_back(entry.deadEntry());
         }
+        ++mSize;
     }
+
+    AccountFrame::storeDeleteBulk(mDb, dead[ACCOUNT]);
+    AccountFrame::storeUpsertBulk(mDb, live[ACCOUNT]);
+    TrustFrame::storeDeleteBulk(mDb, dead[TRUSTLINE]);
+    TrustFrame::storeUpsertBulk(mDb, live[TRUSTLINE]);
+    OfferFrame::storeDeleteBulk(mDb, dead[OFFER]);
+    OfferFrame::storeUpsertBulk(mDb, live[OFFER]);
+    DataFrame::storeDeleteBulk(mDb, dead[DATA]);
+    DataFrame::storeUpsertBulk(mDb, live[DATA]);
     sqlTx.commit();
-    mDb.clearPreparedStatementCache();
 
-    if (!mBucketIter || (mSize & 0xfff) == 0xfff)
+    // The bulk statements are the same for every batch, so keep them
+    // prepared until the whole bucket is applied.
+    if (!mBucketIter)
+    {
+        mDb.clearPreparedStatementCache();
+    }
+
+    if (!mBucketIter || ((mSize + mSkipped) & 0xffff) == 0)
     {
-        CLOG(INFO, "Bucket")
-            << "Bucket-apply: committed " << mSize << " entries";
+        CLOG(INFO, "Bucket") << "Bucket-apply: committed " << mSize
+                             << " entries, skipped " << mSkipped
+                             << " shadowed ones";
     }
 }
 }
@@ -7,26 +7,63 @@
 #include "bucket/Bucket.h"
 #include "bucket/BucketInputIterator.h"
 #include "database/Database.h"
+#include "database/EntryCache.h"
 #include "util/XDRStream.h"
 #include <memory>
+#include <vector>
 
 namespace stellar
 {
 
 class Database;
 
+// Set of the keys of the entries applied so far when applying buckets from
+// the newest to the oldest. Keys are kept as EntryCache digests in an
+// open-addressed table (linear probing), 16 bytes per slot, which stays small
+// enough to hold every key of the ledger.
+class BucketApplyKeySet
+{
+    std::vector<EntryCache::Digest> mSlots;
+    size_t mSize{0};
+    // the all-zero digest marks empty slots, so it is tracked on the side
+    bool mHasZero{false};
+
+    void grow();
+
+  public:
+    BucketApplyKeySet();
+
+    // Adds `d`, returns false if it was already in the set.
+    bool insert(EntryCache::Digest const& d);
+    size_t size() const;
+};
+
 // Class that represents a single apply-bucket-to-database operation in
 // progress. Used during history catchup to split up the task of applying
 // bucket into scheduler-friendly, bite-sized pieces.
+//
+// Each piece is written with the storeUpsertBulk and storeDeleteBulk helpers
+// of AccountFrame, TrustFrame, OfferFrame and DataFrame. They insert-or-replace
+// (resp. delete) a batch of entries of their type with a few multi-row
+// statements instead of a round-trip per entry, and write entries as-is,
+// including lastModifiedLedgerSeq.
+//
+// If `applied` is set, entries whose key is already in it are skipped and
+// the keys of the others are added: buckets are then expected to be applied
+// from the newest to the oldest, so that skipped entries are the ones
+// shadowed by a newer bucket.
 
 class BucketApplicator
 {
     Database& mDb;
     BucketInputIterator mBucketIter;
+    BucketApplyKeySet* mApplied;
     size_t mSize{0};
+    size_t mSkipped{0};
 
   public:
-    BucketApplicator(Database& db, std::shared_ptr<const Bucket> bucket);
+    BucketApplicator(Database& db, std::shared_ptr<const Bucket> bucket,
+                     BucketApplyKeySet* applied = nullptr);
     operator bool() const;
     void advance();
 };
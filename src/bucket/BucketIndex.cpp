@@ -0,0 +1,202 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketIndex.h"
+#include "ledger/EntryFrame.h"
+#include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/XDRStream.h"
+#include "xdrpp/marshal.h"
+#include <cstring>
+#include <sodium.h>
+
+namespace stellar
+{
+
+// About 100-200KB of entries between samples; the index of a bucket holding
+// ten million entries stays around a megabyte.
+uint32_t const BucketIndex::SAMPLE_INTERVAL = 1024;
+
+// First record of an index file; index files written before the bloom filter
+// was added start with a key instead and are rebuilt.
+static uint32_t const INDEX_FORMAT_MAGIC = 0x42494458;
+
+// Ten bits per key and seven probes give about 1% false positives.
+static size_t const BLOOM_BITS_PER_KEY = 10;
+static uint32_t const BLOOM_PROBES = 7;
+
+// Bloom filter bits are derived from SipHash-2-4 of the key's XDR; the hash
+// is part of the file format, so its key is fixed.
+static unsigned char const BLOOM_HASH_KEY[crypto_shorthash_KEYBYTES] = {};
+
+uint64_t
+BucketIndex::hashKey(LedgerKey const& key)
+{
+    auto bytes = xdr::xdr_to_opaque(key);
+    unsigned char out[crypto_shorthash_BYTES];
+    crypto_shorthash(out, bytes.data(), bytes.size(), BLOOM_HASH_KEY);
+    uint64_t res;
+    std::memcpy(&res, out, sizeof(res));
+    return res;
+}
+
+// Calls f with each of the BLOOM_PROBES bit positions of `hash` in a filter
+// of `nBits` bits (double hashing).
+template <typename F>
+static void
+forEachBloomBit(uint64_t hash, uint64_t nBits, F f)
+{
+    uint64_t h1 = hash & 0xffffffff;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < BLOOM_PROBES; ++i)
+    {
+        f((h1 + i * h2) % nBits);
+    }
+}
+
+void
+BucketIndex::Builder::add(LedgerKey const& key, uint64_t offset)
+{
+    if (mKeyHashes.size() % SAMPLE_INTERVAL == 0)
+    {
+        mSamples.emplace_back(Sample{key, offset});
+    }
+    mKeyHashes.emplace_back(hashKey(key));
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::Builder::finish()
+{
+    xdr::opaque_vec<> bloom;
+    bloom.resize((mKeyHashes.size() * BLOOM_BITS_PER_KEY + 7) / 8 + 1);
+    uint64_t nBits = bloom.size() * 8;
+    for (auto h : mKeyHashes)
+    {
+        forEachBloomBit(h, nBits, [&bloom](uint64_t bit) {
+            bloom[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+        });
+    }
+    mKeyHashes.clear();
+    return std::make_shared<BucketIndex const>(std::move(mSamples),
+                                               std::move(bloom));
+}
+
+BucketIndex::BucketIndex(std::vector<Sample> samples, xdr::opaque_vec<> bloom)
+    : mSamples(std::move(samples)), mBloom(std::move(bloom))
+{
+}
+
+bool
+BucketIndex::mayContain(LedgerKey const& key) const
+{
+    if (mBloom.empty())
+    {
+        return true;
+    }
+    bool res = true;
+    forEachBloomBit(hashKey(key), mBloom.size() * 8, [&](uint64_t bit) {
+        res = res && (mBloom[bit / 8] & (1 << (bit % 8))) != 0;
+    });
+    return res;
+}
+
+std::string
+BucketIndex::filenameFor(std::string const& bucketFilename)
+{
+    static std::string const xdrExt = ".xdr";
+    auto base = bucketFilename;
+    if (base.size() > xdrExt.size() &&
+        base.compare(base.size() - xdrExt.size(), xdrExt.size(), xdrExt) == 0)
+    {
+        base.resize(base.size() - xdrExt.size());
+    }
+    return base + ".index";
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::load(std::string const& bucketFilename)
+{
+    auto filename = filenameFor(bucketFilename);
+    if (!fs::exists(filename))
+    {
+        return nullptr;
+    }
+
+    std::vector<Sample> samples;
+    xdr::opaque_vec<> bloom;
+    try
+    {
+        XDRInputFileStream in;
+        in.open(filename);
+        uint32_t magic = 0;
+        if (!in.readOne(magic) || magic != INDEX_FORMAT_MAGIC ||
+            !in.readOne(bloom))
+        {
+            throw std::runtime_error("unknown bucket index format");
+        }
+        Sample s;
+        while (in.readOne(s.mKey))
+        {
+            if (!in.readOne(s.mOffset))
+            {
+                throw std::runtime_error("truncated bucket index");
+            }
+            samples.emplace_back(s);
+        }
+    }
+    catch (std::exception& e)
+    {
+        CLOG(WARNING, "Bucket") << "Ignoring unreadable bucket index "
+                                << filename << ": " << e.what();
+        return nullptr;
+    }
+    return std::make_shared<BucketIndex const>(std::move(samples),
+                                               std::move(bloom));
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndex::build(std::string const& bucketFilename)
+{
+    CLOG(INFO, "Bucket") << "Building index of bucket " << bucketFilename;
+    Builder builder;
+    XDRInputFileStream in;
+    in.open(bucketFilename);
+    BucketEntry e;
+    for (size_t pos = in.pos(); in.readOne(e); pos = in.pos())
+    {
+        builder.add(e.type() == LIVEENTRY ? LedgerEntryKey(e.liveEntry())
+                                          : e.deadEntry(),
+                    pos);
+    }
+    in.close();
+
+    auto res = builder.finish();
+    try
+    {
+        res->write(bucketFilename);
+    }
+    catch (std::exception& e)
+    {
+        // the index still serves this process
+        CLOG(WARNING, "Bucket") << "Unable to write index of bucket "
+                                << bucketFilename << ": " << e.what();
+    }
+    return res;
+}
+
+void
+BucketIndex::write(std::string const& bucketFilename) const
+{
+    XDROutputFileStream out;
+    out.open(filenameFor(bucketFilename));
+    out.writeOne(INDEX_FORMAT_MAGIC);
+    out.writeOne(mBloom);
+    for (auto const& s : mSamples)
+    {
+        out.writeOne(s.mKey);
+        out.writeOne(s.mOffset);
+    }
+    out.close();
+}
+}
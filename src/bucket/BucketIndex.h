@@ -0,0 +1,103 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/LedgerCmp.h"
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Index of a bucket file: the key and file offset of every
+ * SAMPLE_INTERVAL-th entry, in bucket order, and a bloom filter over the
+ * keys of all its entries.
+ *
+ * The index is written by BucketOutputIterator into a file beside the
+ * bucket's own (see filenameFor), and moved and deleted along with it by
+ * the BucketManager. Buckets that were not produced locally, such as those
+ * downloaded from history, have no index until one is built for them; readers
+ * must treat the index as an optional accelerator and get the same results
+ * without it.
+ */
+class BucketIndex : NonMovableOrCopyable
+{
+  public:
+    static uint32_t const SAMPLE_INTERVAL;
+
+    struct Sample
+    {
+        LedgerKey mKey;
+        uint64_t mOffset;
+    };
+
+    // Accumulates the index of a bucket while its entries are written.
+    class Builder
+    {
+        std::vector<Sample> mSamples;
+        std::vector<uint64_t> mKeyHashes;
+
+      public:
+        // Record the entry with `key` written at `offset`; entries must be
+        // added in bucket order.
+        void add(LedgerKey const& key, uint64_t offset);
+
+        std::shared_ptr<BucketIndex const> finish();
+    };
+
+    BucketIndex(std::vector<Sample> samples, xdr::opaque_vec<> bloom);
+
+    // Name of the index file of the bucket file `bucketFilename`.
+    static std::string filenameFor(std::string const& bucketFilename);
+
+    // Load the index of the bucket file `bucketFilename`, or return nullptr
+    // if there is none or it cannot be read.
+    static std::shared_ptr<BucketIndex const>
+    load(std::string const& bucketFilename);
+
+    // Read through the bucket file `bucketFilename` to build its index, and
+    // write it beside the bucket.
+    static std::shared_ptr<BucketIndex const>
+    build(std::string const& bucketFilename);
+
+    // Write this as the index of the bucket file `bucketFilename`.
+    void write(std::string const& bucketFilename) const;
+
+    std::vector<Sample> const&
+    getSamples() const
+    {
+        return mSamples;
+    }
+
+    // False if the bucket certainly holds no entry for `key`; true if it
+    // does, or (about one time in a hundred) if it does not.
+    bool mayContain(LedgerKey const& key) const;
+
+    // Position of the first sample at or after `from` whose key is greater
+    // than `id` (a LedgerKey or LedgerEntryData).
+    template <typename T>
+    size_t
+    upperBound(size_t from, T const& id) const
+    {
+        LedgerEntryIdCmp cmp;
+        auto it = std::upper_bound(
+            mSamples.begin() + std::min(from, mSamples.size()), mSamples.end(),
+            id, [&cmp](T const& i, Sample const& s) { return cmp(i, s.mKey); });
+        return it - mSamples.begin();
+    }
+
+  private:
+    std::vector<Sample> const mSamples;
+    xdr::opaque_vec<> const mBloom;
+
+    static uint64_t hashKey(LedgerKey const& key);
+};
+}
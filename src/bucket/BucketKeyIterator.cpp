@@ -0,0 +1,111 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketKeyIterator.h"
+#include "bucket/Bucket.h"
+
+namespace stellar
+{
+
+void
+BucketKeyIterator::loadKey()
+{
+    mPos = mIn.pos();
+    char const* data;
+    uint32_t sz;
+    if (!mIn.readRaw(data, sz))
+    {
+        mValid = false;
+        return;
+    }
+
+    // A BucketEntry starts with its type. A LIVEENTRY continues with its
+    // LedgerEntry, whose lastModifiedLedgerSeq precedes its data, and a
+    // DEADENTRY with a LedgerKey. Every arm of LedgerEntryData starts with
+    // exactly the fields of the matching LedgerKey arm, so either way the
+    // key can be decoded in place and the rest of the entry left alone.
+    xdr::xdr_get g(data, data + sz);
+    BucketEntryType type;
+    xdr::xdr_argpack_archive(g, type);
+    if (type == LIVEENTRY)
+    {
+        uint32 lastModifiedLedgerSeq;
+        xdr::xdr_argpack_archive(g, lastModifiedLedgerSeq);
+    }
+    xdr::xdr_argpack_archive(g, mKey);
+    mValid = true;
+}
+
+bool
+BucketKeyIterator::seekSample(size_t i)
+{
+    using xdr::operator==;
+
+    auto const& sample = mIndex->getSamples().at(i);
+    auto pos = mPos;
+    mIn.seek(sample.mOffset);
+    loadKey();
+    if (mValid && mKey == sample.mKey)
+    {
+        return true;
+    }
+
+    CLOG(WARNING, "Bucket") << "Bucket index of " << mBucket->getFilename()
+                            << " does not match bucket, ignoring it";
+    mIndex.reset();
+    mIn.seek(pos);
+    loadKey();
+    return false;
+}
+
+BucketKeyIterator::operator bool() const
+{
+    return mValid;
+}
+
+LedgerKey const& BucketKeyIterator::operator*() const
+{
+    return mKey;
+}
+
+BucketKeyIterator::BucketKeyIterator(std::shared_ptr<Bucket const> bucket)
+    : mBucket(bucket)
+{
+    if (!mBucket->getFilename().empty())
+    {
+        CLOG(TRACE, "Bucket") << "BucketKeyIterator opening file to read: "
+                              << mBucket->getFilename();
+        mIndex = mBucket->getIndex();
+        mIn.openMapped(mBucket->getFilename());
+        loadKey();
+    }
+}
+
+BucketKeyIterator::~BucketKeyIterator()
+{
+    mIn.close();
+}
+
+void
+BucketKeyIterator::readEntry(BucketEntry& entry)
+{
+    assert(mValid);
+    // the stream is left where loadKey left it, after the current entry
+    mIn.seek(mPos);
+    mIn.readOne(entry);
+}
+
+BucketKeyIterator& BucketKeyIterator::operator++()
+{
+    if (mIn)
+    {
+        loadKey();
+    }
+    else
+    {
+        mValid = false;
+    }
+    return *this;
+}
+}
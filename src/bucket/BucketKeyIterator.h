@@ -0,0 +1,89 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketIndex.h"
+#include "bucket/LedgerCmp.h"
+#include "util/XDRStream.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <memory>
+
+namespace stellar
+{
+
+class Bucket;
+
+// Helper class that reads through the keys of the entries in a bucket,
+// decoding only the key of each entry, and that can skip ahead using the
+// bucket's index.
+class BucketKeyIterator
+{
+    std::shared_ptr<Bucket const> mBucket;
+    std::shared_ptr<BucketIndex const> mIndex;
+
+    XDRInputFileStream mIn;
+    LedgerKey mKey;
+    bool mValid{false};
+
+    // Offset of the current entry, and first index sample that may still lie
+    // ahead of it.
+    size_t mPos{0};
+    size_t mNextSample{0};
+
+    void loadKey();
+
+    // Jump forward to index sample `i`; returns false (and stays put) if the
+    // index does not agree with the bucket.
+    bool seekSample(size_t i);
+
+  public:
+    operator bool() const;
+
+    LedgerKey const& operator*() const;
+
+    BucketKeyIterator(std::shared_ptr<Bucket const> bucket);
+
+    ~BucketKeyIterator();
+
+    BucketKeyIterator& operator++();
+
+    // Read the whole entry whose key is the current one.
+    void readEntry(BucketEntry& entry);
+
+    // Advance to the first key that is not less than `id` (a LedgerKey or
+    // LedgerEntryData); never moves backwards.
+    template <typename T>
+    void
+    advanceTo(T const& id)
+    {
+        LedgerEntryIdCmp cmp;
+        if (!mValid || !cmp(mKey, id))
+        {
+            return;
+        }
+        if (mIndex)
+        {
+            auto const& samples = mIndex->getSamples();
+            // Only search the index when the target is at least one sample
+            // away; most calls move ahead by a few entries at most.
+            if (mNextSample < samples.size() &&
+                !cmp(id, samples[mNextSample].mKey))
+            {
+                size_t ub = mIndex->upperBound(mNextSample, id);
+                if (samples[ub - 1].mOffset > mPos)
+                {
+                    seekSample(ub - 1);
+                }
+                mNextSample = ub;
+            }
+        }
+        while (mValid && cmp(mKey, id))
+        {
+            ++*this;
+        }
+    }
+};
+}
@@ -119,8 +119,7 @@ BucketLevel::prepare(Application& app, uint32_t currLedger,
         }
     }
 
-    mNextCurr = FutureBucket(app, curr, snap, shadows,
-                             BucketList::keepDeadEntries(mLevel));
+    mNextCurr = FutureBucket(app, curr, snap, shadows, mLevel);
     assert(mNextCurr.isMerging());
 }
 
@@ -294,6 +293,27 @@ BucketList::getHash() const
     return hsh->finish();
 }
 
+std::shared_ptr<LedgerEntry const>
+BucketList::getLedgerEntry(LedgerKey const& key) const
+{
+    BucketEntry entry;
+    for (auto const& lev : mLevels)
+    {
+        for (auto const& b : {lev.getCurr(), lev.getSnap()})
+        {
+            if (b->getEntry(key, entry))
+            {
+                if (entry.type() == DEADENTRY)
+                {
+                    return nullptr;
+                }
+                return std::make_shared<LedgerEntry const>(entry.liveEntry());
+            }
+        }
+    }
+    return nullptr;
+}
+
 bool
 BucketList::levelShouldSpill(uint32_t ledger, uint32_t level)
 {
@@ -425,7 +445,7 @@ BucketList::restartMerges(Application& app)
         auto& next = level.getNext();
         if (next.hasHashes() && !next.isLive())
         {
-            next.makeLive(app, keepDeadEntries(i));
+            next.makeLive(app, i);
             if (next.isMerging())
             {
                 CLOG(INFO, "Bucket")
@@ -336,6 +336,13 @@ class BucketList
     // of the concatenation of the hashes of the `curr` and `snap` buckets.
     Hash getHash() const;
 
+    // Return the current state of the ledger entry for `key`, or nullptr if
+    // there is none, read from the buckets rather than the database: the
+    // newest bucket holding an entry for `key` decides. See
+    // Bucket::getEntry.
+    std::shared_ptr<LedgerEntry const>
+    getLedgerEntry(LedgerKey const& key) const;
+
     // Restart any merges that might be running on background worker threads,
     // merging buckets between levels. This needs to be called after forcing a
     // BucketList to adopt a new state, either at application restart or when
@@ -16,6 +16,7 @@ namespace stellar
 
 class Application;
 class BucketList;
+class BucketMergeScheduler;
 struct LedgerHeader;
 struct HistoryArchiveState;
 
@@ -54,22 +55,37 @@ class BucketManager : NonMovableOrCopyable
     virtual std::string const& getBucketDir() = 0;
     virtual BucketList& getBucketList() = 0;
 
+    // Whether new bucket files are flushed to disk before they are adopted.
+    virtual bool shouldFsyncBucketFiles() const = 0;
+
     virtual medida::Timer& getMergeTimer() = 0;
 
+    // Queue through which all bucket merges are run.
+    virtual BucketMergeScheduler& getMergeScheduler() = 0;
+
     // Get a reference to a persistent bucket (in the BucketManager's bucket
     // directory), from the BucketManager's shared bucket-set.
     //
     // Concretely: if `hash` names an existing bucket -- either in-memory or on
     // disk -- delete `filename` and return an object for the existing bucket;
     // otherwise move `filename` to the bucket directory, stored under `hash`,
-    // and return a new bucket pointing to that.
+    // and return a new bucket pointing to that. With `doFsync`, the caller
+    // has already flushed `filename` to disk, and the rename into the bucket
+    // directory is flushed as well.
     //
     // This method is mostly-threadsafe -- assuming you don't destruct the
     // BucketManager mid-call -- and is intended to be called from both main and
     // worker threads. Very carefully.
     virtual std::shared_ptr<Bucket>
     adoptFileAsBucket(std::string const& filename, uint256 const& hash,
-                      size_t nObjects = 0, size_t nBytes = 0) = 0;
+                      size_t nObjects = 0, size_t nBytes = 0,
+                      bool doFsync = false) = 0;
+
+    // Flush an adopted bucket file and the bucket directory to disk on a
+    // worker thread, unless shouldFsyncBucketFiles() is false. Used for the
+    // buckets written during ledger close, which is not held up by fsync.
+    virtual void
+    fsyncBucketInBackground(std::shared_ptr<Bucket> const& bucket) = 0;
 
     // Return a bucket by hash if we have it, else return nullptr.
     virtual std::shared_ptr<Bucket> getBucketByHash(uint256 const& hash) = 0;
@@ -2,7 +2,13 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+// ASIO is somewhat particular about when it gets included -- it wants to be the
+// first to include <windows.h> -- so we try to include it before everything
+// else.
+#include "util/asio.h"
+
 #include "bucket/BucketManagerImpl.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketList.h"
 #include "crypto/Hex.h"
 #include "history/HistoryManager.h"
@@ -54,6 +60,7 @@ BucketManager::dropAll(Application& app)
 
 BucketManagerImpl::BucketManagerImpl(Application& app)
     : mApp(app)
+    , mMergeScheduler(app)
     , mWorkDir(nullptr)
     , mLockedBucketDir(nullptr)
     , mBucketObjectInsert(
@@ -64,11 +71,13 @@ BucketManagerImpl::BucketManagerImpl(Application& app)
     , mBucketSnapMerge(app.getMetrics().NewTimer({"bucket", "snap", "merge"}))
     , mSharedBucketsSize(
           app.getMetrics().NewCounter({"bucket", "memory", "shared"}))
-
+    , mBucketFileDelete(
+          app.getMetrics().NewMeter({"bucket", "file", "delete"}, "file"))
 {
 }
 
 const std::string BucketManagerImpl::kLockFilename = "stellar-core.lock";
+const std::string BucketManagerImpl::kDeletedDirname = "deleted";
 
 static std::string
 bucketBasename(std::string const& bucketHexHash)
@@ -116,6 +125,19 @@ BucketManagerImpl::getBucketDir()
         fs::lockFile(lock);
 
         mLockedBucketDir = make_unique<std::string>(d);
+
+        // Anything left in the deleted directory was being unlinked when a
+        // previous process stopped.
+        std::string deleted = d + "/" + kDeletedDirname;
+        if (fs::exists(deleted))
+        {
+            fs::deltree(deleted);
+        }
+        if (!fs::mkpath(deleted))
+        {
+            throw std::runtime_error("Unable to create directory: " +
+                                     deleted);
+        }
     }
     return *(mLockedBucketDir);
 }
@@ -137,16 +159,28 @@ BucketManagerImpl::getBucketList()
     return mBucketList;
 }
 
+bool
+BucketManagerImpl::shouldFsyncBucketFiles() const
+{
+    return !mApp.getConfig().DISABLE_XDR_FSYNC;
+}
+
 medida::Timer&
 BucketManagerImpl::getMergeTimer()
 {
     return mBucketSnapMerge;
 }
 
+BucketMergeScheduler&
+BucketManagerImpl::getMergeScheduler()
+{
+    return mMergeScheduler;
+}
+
 std::shared_ptr<Bucket>
 BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
                                      uint256 const& hash, size_t nObjects,
-                                     size_t nBytes)
+                                     size_t nBytes, bool doFsync)
 {
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
     // Check to see if we have an existing bucket (either in-memory or on-disk)
@@ -155,7 +189,7 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
     {
         CLOG(DEBUG, "Bucket") << "Deleting bucket file " << filename
                               << " that is redundant with existing bucket";
-        std::remove(filename.c_str());
+        deleteBucketFiles(filename, true);
     }
     else
     {
@@ -170,17 +204,86 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             err += strerror(errno);
             throw std::runtime_error(err);
         }
+        if (doFsync && !fs::syncDir(getBucketDir()))
+        {
+            std::string err("Failed to sync bucket dir: ");
+            err += strerror(errno);
+            throw std::runtime_error(err);
+        }
+        // Buckets downloaded from history come without an index.
+        auto indexName = BucketIndex::filenameFor(filename);
+        bool indexed = fs::exists(indexName);
+        if (indexed &&
+            rename(indexName.c_str(),
+                   BucketIndex::filenameFor(canonicalName).c_str()) != 0)
+        {
+            CLOG(WARNING, "Bucket") << "Failed to rename bucket index "
+                                    << indexName << ": " << strerror(errno);
+            std::remove(indexName.c_str());
+            indexed = false;
+        }
 
         b = std::make_shared<Bucket>(canonicalName, hash);
         {
             mSharedBuckets.insert(std::make_pair(hash, b));
             mSharedBucketsSize.set_count(mSharedBuckets.size());
         }
+
+        if (!indexed)
+        {
+            // Build the index in the background rather than on the first
+            // lookup; a bucket that is dropped meanwhile needs none.
+            std::weak_ptr<Bucket> weak(b);
+            mApp.getWorkerIOService().post([weak]() {
+                auto bucket = weak.lock();
+                if (!bucket)
+                {
+                    return;
+                }
+                try
+                {
+                    bucket->getIndex(true);
+                }
+                catch (std::exception& e)
+                {
+                    // the first lookup will try again, and report it
+                    CLOG(WARNING, "Bucket")
+                        << "Unable to index bucket " << bucket->getFilename()
+                        << ": " << e.what();
+                }
+            });
+        }
     }
     assert(b);
     return b;
 }
 
+void
+BucketManagerImpl::fsyncBucketInBackground(
+    std::shared_ptr<Bucket> const& bucket)
+{
+    if (!shouldFsyncBucketFiles() || bucket->getFilename().empty())
+    {
+        return;
+    }
+    std::weak_ptr<Bucket> weak(bucket);
+    std::string dir = getBucketDir();
+    mApp.getWorkerIOService().post([weak, dir]() {
+        // a bucket that was dropped meanwhile may have been deleted already
+        auto b = weak.lock();
+        if (!b)
+        {
+            return;
+        }
+        if (!fs::syncFile(b->getFilename()) || !fs::syncDir(dir))
+        {
+            CLOG(WARNING, "Bucket") << "Failed to sync bucket file "
+                                    << b->getFilename() << ": "
+                                    << strerror(errno);
+        }
+    });
+}
+
 std::shared_ptr<Bucket>
 BucketManagerImpl::getBucketByHash(uint256 const& hash)
 {
@@ -211,42 +314,92 @@ BucketManagerImpl::getBucketByHash(uint256 const& hash)
     return std::shared_ptr<Bucket>();
 }
 
+void
+BucketManagerImpl::deleteBucketFiles(std::string const& filename,
+                                     bool inBackground)
+{
+    // Unlinking a large bucket can block for a long time on some filesystems,
+    // so the files are first renamed out of the way, which is cheap and frees
+    // the canonical name at once, and then unlinked by a worker thread.
+    std::vector<std::string> toDelete;
+    for (auto const& f : {filename, BucketIndex::filenameFor(filename)})
+    {
+        if (!inBackground)
+        {
+            std::remove(f.c_str());
+            continue;
+        }
+        std::string deleted = getBucketDir() + "/" + kDeletedDirname + "/" +
+                              std::to_string(mNextDeletedFile++);
+        if (rename(f.c_str(), deleted.c_str()) == 0)
+        {
+            toDelete.emplace_back(std::move(deleted));
+        }
+        else
+        {
+            std::remove(f.c_str());
+        }
+    }
+    mBucketFileDelete.Mark();
+
+    if (!toDelete.empty())
+    {
+        mApp.getWorkerIOService().post([toDelete]() {
+            for (auto const& f : toDelete)
+            {
+                std::remove(f.c_str());
+            }
+        });
+    }
+}
+
 void
 BucketManagerImpl::forgetUnreferencedBuckets()
+{
+    forgetUnreferencedBuckets(true);
+}
+
+void
+BucketManagerImpl::forgetUnreferencedBuckets(bool inBackground)
 {
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
-    std::set<Hash> referenced;
-    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+
+    // Buckets held by the bucket list, by merges or by anyone else are
+    // retained by their shared_ptr reference count, so only the buckets we
+    // are the last owner of are candidates for deletion.
+    std::vector<std::map<Hash, std::shared_ptr<Bucket>>::iterator> candidates;
+    for (auto i = mSharedBuckets.begin(); i != mSharedBuckets.end(); ++i)
     {
-        auto const& level = mBucketList.getLevel(i);
-        referenced.insert(level.getCurr()->getHash());
-        referenced.insert(level.getSnap()->getHash());
-        for (auto const& h : level.getNext().getHashes())
+        if (i->second.use_count() == 1)
         {
-            referenced.insert(hexToBin256(h));
+            candidates.push_back(i);
         }
     }
+    if (candidates.empty())
+    {
+        return;
+    }
 
-    // Implicitly retain any buckets that are referenced by a state in
-    // the publish queue.
-    auto pub = mApp.getHistoryManager().getBucketsReferencedByPublishQueue();
+    // Some references are by hash only: merges restarted from a saved state
+    // that are not running yet, and states in the publish queue, whose
+    // bucket counts the history manager keeps up to date as states are
+    // queued and published.
+    std::set<Hash> referenced;
+    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
     {
-        for (auto const& h : pub)
+        for (auto const& h : mBucketList.getLevel(i).getNext().getHashes())
         {
-            CLOG(DEBUG, "Bucket")
-                << "BucketManager::forgetUnreferencedBuckets: " << h
-                << " referenced by publish queue";
             referenced.insert(hexToBin256(h));
         }
     }
-
-    for (auto i = mSharedBuckets.begin(); i != mSharedBuckets.end();)
+    for (auto const& h :
+         mApp.getHistoryManager().getBucketsReferencedByPublishQueue())
     {
-        // Standard says map iterators other than the one you're erasing remain
-        // valid.
-        auto j = i;
-        ++i;
+        referenced.insert(hexToBin256(h));
+    }
 
+    for (auto const& j : candidates)
+    {
         // Only drop buckets if the bucketlist has forgotten them _and_
         // no other in-progress structures (worker threads, shadow lists)
         // have references to them, just us. It's ok to retain a few too
@@ -257,20 +410,23 @@ BucketManagerImpl::forgetUnreferencedBuckets()
         // we're the first and last to know about it. Otherwise buckets might
         // race on deleting the underlying file from one another.
 
-        if (referenced.find(j->first) == referenced.end() &&
-            j->second.use_count() == 1)
+        if (referenced.find(j->first) != referenced.end())
         {
-            auto filename = j->second->getFilename();
-            CLOG(TRACE, "Bucket")
-                << "BucketManager::forgetUnreferencedBuckets dropping "
-                << filename;
-            if (!filename.empty())
-            {
-                CLOG(TRACE, "Bucket") << "removing bucket file: " << filename;
-                std::remove(filename.c_str());
-            }
-            mSharedBuckets.erase(j);
+            CLOG(DEBUG, "Bucket")
+                << "BucketManager::forgetUnreferencedBuckets: "
+                << binToHex(j->first) << " referenced by hash";
+            continue;
+        }
+
+        auto filename = j->second->getFilename();
+        CLOG(TRACE, "Bucket")
+            << "BucketManager::forgetUnreferencedBuckets dropping " << filename;
+        if (!filename.empty())
+        {
+            CLOG(TRACE, "Bucket") << "removing bucket file: " << filename;
+            deleteBucketFiles(filename, inBackground);
         }
+        mSharedBuckets.erase(j);
     }
     mSharedBucketsSize.set_count(mSharedBuckets.size());
 }
@@ -357,6 +513,6 @@ void
 BucketManagerImpl::shutdown()
 {
     // forgetUnreferencedBuckets does what we want - it retains needed buckets
-    forgetUnreferencedBuckets();
+    forgetUnreferencedBuckets(false);
 }
 }
@@ -2,6 +2,7 @@
 
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
+#include "bucket/BucketMergeScheduler.h"
 #include "overlay/StellarXDR.h"
 
 #include <map>
@@ -32,9 +33,11 @@ struct HistoryArchiveState;
 class BucketManagerImpl : public BucketManager
 {
     static std::string const kLockFilename;
+    static std::string const kDeletedDirname;
 
     Application& mApp;
     BucketList mBucketList;
+    BucketMergeScheduler mMergeScheduler;
     std::unique_ptr<TmpDir> mWorkDir;
     std::map<Hash, std::shared_ptr<Bucket>> mSharedBuckets;
     mutable std::recursive_mutex mBucketMutex;
@@ -44,6 +47,12 @@ class BucketManagerImpl : public BucketManager
     medida::Timer& mBucketAddBatch;
     medida::Timer& mBucketSnapMerge;
     medida::Counter& mSharedBucketsSize;
+    medida::Meter& mBucketFileDelete;
+    uint64_t mNextDeletedFile{0};
+
+    // Called with mBucketMutex held.
+    void deleteBucketFiles(std::string const& filename, bool inBackground);
+    void forgetUnreferencedBuckets(bool inBackground);
 
   protected:
     void calculateSkipValues(LedgerHeader& currentHeader);
@@ -56,11 +65,15 @@ class BucketManagerImpl : public BucketManager
     std::string const& getTmpDir() override;
     std::string const& getBucketDir() override;
     BucketList& getBucketList() override;
+    bool shouldFsyncBucketFiles() const override;
     medida::Timer& getMergeTimer() override;
+    BucketMergeScheduler& getMergeScheduler() override;
     std::shared_ptr<Bucket> adoptFileAsBucket(std::string const& filename,
                                               uint256 const& hash,
-                                              size_t nObjects,
-                                              size_t nBytes) override;
+                                              size_t nObjects, size_t nBytes,
+                                              bool doFsync) override;
+    void
+    fsyncBucketInBackground(std::shared_ptr<Bucket> const& bucket) override;
     std::shared_ptr<Bucket> getBucketByHash(uint256 const& hash) override;
 
     void forgetUnreferencedBuckets() override;
@@ -0,0 +1,190 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// ASIO is somewhat particular about when it gets included -- it wants to be the
+// first to include <windows.h> -- so we try to include it before everything
+// else.
+#include "util/asio.h"
+
+#include "bucket/BucketMergeScheduler.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/Logging.h"
+
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace stellar
+{
+
+// Level 5 and up spill every 2048 ledgers or less often, and their merges
+// take minutes rather than milliseconds.
+uint32_t const BucketMergeScheduler::FIRST_DEEP_LEVEL = 5;
+
+static size_t
+maxRunningMerges()
+{
+    // One per core, but never fewer than one deep and one shallow merge.
+    return std::max<size_t>(2, std::thread::hardware_concurrency());
+}
+
+BucketMergeScheduler::BucketMergeScheduler(Application& app)
+    : mApp(app)
+    , mMaxRunning(maxRunningMerges())
+    , mMaxRunningDeep(std::min<size_t>(
+          app.getConfig().MAX_CONCURRENT_DEEP_MERGES, mMaxRunning - 1))
+{
+    for (size_t i = 0; i < mMaxRunning; ++i)
+    {
+        mThreads.emplace_back([this]() { runMergeThread(); });
+    }
+}
+
+BucketMergeScheduler::~BucketMergeScheduler()
+{
+    shutdown();
+}
+
+void
+BucketMergeScheduler::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCanRun.notify_all();
+    for (auto& t : mThreads)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+}
+
+bool
+BucketMergeScheduler::MergeCmp::operator()(Merge const& a,
+                                           Merge const& b) const
+{
+    // std::priority_queue puts the greatest element on top.
+    if (a.mLevel != b.mLevel)
+    {
+        return a.mLevel > b.mLevel;
+    }
+    return a.mSeq > b.mSeq;
+}
+
+BucketMergeScheduler::LevelMetrics&
+BucketMergeScheduler::getMetrics(uint32_t level)
+{
+    auto it = mMetrics.find(level);
+    if (it == mMetrics.end())
+    {
+        auto name = "level-" + std::to_string(level);
+        auto& metrics = mApp.getMetrics();
+        it = mMetrics
+                 .emplace(level,
+                          LevelMetrics{metrics.NewCounter(
+                                           {"bucket", "merge-queue", name}),
+                                       metrics.NewTimer(
+                                           {"bucket", "merge-time", name})})
+                 .first;
+    }
+    return it->second;
+}
+
+void
+BucketMergeScheduler::enqueue(uint32_t level, std::function<void()> merge)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push(Merge{level, mNextSeq++, merge});
+        ++mQueueDepth[level];
+        getMetrics(level).mQueueDepth.inc();
+        CLOG(TRACE, "Bucket") << "Queued merge for level " << level << " ("
+                              << mQueue.size() << " queued, " << mRunning
+                              << " running)";
+    }
+    mCanRun.notify_one();
+}
+
+size_t
+BucketMergeScheduler::getQueueDepth(uint32_t level) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mQueueDepth.find(level);
+    return it == mQueueDepth.end() ? 0 : it->second;
+}
+
+size_t
+BucketMergeScheduler::getRunning() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRunning;
+}
+
+bool
+BucketMergeScheduler::canRun(Merge const& m) const
+{
+    if (mRunning >= mMaxRunning)
+    {
+        return false;
+    }
+    return m.mLevel < FIRST_DEEP_LEVEL || mRunningDeep < mMaxRunningDeep;
+}
+
+void
+BucketMergeScheduler::runMergeThread()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        // The top is the shallowest queued merge: if it cannot run, nothing
+        // behind it can either.
+        mCanRun.wait(lock, [this]() {
+            return (!mQueue.empty() && canRun(mQueue.top())) ||
+                   (mStopping && mQueue.empty());
+        });
+        if (mQueue.empty())
+        {
+            return;
+        }
+
+        Merge m = mQueue.top();
+        mQueue.pop();
+        --mQueueDepth[m.mLevel];
+        auto& metrics = getMetrics(m.mLevel);
+        metrics.mQueueDepth.dec();
+        bool deep = m.mLevel >= FIRST_DEEP_LEVEL;
+        ++mRunning;
+        if (deep)
+        {
+            ++mRunningDeep;
+        }
+
+        lock.unlock();
+        {
+            auto timer = metrics.mMergeTime.TimeScope();
+            m.mRun();
+        }
+        lock.lock();
+
+        --mRunning;
+        if (deep)
+        {
+            --mRunningDeep;
+        }
+        // this thread picks up the next merge itself; the idle ones only
+        // need waking to exit once the queue has drained
+        if (mStopping)
+        {
+            mCanRun.notify_all();
+        }
+    }
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+
+/**
+ * Runs bucket merges on threads of its own, shallowest level first.
+ *
+ * Merges wait here until a merge thread is free. When one frees up, the
+ * queued merge of the lowest level runs next (oldest first within a level),
+ * so that the small merges the next ledger close will resolve are not stuck
+ * behind the large ones of the deep levels.
+ *
+ * There is one merge thread per core, and at least two. Of those, at most
+ * MAX_CONCURRENT_DEEP_MERGES run merges into deep levels, and never all of
+ * them, so that a shallow merge always has a thread to run on, whatever the
+ * worker io_service is busy with.
+ *
+ * enqueue() may be called from any thread. shutdown() runs the merges still
+ * queued, then joins the merge threads.
+ */
+class BucketMergeScheduler : NonMovableOrCopyable
+{
+  public:
+    // Levels at or above this one are "deep" and subject to the tighter
+    // concurrency limit.
+    static uint32_t const FIRST_DEEP_LEVEL;
+
+    explicit BucketMergeScheduler(Application& app);
+    ~BucketMergeScheduler();
+
+    // Queue `merge`, which merges into BucketList level `level`.
+    void enqueue(uint32_t level, std::function<void()> merge);
+
+    // Number of merges of `level` waiting for a slot.
+    size_t getQueueDepth(uint32_t level) const;
+
+    // Number of merges currently running.
+    size_t getRunning() const;
+
+    // Runs what is left in the queue and joins the merge threads; later
+    // calls do nothing.
+    void shutdown();
+
+    // Limits on the number of merges running at once, in total (which is
+    // also the number of merge threads) and into deep levels.
+    size_t
+    getMaxRunning() const
+    {
+        return mMaxRunning;
+    }
+    size_t
+    getMaxRunningDeep() const
+    {
+        return mMaxRunningDeep;
+    }
+
+  private:
+    struct Merge
+    {
+        uint32_t mLevel;
+        uint64_t mSeq;
+        std::function<void()> mRun;
+    };
+
+    // Orders the priority queue so that its top is the lowest level, then
+    // the earliest enqueued.
+    struct MergeCmp
+    {
+        bool operator()(Merge const& a, Merge const& b) const;
+    };
+
+    struct LevelMetrics
+    {
+        medida::Counter& mQueueDepth;
+        medida::Timer& mMergeTime;
+    };
+
+    Application& mApp;
+    size_t const mMaxRunning;
+    size_t const mMaxRunningDeep;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCanRun;
+    std::priority_queue<Merge, std::vector<Merge>, MergeCmp> mQueue;
+    std::map<uint32_t, size_t> mQueueDepth;
+    std::map<uint32_t, LevelMetrics> mMetrics;
+    uint64_t mNextSeq{0};
+    size_t mRunning{0};
+    size_t mRunningDeep{0};
+    bool mStopping{false};
+    std::vector<std::thread> mThreads;
+
+    // Both are called with mMutex held.
+    LevelMetrics& getMetrics(uint32_t level);
+    bool canRun(Merge const& m) const;
+
+    void runMergeThread();
+};
+}
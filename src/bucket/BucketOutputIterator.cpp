@@ -5,8 +5,11 @@
 #include "bucket/BucketOutputIterator.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketManager.h"
+#include "crypto/Hex.h"
 #include "crypto/Random.h"
+#include "util/Logging.h"
 #include "util/make_unique.h"
+#include <fstream>
 
 namespace stellar
 {
@@ -34,17 +37,28 @@ randomBucketName(std::string const& tmpDir)
  * hashes them while writing to either destination. Produces a Bucket when done.
  */
 BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
-                                           bool keepDeadEntries)
+                                           bool keepDeadEntries, bool doFsync)
     : mFilename(randomBucketName(tmpDir))
     , mBuf(nullptr)
-    , mHasher(SHA256::create())
     , mKeepDeadEntries(keepDeadEntries)
+    , mDoFsync(doFsync)
 {
     CLOG(TRACE, "Bucket") << "BucketOutputIterator opening file to write: "
                           << mFilename;
     mOut.open(mFilename);
 }
 
+void
+BucketOutputIterator::writeBuffered()
+{
+    mIndexBuilder.add(mBuf->type() == LIVEENTRY
+                          ? LedgerEntryKey(mBuf->liveEntry())
+                          : mBuf->deadEntry(),
+                      mOut.bytesPut());
+    mOut.writeOne(*mBuf);
+    mObjectsPut++;
+}
+
 void
 BucketOutputIterator::put(BucketEntry const& e)
 {
@@ -64,8 +78,7 @@ BucketOutputIterator::put(BucketEntry const& e)
         // merely replace (same identity), the buffered entry.
         if (mCmp(*mBuf, e))
         {
-            mOut.writeOne(*mBuf, mHasher.get(), &mBytesPut);
-            mObjectsPut++;
+            writeBuffered();
         }
     }
     else
@@ -80,24 +93,24 @@ BucketOutputIterator::put(BucketEntry const& e)
 std::shared_ptr<Bucket>
 BucketOutputIterator::getBucket(BucketManager& bucketManager)
 {
-    assert(mOut);
     if (mBuf)
     {
-        mOut.writeOne(*mBuf, mHasher.get(), &mBytesPut);
-        mObjectsPut++;
+        writeBuffered();
         mBuf.reset();
     }
 
-    mOut.close();
-    if (mObjectsPut == 0 || mBytesPut == 0)
+    size_t bytesPut = mOut.bytesPut();
+    auto hash = mOut.close(mDoFsync && mObjectsPut != 0);
+    if (mObjectsPut == 0 || bytesPut == 0)
     {
         assert(mObjectsPut == 0);
-        assert(mBytesPut == 0);
+        assert(bytesPut == 0);
         CLOG(DEBUG, "Bucket") << "Deleting empty bucket file " << mFilename;
         std::remove(mFilename.c_str());
         return std::make_shared<Bucket>();
     }
-    return bucketManager.adoptFileAsBucket(mFilename, mHasher->finish(),
-                                           mObjectsPut, mBytesPut);
+    mIndexBuilder.finish()->write(mFilename);
+    return bucketManager.adoptFileAsBucket(mFilename, hash, mObjectsPut,
+                                           bytesPut, mDoFsync);
 }
 }
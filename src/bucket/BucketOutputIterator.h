@@ -4,12 +4,14 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "bucket/BucketIndex.h"
 #include "bucket/LedgerCmp.h"
-#include "util/XDRStream.h"
+#include "util/XDRBlockOutputFileStream.h"
 #include "xdr/Stellar-ledger.h"
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace stellar
 {
@@ -18,20 +20,26 @@ class Bucket;
 class BucketManager;
 
 // Helper class that writes new elements to a file and returns a bucket
-// when finished.
+// when finished. Entries are serialized on the calling thread while a writer
+// thread hashes and writes them out, see XDRBlockOutputFileStream.
 class BucketOutputIterator
 {
     std::string mFilename;
-    XDROutputFileStream mOut;
+    XDRBlockOutputFileStream mOut;
     BucketEntryIdCmp mCmp;
     std::unique_ptr<BucketEntry> mBuf;
-    std::unique_ptr<SHA256> mHasher;
-    size_t mBytesPut{0};
     size_t mObjectsPut{0};
     bool mKeepDeadEntries{true};
+    bool mDoFsync{false};
+    BucketIndex::Builder mIndexBuilder;
+
+    void writeBuffered();
 
   public:
-    BucketOutputIterator(std::string const& tmpDir, bool keepDeadEntries);
+    // `doFsync` flushes the file to disk before it is adopted as a bucket,
+    // and the bucket directory after.
+    BucketOutputIterator(std::string const& tmpDir, bool keepDeadEntries,
+                         bool doFsync);
 
     void put(BucketEntry const& e);
 
@@ -7,18 +7,24 @@
 // else.
 #include "util/asio.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
+#include "bucket/BucketKeyIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketManagerImpl.h"
+#include "bucket/BucketMergeScheduler.h"
 #include "bucket/LedgerCmp.h"
 #include "crypto/Hex.h"
 #include "database/Database.h"
 #include "herder/LedgerCloseData.h"
+#include "ledger/EntryFrame.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTestUtils.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
+#include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
@@ -31,7 +37,11 @@
 #include "util/types.h"
 #include "xdrpp/autocheck.h"
 #include <algorithm>
+#include <atomic>
 #include <future>
+#include <map>
+#include <random>
+#include <thread>
 
 using namespace stellar;
 
@@ -283,6 +293,103 @@ TEST_CASE("bucket list", "[bucket]")
     }
 }
 
+TEST_CASE("bucket list point lookups", "[bucket][bucketlookup]")
+{
+    using xdr::operator==;
+
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    BucketList bl;
+    std::map<LedgerKey, std::shared_ptr<LedgerEntry const>, LedgerEntryIdCmp>
+        state;
+    std::vector<LedgerKey> keys;
+    std::default_random_engine gen;
+    for (uint32_t i = 1;
+         !app->getClock().getIOService().stopped() && i < 300; ++i)
+    {
+        app->getClock().crank(false);
+        auto live = LedgerTestUtils::generateValidLedgerEntries(8);
+        std::vector<LedgerKey> dead;
+        if (keys.size() > 1)
+        {
+            // modify one existing entry and delete another
+            std::uniform_int_distribution<size_t> dist(0, keys.size() - 1);
+            auto changed = dist(gen);
+            auto deleted = dist(gen);
+            if (state[keys[changed]])
+            {
+                LedgerEntry e = *state[keys[changed]];
+                e.lastModifiedLedgerSeq = i;
+                live.emplace_back(e);
+            }
+            if (deleted != changed && state[keys[deleted]])
+            {
+                dead.emplace_back(keys[deleted]);
+            }
+        }
+        bl.addBatch(*app, i, live, dead);
+
+        for (auto const& e : live)
+        {
+            auto k = LedgerEntryKey(e);
+            if (state.find(k) == state.end())
+            {
+                keys.emplace_back(k);
+            }
+            state[k] = std::make_shared<LedgerEntry const>(e);
+        }
+        for (auto const& k : dead)
+        {
+            state[k] = nullptr;
+        }
+    }
+
+    for (auto const& s : state)
+    {
+        auto got = bl.getLedgerEntry(s.first);
+        if (s.second)
+        {
+            REQUIRE(got);
+            REQUIRE(*got == *s.second);
+        }
+        else
+        {
+            REQUIRE(!got);
+        }
+    }
+    for (auto const& e : LedgerTestUtils::generateValidLedgerEntries(50))
+    {
+        REQUIRE(!bl.getLedgerEntry(LedgerEntryKey(e)));
+    }
+
+    SECTION("buckets without index get one on lookup")
+    {
+        auto b = bl.getLevel(2).getCurr();
+        if (b->getFilename().empty())
+        {
+            b = bl.getLevel(2).getSnap();
+        }
+        REQUIRE(!b->getFilename().empty());
+        auto indexFile = BucketIndex::filenameFor(b->getFilename());
+        std::remove(indexFile.c_str());
+        auto unindexed =
+            std::make_shared<Bucket>(b->getFilename(), b->getHash());
+        REQUIRE(!unindexed->getIndex());
+
+        BucketInputIterator in(b);
+        REQUIRE(in);
+        auto key = (*in).type() == LIVEENTRY ? LedgerEntryKey((*in).liveEntry())
+                                             : (*in).deadEntry();
+        BucketEntry found;
+        REQUIRE(unindexed->getEntry(key, found));
+        REQUIRE(found == *in);
+        REQUIRE(unindexed->getIndex());
+        REQUIRE(fs::exists(indexFile));
+    }
+}
+
 TEST_CASE("bucket list shadowing", "[bucket]")
 {
     VirtualClock clock;
@@ -398,6 +505,28 @@ TEST_CASE("duplicate bucket entries", "[bucket]")
     }
 }
 
+TEST_CASE("bucket apply key set", "[bucket][bucketapply]")
+{
+    BucketApplyKeySet keys;
+
+    // the all-zero digest doubles as the empty slot marker
+    REQUIRE(keys.insert({0, 0}));
+    REQUIRE(!keys.insert({0, 0}));
+
+    // enough keys to grow the table several times, some sharing a slot
+    uint64_t const n = 300000;
+    for (uint64_t i = 1; i <= n; ++i)
+    {
+        REQUIRE(keys.insert({i, i % 7}));
+    }
+    for (uint64_t i = 1; i <= n; ++i)
+    {
+        REQUIRE(!keys.insert({i, i % 7}));
+    }
+    REQUIRE(keys.insert({1, 8}));
+    REQUIRE(keys.size() == n + 2);
+}
+
 TEST_CASE("bucket tombstones expire at bottom level", "[bucket][tombstones]")
 {
     VirtualClock clock;
@@ -702,6 +831,42 @@ TEST_CASE("bucketmanager ownership", "[bucket]")
     CHECK(!fs::exists(filename));
 }
 
+TEST_CASE("bucketmanager deletes files in the background", "[bucket]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto& deleted = app->getMetrics().NewMeter(
+        {"bucket", "file", "delete"}, "file");
+    auto deletedBefore = deleted.count();
+
+    std::vector<LedgerEntry> live(
+        LedgerTestUtils::generateValidLedgerEntries(10));
+    std::vector<LedgerKey> dead{};
+
+    auto b = Bucket::fresh(bm, live, dead);
+    auto hash = b->getHash();
+    auto filename = b->getFilename();
+    b.reset();
+
+    // The canonical name is released before forgetUnreferencedBuckets
+    // returns, so the same bucket can be adopted again straight away.
+    bm.forgetUnreferencedBuckets();
+    CHECK(!fs::exists(filename));
+    CHECK(deleted.count() == deletedBefore + 1);
+    b = Bucket::fresh(bm, live, dead);
+    REQUIRE(b->getHash() == hash);
+    REQUIRE(b->getFilename() == filename);
+
+    // Once the workers are done, the old files are gone and the new ones
+    // are untouched.
+    clearFutures(app, bm.getBucketList());
+    CHECK(!fs::exists(bm.getBucketDir() + "/deleted/0"));
+    CHECK(fs::exists(filename));
+    CHECK(b->countLiveAndDeadEntries().first == live.size());
+}
+
 TEST_CASE("single entry bubbling up", "[bucket][bucketbubble]")
 {
     VirtualClock clock;
@@ -1109,7 +1274,255 @@ TEST_CASE("bucket apply", "[bucket]")
     REQUIRE(count == 1);
 }
 
+TEST_CASE("bucket apply writes, overwrites and deletes all entry types",
+          "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    app->start();
+
+    auto& db = app->getDatabase();
+    std::vector<LedgerEntry> live =
+        LedgerTestUtils::generateValidLedgerEntries(5000);
+    std::vector<LedgerEntry> noLive;
+    std::vector<LedgerKey> dead, noDead;
+    for (auto const& e : live)
+    {
+        dead.emplace_back(LedgerEntryKey(e));
+    }
+
+    Bucket::fresh(app->getBucketManager(), live, noDead)->apply(db);
+    for (auto const& e : live)
+    {
+        REQUIRE(EntryFrame::checkAgainstDatabase(e, db) == "");
+    }
+
+    // Applying again over existing rows must update them in place.
+    for (auto& e : live)
+    {
+        e.lastModifiedLedgerSeq += 1;
+    }
+    Bucket::fresh(app->getBucketManager(), live, noDead)->apply(db);
+    for (auto const& e : live)
+    {
+        REQUIRE(EntryFrame::checkAgainstDatabase(e, db) == "");
+    }
+
+    Bucket::fresh(app->getBucketManager(), noLive, dead)->apply(db);
+    for (auto const& k : dead)
+    {
+        EntryFrame::flushCachedEntry(k, db);
+        REQUIRE(!EntryFrame::exists(db, k));
+    }
+}
+
 #ifdef USE_POSTGRES
+TEST_CASE("bucket key iterator and index", "[bucket][bucketindex]")
+{
+    using xdr::operator==;
+
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+
+    autocheck::generator<std::vector<LedgerKey>> deadGen;
+    auto live = LedgerTestUtils::generateValidLedgerEntries(
+        3 * BucketIndex::SAMPLE_INTERVAL + 100);
+    auto dead = deadGen(50);
+    auto b = Bucket::fresh(bm, live, dead);
+
+    std::vector<LedgerKey> keys;
+    for (BucketInputIterator in(b); in; ++in)
+    {
+        auto const& e = *in;
+        keys.emplace_back(e.type() == LIVEENTRY ? LedgerEntryKey(e.liveEntry())
+                                                : e.deadEntry());
+    }
+
+    auto index = b->getIndex();
+    REQUIRE(index);
+    REQUIRE(fs::exists(BucketIndex::filenameFor(b->getFilename())));
+    REQUIRE(index->getSamples().size() ==
+            (keys.size() + BucketIndex::SAMPLE_INTERVAL - 1) /
+                BucketIndex::SAMPLE_INTERVAL);
+
+    SECTION("iterates keys in bucket order")
+    {
+        std::vector<LedgerKey> got;
+        for (BucketKeyIterator ki(b); ki; ++ki)
+        {
+            got.emplace_back(*ki);
+        }
+        REQUIRE(got.size() == keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            REQUIRE(got[i] == keys[i]);
+        }
+    }
+
+    SECTION("skips ahead to present and absent keys")
+    {
+        BucketKeyIterator ki(b);
+        for (size_t i = 1; i < keys.size(); i += 700)
+        {
+            ki.advanceTo(keys[i]);
+            REQUIRE(ki);
+            REQUIRE(*ki == keys[i]);
+        }
+        // The iterator never moves backwards.
+        auto current = *ki;
+        ki.advanceTo(keys[0]);
+        REQUIRE(*ki == current);
+        ki.advanceTo(keys.back());
+        REQUIRE(*ki == keys.back());
+        ++ki;
+        REQUIRE(!ki);
+    }
+
+    SECTION("merges shadow the same with and without index")
+    {
+        // Every third entry of the shadow is overwritten in the old bucket.
+        std::vector<LedgerEntry> oldLive, newLive;
+        for (size_t i = 0; i < live.size(); i += 3)
+        {
+            oldLive.emplace_back(live[i]);
+        }
+        for (auto const& e : LedgerTestUtils::generateValidLedgerEntries(250))
+        {
+            oldLive.emplace_back(e);
+        }
+        newLive = LedgerTestUtils::generateValidLedgerEntries(250);
+        auto oldBucket = Bucket::fresh(bm, oldLive, {});
+        auto newBucket = Bucket::fresh(bm, newLive, {});
+
+        std::remove(BucketIndex::filenameFor(b->getFilename()).c_str());
+        auto unindexed =
+            std::make_shared<Bucket>(b->getFilename(), b->getHash());
+        REQUIRE(!unindexed->getIndex());
+
+        auto withIndex = Bucket::merge(bm, oldBucket, newBucket, {b});
+        auto withoutIndex =
+            Bucket::merge(bm, oldBucket, newBucket, {unindexed});
+        REQUIRE(withIndex->getHash() == withoutIndex->getHash());
+        REQUIRE(withIndex->countLiveAndDeadEntries().first == 500);
+    }
+}
+
+TEST_CASE("bucket merge scheduler", "[bucket][mergescheduler]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    app->start();
+
+    auto& sched = app->getBucketManager().getMergeScheduler();
+    uint32_t const deep = BucketMergeScheduler::FIRST_DEEP_LEVEL;
+    size_t const nSlots = sched.getMaxRunning();
+    size_t const nDeepSlots = sched.getMaxRunningDeep();
+    REQUIRE(nSlots >= 2);
+    REQUIRE(nDeepSlots == std::min(cfg.MAX_CONCURRENT_DEEP_MERGES, nSlots - 1));
+
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> deepRunning{0};
+    std::atomic<size_t> maxDeepRunning{0};
+
+    // However the test case exits, blocked merges must be let through and
+    // the merge threads joined before the locals above go away.
+    struct Finish
+    {
+        std::promise<void>& mGate;
+        BucketMergeScheduler& mSched;
+        bool mDone;
+        Finish(std::promise<void>& gate, BucketMergeScheduler& sched)
+            : mGate(gate), mSched(sched), mDone(false)
+        {
+        }
+        void
+        operator()()
+        {
+            if (!mDone)
+            {
+                mDone = true;
+                mGate.set_value();
+                mSched.shutdown();
+            }
+        }
+        ~Finish()
+        {
+            (*this)();
+        }
+    } finish(gate, sched);
+
+    // Merges are picked up by the merge threads, not by enqueue() itself.
+    auto waitUntil = [](std::function<bool()> cond) {
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!cond() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return cond();
+    };
+
+    size_t const nEach = 2 * nSlots;
+    for (size_t i = 0; i < nEach; ++i)
+    {
+        sched.enqueue(deep, [&]() {
+            size_t n = ++deepRunning;
+            size_t m = maxDeepRunning;
+            while (n > m && !maxDeepRunning.compare_exchange_weak(m, n))
+            {
+            }
+            open.wait();
+            --deepRunning;
+            ++done;
+        });
+    }
+    REQUIRE(waitUntil([&]() { return deepRunning == nDeepSlots; }));
+    REQUIRE(sched.getQueueDepth(deep) == nEach - nDeepSlots);
+    size_t expected = nEach;
+
+    SECTION("a shallow merge finishes while deep merges are blocked")
+    {
+        std::promise<void> shallow;
+        sched.enqueue(1, [&]() { shallow.set_value(); });
+        REQUIRE(shallow.get_future().wait_for(std::chrono::seconds(10)) ==
+                std::future_status::ready);
+        REQUIRE(deepRunning == nDeepSlots);
+        REQUIRE(done == 0);
+    }
+
+    SECTION("shallow merges take every thread deep merges cannot")
+    {
+        for (size_t i = 0; i < nEach; ++i)
+        {
+            sched.enqueue(1, [&]() {
+                open.wait();
+                ++done;
+            });
+        }
+        expected += nEach;
+        REQUIRE(waitUntil([&]() { return sched.getRunning() == nSlots; }));
+        REQUIRE(sched.getQueueDepth(1) == nEach - (nSlots - nDeepSlots));
+        REQUIRE(sched.getQueueDepth(deep) == nEach - nDeepSlots);
+    }
+
+    finish();
+
+    REQUIRE(done == expected);
+    REQUIRE(maxDeepRunning <= nDeepSlots);
+    REQUIRE(sched.getRunning() == 0);
+    REQUIRE(sched.getQueueDepth(1) == 0);
+    REQUIRE(sched.getQueueDepth(deep) == 0);
+    auto& queued =
+        app->getMetrics().NewCounter({"bucket", "merge-queue", "level-1"});
+    REQUIRE(queued.count() == 0);
+}
+
 TEST_CASE("bucket apply bench", "[bucketbench][hide]")
 {
     VirtualClock clock;
@@ -73,7 +73,7 @@ class FutureBucket
 
     void checkHashesMatch() const;
     void checkState() const;
-    void startMerge(Application& app, bool keepDeadEntries);
+    void startMerge(Application& app, uint32_t level);
 
     void clearInputs();
     void clearOutput();
@@ -83,7 +83,7 @@ class FutureBucket
     FutureBucket(Application& app, std::shared_ptr<Bucket> const& curr,
                  std::shared_ptr<Bucket> const& snap,
                  std::vector<std::shared_ptr<Bucket>> const& shadows,
-                 bool keepDeadEntries);
+                 uint32_t level);
 
     FutureBucket() = default;
     FutureBucket(FutureBucket const& other) = default;
@@ -114,8 +114,9 @@ class FutureBucket
     // Precondition: isLive(); waits-for and resolves to merged bucket.
     std::shared_ptr<Bucket> resolve();
 
-    // Precondition: !isLive(); transitions from FB_HASH_FOO to FB_LIVE_FOO
-    void makeLive(Application& app, bool keepDeadEntries);
+    // Precondition: !isLive(); transitions from FB_HASH_FOO to FB_LIVE_FOO,
+    // restarting the merge into BucketList level `level` if needed.
+    void makeLive(Application& app, uint32_t level);
 
     // Return all hashes referenced by this future.
     std::vector<std::string> getHashes() const;
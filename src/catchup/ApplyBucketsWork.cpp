@@ -20,6 +20,7 @@
 #include "main/Application.h"
 #include "util/format.h"
 #include "util/make_unique.h"
+#include <algorithm>
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
 
@@ -33,8 +34,8 @@ ApplyBucketsWork::ApplyBucketsWork(
     : Work(app, parent, std::string("apply-buckets"))
     , mBuckets(buckets)
     , mApplyState(applyState)
-    , mApplying(false)
-    , mLevel(BucketList::kNumLevels - 1)
+    , mPlanned(false)
+    , mNextToApply(0)
     , mBucketApplyStart(app.getMetrics().NewMeter(
           {"history", "bucket-apply", "start"}, "event"))
     , mBucketApplySuccess(app.getMetrics().NewMeter(
@@ -67,85 +68,104 @@ ApplyBucketsWork::getBucket(std::string const& hash)
 }
 
 void
-ApplyBucketsWork::onReset()
+ApplyBucketsWork::planApply()
 {
-    mLevel = BucketList::kNumLevels - 1;
-    mApplying = false;
-    mSnapBucket.reset();
-    mCurrBucket.reset();
-    mSnapApplicator.reset();
-    mCurrApplicator.reset();
+    mToApply.clear();
+    for (uint32_t level = BucketList::kNumLevels; level-- > 0;)
+    {
+        auto& local = getBucketLevel(level);
+        HistoryStateBucket const& i = mApplyState.currentBuckets.at(level);
+
+        bool applySnap = (i.snap != binToHex(local.getSnap()->getHash()));
+        bool applyCurr = (i.curr != binToHex(local.getCurr()->getHash()));
+        // once a level is applied, all the newer ones are as well
+        bool applying = !mToApply.empty();
+        if (applying || applySnap)
+        {
+            mToApply.emplace_back(level, false);
+        }
+        if (applying || applySnap || applyCurr)
+        {
+            mToApply.emplace_back(level, true);
+        }
+    }
+
+    if (mApp.getConfig().CATCHUP_APPLY_BUCKETS_NEWEST_FIRST)
+    {
+        std::reverse(mToApply.begin(), mToApply.end());
+        mAppliedKeys = make_unique<BucketApplyKeySet>();
+    }
+    mPlanned = true;
 }
 
 void
-ApplyBucketsWork::onStart()
+ApplyBucketsWork::deleteEntriesToReapply()
 {
-    auto& level = getBucketLevel(mLevel);
-    HistoryStateBucket const& i = mApplyState.currentBuckets.at(mLevel);
-
-    bool applySnap = (i.snap != binToHex(level.getSnap()->getHash()));
-    bool applyCurr = (i.curr != binToHex(level.getCurr()->getHash()));
-    if (!mApplying && (applySnap || applyCurr))
-    {
-        uint32_t oldestLedger = applySnap
-                                    ? BucketList::oldestLedgerInSnap(
-                                          mApplyState.currentLedger, mLevel)
-                                    : BucketList::oldestLedgerInCurr(
-                                          mApplyState.currentLedger, mLevel);
-        AccountFrame::deleteAccountsModifiedOnOrAfterLedger(mApp.getDatabase(),
-                                                            oldestLedger);
-        TrustFrame::deleteTrustLinesModifiedOnOrAfterLedger(mApp.getDatabase(),
-                                                            oldestLedger);
-        OfferFrame::deleteOffersModifiedOnOrAfterLedger(mApp.getDatabase(),
+    // everything from the oldest bucket applied on is written again
+    auto const& oldest = mAppliedKeys ? mToApply.back() : mToApply.front();
+    uint32_t oldestLedger =
+        oldest.second
+            ? BucketList::oldestLedgerInCurr(mApplyState.currentLedger,
+                                             oldest.first)
+            : BucketList::oldestLedgerInSnap(mApplyState.currentLedger,
+                                             oldest.first);
+    AccountFrame::deleteAccountsModifiedOnOrAfterLedger(mApp.getDatabase(),
                                                         oldestLedger);
-        DataFrame::deleteDataModifiedOnOrAfterLedger(mApp.getDatabase(),
-                                                     oldestLedger);
-    }
+    TrustFrame::deleteTrustLinesModifiedOnOrAfterLedger(mApp.getDatabase(),
+                                                        oldestLedger);
+    OfferFrame::deleteOffersModifiedOnOrAfterLedger(mApp.getDatabase(),
+                                                    oldestLedger);
+    DataFrame::deleteDataModifiedOnOrAfterLedger(mApp.getDatabase(),
+                                                 oldestLedger);
+}
 
-    if (mApplying || applySnap)
+void
+ApplyBucketsWork::onReset()
+{
+    mPlanned = false;
+    mToApply.clear();
+    mNextToApply = 0;
+    mBucket.reset();
+    mApplicator.reset();
+    mAppliedKeys.reset();
+}
+
+void
+ApplyBucketsWork::onStart()
+{
+    if (!mPlanned)
     {
-        mSnapBucket = getBucket(i.snap);
-        mSnapApplicator =
-            make_unique<BucketApplicator>(mApp.getDatabase(), mSnapBucket);
-        CLOG(DEBUG, "History") << "ApplyBuckets : starting level[" << mLevel
-                               << "].snap = " << i.snap;
-        mApplying = true;
-        mBucketApplyStart.Mark();
+        planApply();
+        if (!mToApply.empty())
+        {
+            deleteEntriesToReapply();
+        }
     }
-    if (mApplying || applyCurr)
+    if (mNextToApply == mToApply.size())
     {
-        mCurrBucket = getBucket(i.curr);
-        mCurrApplicator =
-            make_unique<BucketApplicator>(mApp.getDatabase(), mCurrBucket);
-        CLOG(DEBUG, "History") << "ApplyBuckets : starting level[" << mLevel
-                               << "].curr = " << i.curr;
-        mApplying = true;
-        mBucketApplyStart.Mark();
+        return;
     }
+
+    auto const& next = mToApply[mNextToApply];
+    HistoryStateBucket const& i = mApplyState.currentBuckets.at(next.first);
+    auto const& hash = next.second ? i.curr : i.snap;
+    mBucket = getBucket(hash);
+    mApplicator = make_unique<BucketApplicator>(mApp.getDatabase(), mBucket,
+                                                mAppliedKeys.get());
+    CLOG(DEBUG, "History") << "ApplyBuckets : starting level[" << next.first
+                           << "]." << (next.second ? "curr" : "snap") << " = "
+                           << hash;
+    mBucketApplyStart.Mark();
 }
 
 void
 ApplyBucketsWork::onRun()
 {
-    // The structure of these if statements is motivated by the following:
-    // 1. mCurrApplicator should never be advanced if mSnapApplicator is
-    //    not false. Otherwise it is possible for curr to modify the
-    //    database when the invariants for snap are checked.
-    // 2. There is no reason to advance mSnapApplicator or mCurrApplicator
-    //    if there is nothing to be applied.
-    if (mSnapApplicator)
+    // There is no reason to advance mApplicator if there is nothing to be
+    // applied.
+    if (mApplicator && *mApplicator)
     {
-        if (*mSnapApplicator)
-        {
-            mSnapApplicator->advance();
-        }
-    }
-    else if (mCurrApplicator)
-    {
-        if (*mCurrApplicator)
-        {
-            mCurrApplicator->advance();
-        }
+        mApplicator->advance();
     }
     scheduleSuccess();
 }
@@ -155,39 +175,38 @@ ApplyBucketsWork::onSuccess()
 {
     mApp.getCatchupManager().logAndUpdateCatchupStatus(true);
 
-    if (mSnapApplicator)
+    if (mApplicator)
     {
-        if (*mSnapApplicator)
+        if (*mApplicator)
         {
             return WORK_RUNNING;
         }
-        mApp.getInvariantManager().checkOnBucketApply(
-            mSnapBucket, mApplyState.currentLedger, mLevel, false);
-        mSnapApplicator.reset();
-        mSnapBucket.reset();
-        mBucketApplySuccess.Mark();
-    }
-    if (mCurrApplicator)
-    {
-        if (*mCurrApplicator)
+        // checking a bucket against the database only holds once all the
+        // older ones are applied
+        if (!mAppliedKeys)
         {
-            return WORK_RUNNING;
+            auto const& applied = mToApply[mNextToApply];
+            mApp.getInvariantManager().checkOnBucketApply(
+                mBucket, mApplyState.currentLedger, applied.first,
+                applied.second);
         }
-        mApp.getInvariantManager().checkOnBucketApply(
-            mCurrBucket, mApplyState.currentLedger, mLevel, true);
-        mCurrApplicator.reset();
-        mCurrBucket.reset();
+        mApplicator.reset();
+        mBucket.reset();
         mBucketApplySuccess.Mark();
+        ++mNextToApply;
     }
 
-    if (mLevel != 0)
+    if (mNextToApply != mToApply.size())
     {
-        --mLevel;
-        CLOG(DEBUG, "History")
-            << "ApplyBuckets : starting next level: " << mLevel;
+        CLOG(DEBUG, "History") << "ApplyBuckets : starting next bucket";
         return WORK_PENDING;
     }
 
+    if (mAppliedKeys)
+    {
+        CLOG(INFO, "History") << "ApplyBuckets : wrote "
+                              << mAppliedKeys->size() << " distinct entries";
+    }
     CLOG(DEBUG, "History") << "ApplyBuckets : done, restarting merges";
     mApp.getBucketManager().assumeState(mApplyState);
     return WORK_SUCCESS;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "work/Work.h"
+#include <vector>
 
 namespace medida
 {
@@ -15,6 +16,7 @@ namespace stellar
 {
 
 class BucketApplicator;
+class BucketApplyKeySet;
 class BucketLevel;
 class BucketList;
 class Bucket;
@@ -26,12 +28,18 @@ class ApplyBucketsWork : public Work
     std::map<std::string, std::shared_ptr<Bucket>> const& mBuckets;
     const HistoryArchiveState& mApplyState;
 
-    bool mApplying;
-    uint32_t mLevel;
-    std::shared_ptr<Bucket const> mSnapBucket;
-    std::shared_ptr<Bucket const> mCurrBucket;
-    std::unique_ptr<BucketApplicator> mSnapApplicator;
-    std::unique_ptr<BucketApplicator> mCurrApplicator;
+    // Buckets that differ from the local bucket list, as (level, isCurr), in
+    // the order they are applied: the deepest differing one and all the
+    // newer ones, oldest first unless CATCHUP_APPLY_BUCKETS_NEWEST_FIRST is
+    // set. Computed when the work first starts.
+    bool mPlanned;
+    std::vector<std::pair<uint32_t, bool>> mToApply;
+    size_t mNextToApply;
+
+    std::shared_ptr<Bucket const> mBucket;
+    std::unique_ptr<BucketApplicator> mApplicator;
+    // keys written so far when applying newest first
+    std::unique_ptr<BucketApplyKeySet> mAppliedKeys;
 
     medida::Meter& mBucketApplyStart;
     medida::Meter& mBucketApplySuccess;
@@ -39,6 +47,8 @@ class ApplyBucketsWork : public Work
 
     std::shared_ptr<Bucket const> getBucket(std::string const& bucketHash);
     BucketLevel& getBucketLevel(uint32_t level);
+    void planApply();
+    void deleteEntriesToReapply();
 
   public:
     ApplyBucketsWork(
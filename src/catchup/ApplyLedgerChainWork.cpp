@@ -90,8 +90,8 @@ ApplyLedgerChainWork::openCurrentInputFiles()
                            << hi.localPath_nogz();
     CLOG(DEBUG, "History") << "Replaying transactions from "
                            << ti.localPath_nogz();
-    mHdrIn.open(hi.localPath_nogz());
-    mTxIn.open(ti.localPath_nogz());
+    mHdrIn.openMapped(hi.localPath_nogz());
+    mTxIn.openMapped(ti.localPath_nogz());
     mTxHistoryEntry = TransactionHistoryEntry();
 }
 
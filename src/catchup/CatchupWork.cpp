@@ -4,8 +4,8 @@
 
 #include "catchup/CatchupWork.h"
 #include "catchup/ApplyBucketsWork.h"
-#include "catchup/ApplyLedgerChainWork.h"
 #include "catchup/CatchupConfiguration.h"
+#include "catchup/DownloadApplyTransactionsWork.h"
 #include "catchup/DownloadBucketsWork.h"
 #include "catchup/VerifyLedgerChainWork.h"
 #include "history/FileTransferInfo.h"
@@ -47,13 +47,9 @@ CatchupWork::getStatus() const
 {
     if (mState == WORK_PENDING)
     {
-        if (mApplyTransactionsWork)
+        if (mDownloadApplyTransactionsWork)
         {
-            return mApplyTransactionsWork->getStatus();
-        }
-        else if (mDownloadTransactionsWork)
-        {
-            return mDownloadTransactionsWork->getStatus();
+            return mDownloadApplyTransactionsWork->getStatus();
         }
         else if (mApplyBucketsWork)
         {
@@ -115,8 +111,7 @@ CatchupWork::onReset()
     mGetBucketsHistoryArchiveStateWork.reset();
     mDownloadBucketsWork.reset();
     mApplyBucketsWork.reset();
-    mDownloadTransactionsWork.reset();
-    mApplyTransactionsWork.reset();
+    mDownloadApplyTransactionsWork.reset();
 
     uint64_t sleepSeconds =
         mManualCatchup || (toCheckpoint == CatchupConfiguration::CURRENT)
@@ -265,37 +260,20 @@ CatchupWork::applyBuckets()
 }
 
 bool
-CatchupWork::downloadTransactions(CheckpointRange const& range)
+CatchupWork::downloadApplyTransactions(LedgerRange const& range)
 {
-    if (mDownloadTransactionsWork)
+    if (mDownloadApplyTransactionsWork)
     {
-        assert(mDownloadTransactionsWork->getState() == WORK_SUCCESS);
+        assert(mDownloadApplyTransactionsWork->getState() == WORK_SUCCESS);
         return false;
     }
 
-    CLOG(INFO, "History") << "Catchup downloading transactions for range ["
-                          << range.first() << ".." << range.last() << "]";
-
-    mDownloadTransactionsWork = addWork<BatchDownloadWork>(
-        range, HISTORY_FILE_TYPE_TRANSACTIONS, *mDownloadDir);
-
-    return true;
-}
-
-bool
-CatchupWork::applyTransactions(LedgerRange const& range)
-{
-    if (mApplyTransactionsWork)
-    {
-        assert(mApplyTransactionsWork->getState() == WORK_SUCCESS);
-        return false;
-    }
-
-    CLOG(INFO, "History") << "Catchup applying transactions for range ["
-                          << range.first() << ".." << range.last() << "]";
+    CLOG(INFO, "History")
+        << "Catchup downloading and applying transactions for range ["
+        << range.first() << ".." << range.last() << "]";
 
-    mApplyTransactionsWork =
-        addWork<ApplyLedgerChainWork>(*mDownloadDir, range, mLastApplied);
+    mDownloadApplyTransactionsWork = addWork<DownloadApplyTransactionsWork>(
+        *mDownloadDir, range, mLastApplied);
 
     return true;
 }
@@ -369,12 +347,7 @@ CatchupWork::onSuccess()
                               << checkpointRange.first() << " not needed";
     }
 
-    if (downloadTransactions(checkpointRange))
-    {
-        return WORK_PENDING;
-    }
-
-    if (applyTransactions(ledgerRange))
+    if (downloadApplyTransactions(ledgerRange))
     {
         return WORK_PENDING;
     }
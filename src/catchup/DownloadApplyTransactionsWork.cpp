@@ -0,0 +1,258 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "catchup/DownloadApplyTransactionsWork.h"
+#include "catchup/ApplyLedgerChainWork.h"
+#include "catchup/CatchupManager.h"
+#include "history/FileTransferInfo.h"
+#include "history/HistoryManager.h"
+#include "historywork/GetAndUnzipRemoteFileWork.h"
+#include "historywork/Progress.h"
+#include "ledger/LedgerManager.h"
+#include "lib/util/format.h"
+#include "main/Application.h"
+#include <algorithm>
+#include <cstdio>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+
+namespace stellar
+{
+
+DownloadApplyTransactionsWork::DownloadApplyTransactionsWork(
+    Application& app, WorkParent& parent, TmpDir const& downloadDir,
+    LedgerRange range, LedgerHeaderHistoryEntry& lastApplied)
+    : Work(app, parent,
+           fmt::format("download-apply-transactions-{:08x}-{:08x}",
+                       range.first(), range.last()))
+    , mDownloadDir(downloadDir)
+    , mRange(range)
+    , mCheckpoints(range, app.getHistoryManager())
+    , mLastApplied(lastApplied)
+    , mNextDownload(mCheckpoints.first())
+    , mNextApply(mCheckpoints.first())
+    , mDownloadCached(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "cached"}, "event"))
+    , mDownloadStart(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "start"}, "event"))
+    , mDownloadSuccess(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "success"}, "event"))
+    , mDownloadFailure(app.getMetrics().NewMeter(
+          {"history", "download-transactions", "failure"}, "event"))
+    , mApplySuccess(app.getMetrics().NewMeter(
+          {"history", "catchup-pipeline", "apply"}, "checkpoint"))
+    , mApplyStall(app.getMetrics().NewMeter(
+          {"history", "catchup-pipeline", "apply-stall"}, "checkpoint"))
+    , mDeleteApplied(app.getMetrics().NewMeter(
+          {"history", "catchup-pipeline", "delete"}, "checkpoint"))
+{
+}
+
+DownloadApplyTransactionsWork::~DownloadApplyTransactionsWork()
+{
+    clearChildren();
+}
+
+std::string
+DownloadApplyTransactionsWork::getStatus() const
+{
+    if (mState == WORK_RUNNING || mState == WORK_PENDING)
+    {
+        auto first = mCheckpoints.first();
+        auto last = mCheckpoints.last();
+        auto downloading = mNextDownload;
+        for (auto const& d : mDownloading)
+        {
+            downloading = std::min(downloading, d.second);
+        }
+        return fmt::format(
+            "{:s}, {:s}",
+            fmtProgress(mApp, "downloading transactions files", first, last,
+                        downloading),
+            fmtProgress(mApp, "applying checkpoint", first, last, mNextApply));
+    }
+    return Work::getStatus();
+}
+
+LedgerRange
+DownloadApplyTransactionsWork::applyRangeOf(uint32_t checkpoint) const
+{
+    auto freq = mApp.getHistoryManager().getCheckpointFrequency();
+    auto first = std::max(mRange.first(), checkpoint + 1 - freq);
+    auto last = std::min(mRange.last(), checkpoint);
+    return LedgerRange{first, last};
+}
+
+void
+DownloadApplyTransactionsWork::addDownloads()
+{
+    auto freq = mApp.getHistoryManager().getCheckpointFrequency();
+    uint64_t window = mApp.getConfig().CATCHUP_PIPELINE_WINDOW;
+    uint64_t limit = mNextApply + window * freq;
+    size_t nChildren = mApp.getConfig().MAX_CONCURRENT_SUBPROCESSES;
+
+    while (mNextDownload <= mCheckpoints.last() && mNextDownload <= limit &&
+           mDownloading.size() < nChildren)
+    {
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                            mNextDownload);
+        if (fs::exists(ft.localPath_nogz()))
+        {
+            CLOG(DEBUG, "History") << "already have transactions for "
+                                   << "checkpoint " << mNextDownload;
+            mDownloadCached.Mark();
+            mDownloaded.insert(mNextDownload);
+        }
+        else
+        {
+            CLOG(DEBUG, "History")
+                << "Downloading and unzipping transactions for checkpoint "
+                << mNextDownload;
+            auto getAndUnzip = addWork<GetAndUnzipRemoteFileWork>(ft);
+            mDownloading.insert(
+                std::make_pair(getAndUnzip->getUniqueName(), mNextDownload));
+            mDownloadStart.Mark();
+        }
+        mNextDownload += freq;
+    }
+}
+
+void
+DownloadApplyTransactionsWork::addApply()
+{
+    if (mApplyWork || mNextApply > mCheckpoints.last() ||
+        mDownloaded.find(mNextApply) == mDownloaded.end())
+    {
+        return;
+    }
+
+    auto range = applyRangeOf(mNextApply);
+    CLOG(DEBUG, "History") << "Applying transactions for range ["
+                           << range.first() << ".." << range.last() << "]";
+    mDownloaded.erase(mNextApply);
+    mApplyWork =
+        addWork<ApplyLedgerChainWork>(mDownloadDir, range, mLastApplied);
+}
+
+void
+DownloadApplyTransactionsWork::deleteApplied(uint32_t checkpoint)
+{
+    // a retry resumes from the checkpoint containing LCL and downloads it
+    // again if needed
+    FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_TRANSACTIONS,
+                        checkpoint);
+    std::remove(ft.localPath_gz().c_str());
+    if (std::remove(ft.localPath_nogz().c_str()) == 0)
+    {
+        mDeleteApplied.Mark();
+    }
+    else
+    {
+        CLOG(WARNING, "History") << "Failed to delete transactions file "
+                                 << ft.localPath_nogz();
+    }
+}
+
+void
+DownloadApplyTransactionsWork::onReset()
+{
+    clearChildren();
+    mDownloading.clear();
+    mDownloaded.clear();
+    mApplyWork.reset();
+
+    // a retry resumes from the checkpoint containing LCL, as everything
+    // before it has been applied already
+    auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
+    auto start = std::min(std::max(mRange.first(), lcl), mRange.last());
+    mNextApply = mApp.getHistoryManager().checkpointContainingLedger(start);
+    mNextDownload = mNextApply;
+
+    CLOG(INFO, "History") << "Downloading and applying transactions for range ["
+                          << start << ".." << mRange.last() << "] up to "
+                          << mApp.getConfig().CATCHUP_PIPELINE_WINDOW
+                          << " checkpoints ahead";
+    addDownloads();
+    addApply();
+}
+
+Work::State
+DownloadApplyTransactionsWork::onSuccess()
+{
+    // children are removed as they finish, so we only get here once the
+    // last checkpoint has been applied
+    assert(mNextApply > mCheckpoints.last());
+    return WORK_SUCCESS;
+}
+
+void
+DownloadApplyTransactionsWork::notify(std::string const& child)
+{
+    auto i = mChildren.find(child);
+    if (i == mChildren.end())
+    {
+        CLOG(WARNING, "Work") << "DownloadApplyTransactionsWork notified by "
+                                 "unknown child "
+                              << child;
+        return;
+    }
+
+    if (i->second != mApplyWork)
+    {
+        switch (i->second->getState())
+        {
+        case Work::WORK_FAILURE_RETRY:
+        case Work::WORK_FAILURE_FATAL:
+        case Work::WORK_FAILURE_RAISE:
+            mDownloadFailure.Mark();
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::vector<std::string> done;
+    for (auto const& c : mChildren)
+    {
+        if (c.second->getState() == WORK_SUCCESS)
+        {
+            done.push_back(c.first);
+        }
+    }
+    for (auto const& d : done)
+    {
+        auto work = mChildren[d];
+        mChildren.erase(d);
+        if (work == mApplyWork)
+        {
+            mApplySuccess.Mark();
+            mApplyWork.reset();
+            deleteApplied(mNextApply);
+            mNextApply += mApp.getHistoryManager().getCheckpointFrequency();
+            if (mNextApply <= mCheckpoints.last() &&
+                mDownloaded.find(mNextApply) == mDownloaded.end())
+            {
+                CLOG(DEBUG, "History") << "Applying waits for download of "
+                                       << "transactions for checkpoint "
+                                       << mNextApply;
+                mApplyStall.Mark();
+            }
+            continue;
+        }
+
+        auto checkpoint = mDownloading.find(d);
+        assert(checkpoint != mDownloading.end());
+        CLOG(DEBUG, "History") << "Finished download of transactions for "
+                               << "checkpoint " << checkpoint->second;
+        mDownloadSuccess.Mark();
+        mDownloaded.insert(checkpoint->second);
+        mDownloading.erase(checkpoint);
+    }
+
+    addDownloads();
+    addApply();
+    mApp.getCatchupManager().logAndUpdateCatchupStatus(true);
+    advance();
+}
+}
@@ -0,0 +1,82 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "ledger/CheckpointRange.h"
+#include "ledger/LedgerRange.h"
+#include "work/Work.h"
+#include "xdr/Stellar-ledger.h"
+#include <set>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+
+class TmpDir;
+
+/**
+ * Downloads and applies the transactions of a range of ledgers as a
+ * pipeline: while the transactions of one checkpoint are applied by an
+ * ApplyLedgerChainWork child, those of the following checkpoints are
+ * downloaded and decompressed by GetAndUnzipRemoteFileWork children.
+ *
+ * Downloads never run more than CATCHUP_PIPELINE_WINDOW checkpoints ahead of
+ * the checkpoint being applied, and no more than MAX_CONCURRENT_SUBPROCESSES
+ * of them run at a time. The transaction files of each checkpoint are
+ * deleted as soon as it is applied, so a long catchup holds at most a window
+ * of them in the download directory. Ledger header files for the whole range
+ * must already be downloaded and verified, as ApplyLedgerChainWork checks
+ * transactions against them.
+ *
+ * Contructor parameters are the same as for ApplyLedgerChainWork:
+ * * downloadDir - directory containing ledger files, transaction files are
+ * downloaded there
+ * * range - range of ledgers to apply
+ * * lastApplied - reference to last applied ledger header
+ */
+class DownloadApplyTransactionsWork : public Work
+{
+    TmpDir const& mDownloadDir;
+    LedgerRange mRange;
+    CheckpointRange mCheckpoints;
+    LedgerHeaderHistoryEntry& mLastApplied;
+
+    // next checkpoint to download, and downloads in flight by child name
+    uint32_t mNextDownload;
+    std::map<std::string, uint32_t> mDownloading;
+    std::set<uint32_t> mDownloaded;
+
+    // checkpoint being (or next to be) applied
+    uint32_t mNextApply;
+    std::shared_ptr<Work> mApplyWork;
+
+    medida::Meter& mDownloadCached;
+    medida::Meter& mDownloadStart;
+    medida::Meter& mDownloadSuccess;
+    medida::Meter& mDownloadFailure;
+    medida::Meter& mApplySuccess;
+    medida::Meter& mApplyStall;
+    medida::Meter& mDeleteApplied;
+
+    LedgerRange applyRangeOf(uint32_t checkpoint) const;
+    void addDownloads();
+    void addApply();
+    void deleteApplied(uint32_t checkpoint);
+
+  public:
+    DownloadApplyTransactionsWork(Application& app, WorkParent& parent,
+                                  TmpDir const& downloadDir, LedgerRange range,
+                                  LedgerHeaderHistoryEntry& lastApplied);
+    ~DownloadApplyTransactionsWork();
+    std::string getStatus() const override;
+    void onReset() override;
+    Work::State onSuccess() override;
+    void notify(std::string const& child) override;
+};
+}
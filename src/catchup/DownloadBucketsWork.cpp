@@ -58,7 +58,8 @@ DownloadBucketsWork::onReset()
 
         auto verify = addWork<VerifyBucketWork>(mBuckets, ft.localPath_nogz(),
                                                 hexToBin256(hash));
-        verify->addWork<GetAndUnzipRemoteFileWork>(ft);
+        verify->addWork<GetAndUnzipRemoteFileWork>(
+            ft, nullptr, Work::RETRY_A_LOT, verify->getDecompressedHashSink());
         mDownloadBucketStart.Mark();
     }
 }
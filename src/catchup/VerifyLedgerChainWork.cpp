@@ -2,6 +2,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "util/asio.h"
 #include "catchup/VerifyLedgerChainWork.h"
 #include "history/FileTransferInfo.h"
 #include "historywork/Progress.h"
@@ -11,15 +12,26 @@
 #include "util/XDRStream.h"
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
+#include <thread>
 
 namespace stellar
 {
 
+// number of checkpoint files each worker thread may have read and hashed
+// ahead of the one being linked
+static size_t const HASHED_AHEAD_PER_THREAD = 4;
+
+struct VerifyLedgerChainWork::HashedCheckpoint
+{
+    std::vector<LedgerHeaderHistoryEntry> mEntries;
+    std::vector<Hash> mHashes;
+    std::string mError;
+};
+
 static HistoryManager::VerifyHashStatus
-verifyLedgerHistoryEntry(LedgerHeaderHistoryEntry const& hhe)
+verifyLedgerHistoryEntry(LedgerHeaderHistoryEntry const& hhe,
+                         Hash const& calculated)
 {
-    LedgerHeaderFrame lFrame(hhe.header);
-    Hash calculated = lFrame.getHash();
     if (calculated != hhe.hash)
     {
         CLOG(ERROR, "History")
@@ -32,9 +44,11 @@ verifyLedgerHistoryEntry(LedgerHeaderHistoryEntry const& hhe)
 }
 
 static HistoryManager::VerifyHashStatus
-verifyLedgerHistoryLink(Hash const& prev, LedgerHeaderHistoryEntry const& curr)
+verifyLedgerHistoryLink(Hash const& prev, LedgerHeaderHistoryEntry const& curr,
+                        Hash const& calculated)
 {
-    if (verifyLedgerHistoryEntry(curr) != HistoryManager::VERIFY_HASH_OK)
+    if (verifyLedgerHistoryEntry(curr, calculated) !=
+        HistoryManager::VERIFY_HASH_OK)
     {
         return HistoryManager::VERIFY_HASH_BAD;
     }
@@ -62,6 +76,9 @@ VerifyLedgerChainWork::VerifyLedgerChainWork(
     , mManualCatchup(manualCatchup)
     , mFirstVerified(firstVerified)
     , mLastVerified(lastVerified)
+    , mNextToHash(mCurrCheckpoint)
+    , mHashing(0)
+    , mGeneration(0)
     , mVerifyLedgerSuccessOld(app.getMetrics().NewMeter(
           {"history", "verify-ledger", "success-old"}, "event"))
     , mVerifyLedgerSuccess(app.getMetrics().NewMeter(
@@ -114,6 +131,91 @@ VerifyLedgerChainWork::onReset()
     }
     mCurrCheckpoint =
         mApp.getHistoryManager().checkpointContainingLedger(mRange.first());
+
+    mHashed.clear();
+    mNextToHash = mCurrCheckpoint;
+    mHashing = 0;
+    mGeneration++;
+    mWaitingForHash = nullptr;
+}
+
+void
+VerifyLedgerChainWork::startHashing()
+{
+    auto& hm = mApp.getHistoryManager();
+    auto lastCheckpoint = hm.checkpointContainingLedger(mRange.last());
+    size_t limit = HASHED_AHEAD_PER_THREAD *
+                   std::max(1u, std::thread::hardware_concurrency());
+
+    while (mNextToHash <= lastCheckpoint && mHashing + mHashed.size() < limit)
+    {
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
+                            mNextToHash);
+        std::string path = ft.localPath_nogz();
+        uint32_t checkpoint = mNextToHash;
+        uint64_t generation = mGeneration;
+        Application& app = mApp;
+        std::weak_ptr<VerifyLedgerChainWork> weak(
+            std::static_pointer_cast<VerifyLedgerChainWork>(
+                shared_from_this()));
+
+        app.getWorkerIOService().post([&app, path, checkpoint, generation,
+                                       weak]() {
+            auto hashed = std::make_shared<HashedCheckpoint>();
+            try
+            {
+                XDRInputFileStream hdrIn;
+                hdrIn.openMapped(path);
+                LedgerHeaderHistoryEntry curr;
+                while (hdrIn && hdrIn.readOne(curr))
+                {
+                    hashed->mHashes.emplace_back(
+                        LedgerHeaderFrame(curr.header).getHash());
+                    hashed->mEntries.emplace_back(curr);
+                }
+            }
+            catch (std::exception const& e)
+            {
+                hashed->mError = e.what();
+            }
+
+            app.getClock().getIOService().post(
+                [checkpoint, generation, weak, hashed]() {
+                    auto self = weak.lock();
+                    if (!self || self->mGeneration != generation)
+                    {
+                        return;
+                    }
+                    self->mHashing--;
+                    self->mHashed[checkpoint] = hashed;
+                    self->startHashing();
+                    if (self->mWaitingForHash &&
+                        checkpoint == self->mCurrCheckpoint)
+                    {
+                        auto handler = self->mWaitingForHash;
+                        self->mWaitingForHash = nullptr;
+                        handler(asio::error_code{});
+                    }
+                });
+        });
+
+        mHashing++;
+        mNextToHash += hm.getCheckpointFrequency();
+    }
+}
+
+void
+VerifyLedgerChainWork::onRun()
+{
+    startHashing();
+    if (mHashed.find(mCurrCheckpoint) != mHashed.end())
+    {
+        scheduleSuccess();
+    }
+    else
+    {
+        mWaitingForHash = callComplete();
+    }
 }
 
 HistoryManager::VerifyHashStatus
@@ -121,8 +223,19 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
 {
     FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
                         mCurrCheckpoint);
-    XDRInputFileStream hdrIn;
-    hdrIn.open(ft.localPath_nogz());
+    auto hashedIt = mHashed.find(mCurrCheckpoint);
+    assert(hashedIt != mHashed.end());
+    auto hashed = hashedIt->second;
+    mHashed.erase(hashedIt);
+
+    if (!hashed->mError.empty())
+    {
+        CLOG(ERROR, "History") << "Unable to read ledger headers from "
+                               << ft.localPath_nogz() << ": "
+                               << hashed->mError;
+        mVerifyLedgerChainFailure.Mark();
+        return HistoryManager::VERIFY_HASH_BAD;
+    }
 
     LedgerHeaderHistoryEntry prev = mLastVerified;
     LedgerHeaderHistoryEntry curr;
@@ -131,8 +244,9 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
                            << ft.localPath_nogz() << " starting from ledger "
                            << LedgerManager::ledgerAbbrev(prev);
 
-    while (hdrIn && hdrIn.readOne(curr))
+    for (size_t i = 0; i < hashed->mEntries.size(); ++i)
     {
+        curr = hashed->mEntries[i];
         if (prev.header.ledgerSeq == 0)
         {
             // When we have no previous state to connect up with
@@ -160,7 +274,7 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
             mVerifyLedgerFailureOvershot.Mark();
             return HistoryManager::VERIFY_HASH_BAD;
         }
-        if (verifyLedgerHistoryLink(prev.hash, curr) !=
+        if (verifyLedgerHistoryLink(prev.hash, curr, hashed->mHashes[i]) !=
             HistoryManager::VERIFY_HASH_OK)
         {
             mVerifyLedgerFailureLink.Mark();
@@ -7,6 +7,8 @@
 #include "history/HistoryManager.h"
 #include "ledger/LedgerRange.h"
 #include "work/Work.h"
+#include <map>
+#include <memory>
 
 namespace medida
 {
@@ -19,8 +21,21 @@ namespace stellar
 class TmpDir;
 struct LedgerHeaderHistoryEntry;
 
+/**
+ * Verifies the hash chain of ledger headers stored in checkpoint files in
+ * downloadDir, and that its last ledger agrees with LedgerManager.
+ *
+ * Reading each file and hashing every header in it is done on worker
+ * threads, several checkpoints at a time and ahead of the one being checked.
+ * Checkpoints are then linked to each other in order on the main thread,
+ * which only compares hashes.
+ */
 class VerifyLedgerChainWork : public Work
 {
+    // headers of one checkpoint file and the hash of each, computed on a
+    // worker thread
+    struct HashedCheckpoint;
+
     TmpDir const& mDownloadDir;
     LedgerRange mRange;
     uint32_t mCurrCheckpoint;
@@ -28,6 +43,14 @@ class VerifyLedgerChainWork : public Work
     LedgerHeaderHistoryEntry& mFirstVerified;
     LedgerHeaderHistoryEntry& mLastVerified;
 
+    // checkpoints hashed (or being hashed) ahead of mCurrCheckpoint; results
+    // of work started before the last reset are dropped by generation
+    std::map<uint32_t, std::shared_ptr<HashedCheckpoint const>> mHashed;
+    uint32_t mNextToHash;
+    size_t mHashing;
+    uint64_t mGeneration;
+    std::function<void(asio::error_code const& ec)> mWaitingForHash;
+
     medida::Meter& mVerifyLedgerSuccessOld;
     medida::Meter& mVerifyLedgerSuccess;
     medida::Meter& mVerifyLedgerFailureOvershot;
@@ -36,6 +59,7 @@ class VerifyLedgerChainWork : public Work
     medida::Meter& mVerifyLedgerChainFailure;
     medida::Meter& mVerifyLedgerChainFailureEnd;
 
+    void startHashing();
     HistoryManager::VerifyHashStatus verifyHistoryOfSingleCheckpoint();
 
   public:
@@ -47,6 +71,7 @@ class VerifyLedgerChainWork : public Work
     ~VerifyLedgerChainWork();
     std::string getStatus() const override;
     void onReset() override;
+    void onRun() override;
     Work::State onSuccess() override;
 };
 }
@@ -12,10 +12,12 @@
 #include "test/test.h"
 #include "util/Logging.h"
 #include "util/basen.h"
+#include <atomic>
 #include <autocheck/autocheck.hpp>
 #include <map>
 #include <regex>
 #include <sodium.h>
+#include <thread>
 
 using namespace stellar;
 
@@ -180,6 +182,113 @@ struct SignVerifyTestcase
     }
 };
 
+TEST_CASE("verify cache shared across threads", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    size_t const n = 64;
+    size_t const nThreads = 4;
+    std::vector<SignVerifyTestcase> cases;
+    for (size_t i = 0; i < n; ++i)
+    {
+        cases.push_back(SignVerifyTestcase::create());
+        cases.back().sign();
+        if (i % 2 == 1)
+        {
+            cases.back().sig[0] ^= 1;
+        }
+    }
+
+    // catch assertions are not thread safe, so tally failures instead
+    std::atomic<size_t> wrong{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nThreads; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (size_t i = 0; i < n; ++i)
+            {
+                auto const& c = cases[i];
+                if (PubKeyUtils::verifySig(c.pub, c.sig, c.msg) != (i % 2 == 0))
+                {
+                    ++wrong;
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    REQUIRE(wrong == 0);
+
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(hits + misses == n * nThreads);
+    REQUIRE(misses >= n);
+
+    // every result, good or bad, is now cached
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto const& c = cases[i];
+        REQUIRE(PubKeyUtils::verifySig(c.pub, c.sig, c.msg) == (i % 2 == 0));
+    }
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(hits == n);
+    REQUIRE(misses == 0);
+}
+
+TEST_CASE("cached multi-signature verify", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    std::vector<SignVerifyTestcase> cases;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        cases.push_back(SignVerifyTestcase::create());
+        cases.back().sign();
+    }
+    cases[3].sig[10] ^= 1;
+    cases[7].sig.resize(10);
+
+    std::vector<PubKeyUtils::VerifySigItem> items;
+    for (auto const& c : cases)
+    {
+        items.push_back({c.pub, c.sig, c.msg});
+    }
+    // repeated triples are verified once
+    items.push_back({cases[0].pub, cases[0].sig, cases[0].msg});
+    items.push_back({cases[3].pub, cases[3].sig, cases[3].msg});
+    // a valid signature under the wrong key
+    items.push_back({cases[1].pub, cases[2].sig, cases[2].msg});
+
+    auto res = PubKeyUtils::verifySigsCached(items);
+    REQUIRE(res.size() == items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        auto const& item = items[i];
+        REQUIRE(res[i] ==
+                PubKeyUtils::verifySig(item.mKey, item.mSignature, item.mBin));
+    }
+    REQUIRE(res[0]);
+    REQUIRE(!res[3]);
+    REQUIRE(!res[7]);
+    REQUIRE(res[cases.size()]);
+    REQUIRE(!res[cases.size() + 2]);
+
+    // the call filled the cache: the single checks above were all hits,
+    // and so is a second call
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(misses == items.size() - 1);
+    REQUIRE(hits == items.size() - 1);
+    PubKeyUtils::verifySigsCached(items);
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(hits == items.size() - 1);
+    REQUIRE(misses == 0);
+}
+
 TEST_CASE("sign and verify benchmarking", "[crypto-bench][bench][hide]")
 {
     size_t n = 100000;
@@ -5,17 +5,21 @@
 #include "crypto/SecretKey.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
-#include "crypto/SHA.h"
 #include "crypto/StrKey.h"
 #include "main/Config.h"
 #include "transactions/SignatureUtils.h"
 #include "util/HashOfHash.h"
 #include "util/lrucache.hpp"
 #include "util/make_unique.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <sodium.h>
 #include <type_traits>
+#include <unordered_map>
 
 namespace stellar
 {
@@ -26,12 +30,179 @@ namespace stellar
 // to the state of the process; caching its results centrally
 // makes all signature-verification in the program faster and
 // has no effect on correctness.
+//
+// The cache is split into shards, each with its own lock, selected by the
+// cache key. Cache keys are hashed with per-call state, so concurrent
+// verifiers on worker threads only contend when they land on the same
+// shard.
+
+namespace
+{
+class VerifySigCache
+{
+    static size_t const NUM_SHARDS = 64;
+
+    struct Shard
+    {
+        std::mutex mMutex;
+        cache::lru_cache<Hash, bool> mCache{0};
+    };
+
+    std::array<Shard, NUM_SHARDS> mShards;
+    std::atomic<uint64_t> mHits{0};
+    std::atomic<uint64_t> mMisses{0};
+    std::mutex mSizeMutex;
+    size_t mMaxSize{0};
+
+    static size_t
+    shardIndex(Hash const& key)
+    {
+        // the key is a cryptographic hash, so any of its bytes will do
+        size_t n = 0;
+        std::memcpy(&n, key.data(), sizeof(n));
+        return n % NUM_SHARDS;
+    }
+
+    Shard&
+    shardFor(Hash const& key)
+    {
+        return mShards[shardIndex(key)];
+    }
+
+    // Order `n` items by the shard of `keyOf(i)`, so that a batch can take
+    // each shard's lock once.
+    template <typename F>
+    static std::vector<std::pair<size_t, size_t>>
+    groupByShard(size_t n, F keyOf)
+    {
+        std::vector<std::pair<size_t, size_t>> res;
+        res.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            res.emplace_back(shardIndex(keyOf(i)), i);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+  public:
+    VerifySigCache()
+    {
+        setMaxSize(0xffff);
+    }
+
+    void
+    setMaxSize(size_t maxSize)
+    {
+        std::lock_guard<std::mutex> sizeGuard(mSizeMutex);
+        if (maxSize == mMaxSize)
+        {
+            return;
+        }
+        mMaxSize = maxSize;
+        size_t perShard = std::max<size_t>(
+            1, (maxSize + NUM_SHARDS - 1) / NUM_SHARDS);
+        for (auto& s : mShards)
+        {
+            std::lock_guard<std::mutex> guard(s.mMutex);
+            s.mCache = cache::lru_cache<Hash, bool>(perShard);
+        }
+    }
+
+    bool
+    get(Hash const& key, bool& ok)
+    {
+        auto& s = shardFor(key);
+        {
+            std::lock_guard<std::mutex> guard(s.mMutex);
+            if (s.mCache.exists(key))
+            {
+                ok = s.mCache.get(key);
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void
+    put(Hash const& key, bool ok)
+    {
+        auto& s = shardFor(key);
+        std::lock_guard<std::mutex> guard(s.mMutex);
+        s.mCache.put(key, ok);
+    }
+
+    // Look up a batch of keys, setting `res[i]` to 1 or 0 for a cached
+    // result and leaving it untouched on a miss.
+    void
+    getMany(std::vector<Hash> const& keys, std::vector<int>& res)
+    {
+        auto order = groupByShard(
+            keys.size(), [&](size_t i) -> Hash const& { return keys[i]; });
+        uint64_t hits = 0;
+        for (size_t i = 0; i < order.size();)
+        {
+            auto& s = mShards[order[i].first];
+            std::lock_guard<std::mutex> guard(s.mMutex);
+            for (size_t shard = order[i].first;
+                 i < order.size() && order[i].first == shard; ++i)
+            {
+                auto const& key = keys[order[i].second];
+                if (s.mCache.exists(key))
+                {
+                    res[order[i].second] = s.mCache.get(key) ? 1 : 0;
+                    ++hits;
+                }
+            }
+        }
+        mHits.fetch_add(hits, std::memory_order_relaxed);
+        mMisses.fetch_add(keys.size() - hits, std::memory_order_relaxed);
+    }
 
-static std::mutex gVerifySigCacheMutex;
-static cache::lru_cache<Hash, bool> gVerifySigCache(0xffff);
-static std::unique_ptr<SHA256> gHasher = SHA256::create();
-static uint64_t gVerifyCacheHit = 0;
-static uint64_t gVerifyCacheMiss = 0;
+    void
+    putMany(std::vector<std::pair<Hash, bool>> const& results)
+    {
+        auto order =
+            groupByShard(results.size(), [&](size_t i) -> Hash const& {
+                return results[i].first;
+            });
+        for (size_t i = 0; i < order.size();)
+        {
+            auto& s = mShards[order[i].first];
+            std::lock_guard<std::mutex> guard(s.mMutex);
+            for (size_t shard = order[i].first;
+                 i < order.size() && order[i].first == shard; ++i)
+            {
+                auto const& r = results[order[i].second];
+                s.mCache.put(r.first, r.second);
+            }
+        }
+    }
+
+    void
+    clear()
+    {
+        for (auto& s : mShards)
+        {
+            std::lock_guard<std::mutex> guard(s.mMutex);
+            s.mCache.clear();
+        }
+    }
+
+    void
+    flushCounts(uint64_t& hits, uint64_t& misses)
+    {
+        hits = mHits.exchange(0, std::memory_order_relaxed);
+        misses = mMisses.exchange(0, std::memory_order_relaxed);
+    }
+};
+
+size_t const VerifySigCache::NUM_SHARDS;
+}
+
+static VerifySigCache gVerifySigCache;
 
 static Hash
 verifySigCacheKey(PublicKey const& key, Signature const& signature,
@@ -39,11 +210,15 @@ verifySigCacheKey(PublicKey const& key, Signature const& signature,
 {
     assert(key.type() == PUBLIC_KEY_TYPE_ED25519);
 
-    gHasher->reset();
-    gHasher->add(key.ed25519());
-    gHasher->add(signature);
-    gHasher->add(bin);
-    return gHasher->finish();
+    Hash res;
+    crypto_generichash_state state;
+    crypto_generichash_init(&state, nullptr, 0, res.size());
+    crypto_generichash_update(&state, key.ed25519().data(),
+                              key.ed25519().size());
+    crypto_generichash_update(&state, signature.data(), signature.size());
+    crypto_generichash_update(&state, bin.data(), bin.size());
+    crypto_generichash_final(&state, res.data(), res.size());
+    return res;
 }
 
 SecretKey::SecretKey() : mKeyType(PUBLIC_KEY_TYPE_ED25519)
@@ -198,18 +373,19 @@ SecretKey::fromStrKeySeed(std::string const& strKeySeed)
 void
 PubKeyUtils::clearVerifySigCache()
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
     gVerifySigCache.clear();
 }
 
+void
+PubKeyUtils::setVerifySigCacheSize(size_t maxSize)
+{
+    gVerifySigCache.setMaxSize(maxSize);
+}
+
 void
 PubKeyUtils::flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses)
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    hits = gVerifyCacheHit;
-    misses = gVerifyCacheMiss;
-    gVerifyCacheHit = 0;
-    gVerifyCacheMiss = 0;
+    gVerifySigCache.flushCounts(hits, misses);
 }
 
 std::string
@@ -291,24 +467,70 @@ PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
 
     auto cacheKey = verifySigCacheKey(key, signature, bin);
 
+    bool ok;
+    if (gVerifySigCache.get(cacheKey, ok))
     {
-        std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-        if (gVerifySigCache.exists(cacheKey))
-        {
-            ++gVerifyCacheHit;
-            return gVerifySigCache.get(cacheKey);
-        }
+        return ok;
     }
 
-    ++gVerifyCacheMiss;
-    bool ok =
-        (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
-                                     key.ed25519().data()) == 0);
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
+    ok = (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
+                                      key.ed25519().data()) == 0);
     gVerifySigCache.put(cacheKey, ok);
     return ok;
 }
 
+std::vector<bool>
+PubKeyUtils::verifySigsCached(std::vector<VerifySigItem> const& items)
+{
+    std::vector<bool> res(items.size(), false);
+
+    // cache keys of the well-formed items, and where they came from
+    std::vector<Hash> keys;
+    std::vector<size_t> itemIndex;
+    keys.reserve(items.size());
+    itemIndex.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        auto const& item = items[i];
+        assert(item.mKey.type() == PUBLIC_KEY_TYPE_ED25519);
+        if (item.mSignature.size() != 64)
+        {
+            continue;
+        }
+        keys.emplace_back(
+            verifySigCacheKey(item.mKey, item.mSignature, item.mBin));
+        itemIndex.emplace_back(i);
+    }
+
+    std::vector<int> cached(keys.size(), -1);
+    gVerifySigCache.getMany(keys, cached);
+
+    // verify each distinct miss once, even if it repeats in the batch
+    std::unordered_map<Hash, bool> verified;
+    for (size_t j = 0; j < keys.size(); ++j)
+    {
+        auto const& item = items[itemIndex[j]];
+        if (cached[j] >= 0)
+        {
+            res[itemIndex[j]] = (cached[j] == 1);
+            continue;
+        }
+        auto it = verified.find(keys[j]);
+        if (it == verified.end())
+        {
+            bool ok = (crypto_sign_verify_detached(
+                           item.mSignature.data(), item.mBin.data(),
+                           item.mBin.size(), item.mKey.ed25519().data()) == 0);
+            it = verified.emplace(keys[j], ok).first;
+        }
+        res[itemIndex[j]] = it->second;
+    }
+
+    gVerifySigCache.putMany(
+        std::vector<std::pair<Hash, bool>>(verified.begin(), verified.end()));
+    return res;
+}
+
 PublicKey
 PubKeyUtils::random()
 {
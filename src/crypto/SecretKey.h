@@ -4,19 +4,20 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/ByteSlice.h"
 #include "crypto/KeyUtils.h"
 #include "xdr/Stellar-types.h"
 
 #include <array>
 #include <functional>
 #include <ostream>
+#include <vector>
 
 namespace stellar
 {
 
 using xdr::operator==;
 
-class ByteSlice;
 struct SecretValue;
 struct SignerKey;
 
@@ -101,7 +102,27 @@ namespace PubKeyUtils
 bool verifySig(PublicKey const& key, Signature const& signature,
                ByteSlice const& bin);
 
+// One (key, signature, message) triple for verifySigsCached. It refers to the
+// data it was built from, which must outlive it.
+struct VerifySigItem
+{
+    PublicKey const& mKey;
+    Signature const& mSignature;
+    ByteSlice mBin;
+};
+
+// Return, for each item, whether its signature is valid. Equivalent to
+// calling verifySig on every item, but probes and fills the verify cache
+// one shard lock at a time and verifies repeated triples only once.
+// This batches cache locking, not cryptography: libsodium has no Ed25519
+// batch verifier, so every triple missing from the cache is still checked
+// on its own and the cost per miss is that of verifySig.
+std::vector<bool> verifySigsCached(std::vector<VerifySigItem> const& items);
+
 void clearVerifySigCache();
+// Set the number of results the process-wide verify cache holds; this
+// clears the cache if the size changes.
+void setVerifySigCacheSize(size_t maxSize);
 void flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses);
 
 PublicKey random();
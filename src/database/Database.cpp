@@ -81,7 +81,8 @@ Database::Database(Application& app)
           app.getMetrics().NewMeter({"database", "query", "exec"}, "query"))
     , mStatementsSize(
           app.getMetrics().NewCounter({"database", "memory", "statements"}))
-    , mEntryCache(4096)
+    , mEntryCache(app.getMetrics(), app.getConfig().ENTRY_CACHE_SIZE)
+    , mOrderBook(app.getMetrics(), app.getConfig().ORDER_BOOK_CACHE_SIZE)
     , mExcludedQueryTime(0)
     , mExcludedTotalTime(0)
     , mLastIdleQueryTime(0)
@@ -242,6 +243,16 @@ Database::getUpdateTimer(std::string const& entityName)
         .TimeScope();
 }
 
+medida::TimerContext
+Database::getUpsertTimer(std::string const& entityName)
+{
+    mEntityTypes.insert(entityName);
+    mQueryMeter.Mark();
+    return mApp.getMetrics()
+        .NewTimer({"database", "upsert", entityName})
+        .TimeScope();
+}
+
 void
 Database::setCurrentTransactionReadOnly()
 {
@@ -341,12 +352,18 @@ Database::getPool()
     return *mPool;
 }
 
-cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>&
+EntryCache&
 Database::getEntryCache()
 {
     return mEntryCache;
 }
 
+OrderBook&
+Database::getOrderBook()
+{
+    return mOrderBook;
+}
+
 class SQLLogContext : NonCopyable
 {
     std::string mName;
@@ -419,7 +436,8 @@ Database::getQueryMeter()
 std::chrono::nanoseconds
 Database::totalQueryTime() const
 {
-    std::vector<std::string> qtypes = {"insert", "delete", "select", "update"};
+    std::vector<std::string> qtypes = {"insert", "delete", "select", "update",
+                                       "upsert"};
     std::chrono::nanoseconds nsq(0);
     for (auto const& q : qtypes)
     {
@@ -475,6 +493,38 @@ Database::recentIdleDbPercent()
     return idlePercent;
 }
 
+std::string
+toPostgresArray(std::vector<std::string> const& values,
+                std::vector<soci::indicator> const* indicators)
+{
+    assert(!indicators || indicators->size() == values.size());
+    std::string res("{");
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i != 0)
+        {
+            res += ',';
+        }
+        if (indicators && (*indicators)[i] == soci::i_null)
+        {
+            res += "NULL";
+            continue;
+        }
+        res += '"';
+        for (char c : values[i])
+        {
+            if (c == '"' || c == '\\')
+            {
+                res += '\\';
+            }
+            res += c;
+        }
+        res += '"';
+    }
+    res += '}';
+    return res;
+}
+
 DBTimeExcluder::DBTimeExcluder(Application& app)
     : mApp(app)
     , mStartQueryTime(app.getDatabase().totalQueryTime())
@@ -4,14 +4,16 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "database/EntryCache.h"
+#include "ledger/OrderBook.h"
 #include "medida/timer_context.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/SociNoWarnings.h"
 #include "util/Timer.h"
-#include "util/lrucache.hpp"
 #include <set>
 #include <string>
+#include <vector>
 
 namespace medida
 {
@@ -92,8 +94,8 @@ class Database : NonMovableOrCopyable
     std::map<std::string, std::shared_ptr<soci::statement>> mStatements;
     medida::Counter& mStatementsSize;
 
-    cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>
-        mEntryCache;
+    EntryCache mEntryCache;
+    OrderBook mOrderBook;
 
     // Helpers for maintaining the total query time and calculating
     // idle percentage.
@@ -153,6 +155,7 @@ class Database : NonMovableOrCopyable
     medida::TimerContext getSelectTimer(std::string const& entityName);
     medida::TimerContext getDeleteTimer(std::string const& entityName);
     medida::TimerContext getUpdateTimer(std::string const& entityName);
+    medida::TimerContext getUpsertTimer(std::string const& entityName);
 
     // If possible (i.e. "on postgres") issue an SQL pragma that marks
     // the current transaction as read-only. The effects of this last
@@ -192,11 +195,38 @@ class Database : NonMovableOrCopyable
     // Access the LedgerEntry cache. Note: clients are responsible for
     // invalidating entries in this cache as they perform statements
     // against the database. It's kept here only for ease of access.
-    typedef cache::lru_cache<std::string, std::shared_ptr<LedgerEntry const>>
-        EntryCache;
     EntryCache& getEntryCache();
+
+    // Access the in-memory order book. Like the entry cache, clients that
+    // write to the offers table are responsible for keeping it in sync.
+    OrderBook& getOrderBook();
 };
 
+// Render a column of values as a PostgreSQL array literal, so that a bulk
+// statement can bind the whole column as a single parameter and expand it
+// server-side with unnest(). Strings whose indicator is soci::i_null are
+// rendered as SQL NULL.
+std::string toPostgresArray(std::vector<std::string> const& values,
+                            std::vector<soci::indicator> const* indicators =
+                                nullptr);
+
+template <typename T>
+std::string
+toPostgresArray(std::vector<T> const& values)
+{
+    std::string res("{");
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i != 0)
+        {
+            res += ',';
+        }
+        res += std::to_string(values[i]);
+    }
+    res += '}';
+    return res;
+}
+
 class DBTimeExcluder : NonCopyable
 {
     Application& mApp;
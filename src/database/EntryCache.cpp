@@ -0,0 +1,558 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/EntryCache.h"
+#include "util/make_unique.h"
+#include "xdrpp/marshal.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <sodium.h>
+#include <stdexcept>
+
+namespace stellar
+{
+
+static size_t const MAX_SHARDS = 16;
+static size_t const MIN_SHARD_SIZE = 256;
+static size_t const NUM_ENTRY_TYPES = 4;
+
+class EntryCache::Shard : NonMovableOrCopyable
+{
+    static uint32_t const NIL = 0xffffffff;
+
+    struct Node
+    {
+        Digest mDigest;
+        EntryPtr mEntry;
+        LedgerEntryType mType;
+        uint32_t mPrev;
+        uint32_t mNext;
+
+        // Membership in the (type, lastModified) index; only non-null
+        // entries are indexed.
+        bool mIndexed;
+        uint32_t mLastModified;
+        uint32_t mIdxPrev;
+        uint32_t mIdxNext;
+    };
+
+    // Nodes live contiguously and are referred to by index; freed indices
+    // are recycled through mFreeNodes.
+    std::vector<Node> mNodes;
+    std::vector<uint32_t> mFreeNodes;
+
+    // Open-addressed slot table holding node indices, kept at most half full
+    // so that linear probes stay short.
+    std::vector<uint32_t> mSlots;
+    size_t mSlotMask;
+
+    // LRU list threaded through the nodes: head is most recently used.
+    uint32_t mHead;
+    uint32_t mTail;
+
+    // Secondary index: for each entry type, lastModifiedLedgerSeq -> head
+    // of a list of nodes threaded through mIdxPrev / mIdxNext. Lets range
+    // invalidation visit only the entries it removes.
+    std::vector<std::map<uint32_t, uint32_t>> mByLedger;
+
+    size_t mSize;
+    size_t const mMaxSize;
+
+    size_t
+    findSlot(Digest const& d) const
+    {
+        size_t i = d.mLo & mSlotMask;
+        for (;;)
+        {
+            uint32_t n = mSlots[i];
+            if (n == NIL || mNodes[n].mDigest == d)
+            {
+                return i;
+            }
+            i = (i + 1) & mSlotMask;
+        }
+    }
+
+    void
+    eraseSlot(size_t i)
+    {
+        // Backward-shift deletion: pull forward any later entry of the probe
+        // run that would otherwise become unreachable through the hole at i.
+        size_t j = i;
+        for (;;)
+        {
+            j = (j + 1) & mSlotMask;
+            uint32_t n = mSlots[j];
+            if (n == NIL)
+            {
+                break;
+            }
+            size_t k = mNodes[n].mDigest.mLo & mSlotMask;
+            bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!stays)
+            {
+                mSlots[i] = n;
+                i = j;
+            }
+        }
+        mSlots[i] = NIL;
+    }
+
+    void
+    unlink(uint32_t n)
+    {
+        auto& node = mNodes[n];
+        if (node.mPrev != NIL)
+        {
+            mNodes[node.mPrev].mNext = node.mNext;
+        }
+        else
+        {
+            mHead = node.mNext;
+        }
+        if (node.mNext != NIL)
+        {
+            mNodes[node.mNext].mPrev = node.mPrev;
+        }
+        else
+        {
+            mTail = node.mPrev;
+        }
+        node.mPrev = node.mNext = NIL;
+    }
+
+    void
+    pushFront(uint32_t n)
+    {
+        auto& node = mNodes[n];
+        node.mPrev = NIL;
+        node.mNext = mHead;
+        if (mHead != NIL)
+        {
+            mNodes[mHead].mPrev = n;
+        }
+        mHead = n;
+        if (mTail == NIL)
+        {
+            mTail = n;
+        }
+    }
+
+    void
+    indexLink(uint32_t n)
+    {
+        auto& node = mNodes[n];
+        assert(!node.mIndexed);
+        if (!node.mEntry)
+        {
+            return;
+        }
+        node.mLastModified = node.mEntry->lastModifiedLedgerSeq;
+        auto& idx = mByLedger.at(node.mType);
+        auto it = idx.find(node.mLastModified);
+        node.mIdxPrev = NIL;
+        if (it == idx.end())
+        {
+            node.mIdxNext = NIL;
+            idx.emplace(node.mLastModified, n);
+        }
+        else
+        {
+            node.mIdxNext = it->second;
+            mNodes[it->second].mIdxPrev = n;
+            it->second = n;
+        }
+        node.mIndexed = true;
+    }
+
+    void
+    indexUnlink(uint32_t n)
+    {
+        auto& node = mNodes[n];
+        if (!node.mIndexed)
+        {
+            return;
+        }
+        if (node.mIdxPrev != NIL)
+        {
+            mNodes[node.mIdxPrev].mIdxNext = node.mIdxNext;
+        }
+        else
+        {
+            auto& idx = mByLedger.at(node.mType);
+            if (node.mIdxNext != NIL)
+            {
+                idx[node.mLastModified] = node.mIdxNext;
+            }
+            else
+            {
+                idx.erase(node.mLastModified);
+            }
+        }
+        if (node.mIdxNext != NIL)
+        {
+            mNodes[node.mIdxNext].mIdxPrev = node.mIdxPrev;
+        }
+        node.mIdxPrev = node.mIdxNext = NIL;
+        node.mIndexed = false;
+    }
+
+    void
+    removeNode(uint32_t n, size_t slot)
+    {
+        eraseSlot(slot);
+        unlink(n);
+        indexUnlink(n);
+        mNodes[n].mEntry.reset();
+        mFreeNodes.push_back(n);
+        --mSize;
+    }
+
+  public:
+    explicit Shard(size_t maxSize)
+        : mHead(NIL)
+        , mTail(NIL)
+        , mByLedger(NUM_ENTRY_TYPES)
+        , mSize(0)
+        , mMaxSize(maxSize)
+    {
+        size_t nSlots = 16;
+        while (nSlots < 2 * maxSize)
+        {
+            nSlots <<= 1;
+        }
+        mSlots.assign(nSlots, NIL);
+        mSlotMask = nSlots - 1;
+    }
+
+    bool
+    get(Digest const& d, EntryPtr& entry)
+    {
+        uint32_t n = mSlots[findSlot(d)];
+        if (n == NIL)
+        {
+            return false;
+        }
+        if (n != mHead)
+        {
+            unlink(n);
+            pushFront(n);
+        }
+        entry = mNodes[n].mEntry;
+        return true;
+    }
+
+    bool
+    exists(Digest const& d) const
+    {
+        return mSlots[findSlot(d)] != NIL;
+    }
+
+    // Returns true if an entry had to be evicted to make room, in which case
+    // `evictedType` is set to its type.
+    bool
+    put(Digest const& d, LedgerEntryType type, EntryPtr entry,
+        LedgerEntryType& evictedType)
+    {
+        size_t slot = findSlot(d);
+        uint32_t n = mSlots[slot];
+        if (n != NIL)
+        {
+            indexUnlink(n);
+            mNodes[n].mEntry = std::move(entry);
+            mNodes[n].mType = type;
+            indexLink(n);
+            if (n != mHead)
+            {
+                unlink(n);
+                pushFront(n);
+            }
+            return false;
+        }
+
+        bool evicted = false;
+        if (mSize >= mMaxSize)
+        {
+            uint32_t victim = mTail;
+            evictedType = mNodes[victim].mType;
+            removeNode(victim, findSlot(mNodes[victim].mDigest));
+            // The backward shift may have moved our insertion point.
+            slot = findSlot(d);
+            evicted = true;
+        }
+
+        if (mFreeNodes.empty())
+        {
+            n = static_cast<uint32_t>(mNodes.size());
+            mNodes.emplace_back();
+        }
+        else
+        {
+            n = mFreeNodes.back();
+            mFreeNodes.pop_back();
+        }
+        auto& node = mNodes[n];
+        node.mDigest = d;
+        node.mEntry = std::move(entry);
+        node.mType = type;
+        node.mIndexed = false;
+        indexLink(n);
+        mSlots[slot] = n;
+        pushFront(n);
+        ++mSize;
+        return evicted;
+    }
+
+    void
+    erase(Digest const& d)
+    {
+        size_t slot = findSlot(d);
+        uint32_t n = mSlots[slot];
+        if (n != NIL)
+        {
+            removeNode(n, slot);
+        }
+    }
+
+    void
+    eraseIf(std::function<bool(EntryPtr const&)> const& f)
+    {
+        uint32_t n = mHead;
+        while (n != NIL)
+        {
+            uint32_t next = mNodes[n].mNext;
+            if (f(mNodes[n].mEntry))
+            {
+                removeNode(n, findSlot(mNodes[n].mDigest));
+            }
+            n = next;
+        }
+    }
+
+    // Remove every non-null entry of `type` last modified at or after
+    // `ledgerSeq`, returning the number removed.
+    size_t
+    eraseModifiedOnOrAfter(LedgerEntryType type, uint32_t ledgerSeq)
+    {
+        size_t removed = 0;
+        auto& idx = mByLedger.at(type);
+        auto it = idx.lower_bound(ledgerSeq);
+        while (it != idx.end())
+        {
+            // Detach the whole per-ledger list before walking it.
+            uint32_t n = it->second;
+            it = idx.erase(it);
+            while (n != NIL)
+            {
+                auto& node = mNodes[n];
+                uint32_t next = node.mIdxNext;
+                node.mIdxPrev = node.mIdxNext = NIL;
+                node.mIndexed = false;
+                removeNode(n, findSlot(node.mDigest));
+                ++removed;
+                n = next;
+            }
+        }
+        return removed;
+    }
+
+    void
+    clear()
+    {
+        for (auto& idx : mByLedger)
+        {
+            idx.clear();
+        }
+        mNodes.clear();
+        mFreeNodes.clear();
+        std::fill(mSlots.begin(), mSlots.end(), NIL);
+        mHead = mTail = NIL;
+        mSize = 0;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+
+uint32_t const EntryCache::Shard::NIL;
+
+EntryCache::EntryCache(medida::MetricsRegistry& metrics, size_t maxSize)
+    : mMaxSize(maxSize)
+    , mSizeCounter(metrics.NewCounter({"entry-cache", "memory", "size"}))
+{
+    if (maxSize == 0)
+    {
+        throw std::invalid_argument("entry cache size must be positive");
+    }
+
+    randombytes_buf(mHashKey.data(), mHashKey.size());
+
+    size_t nShards = 1;
+    while (nShards < MAX_SHARDS && maxSize / (nShards * 2) >= MIN_SHARD_SIZE)
+    {
+        nShards *= 2;
+    }
+    size_t shardSize = (maxSize + nShards - 1) / nShards;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        mShards.emplace_back(make_unique<Shard>(shardSize));
+    }
+
+    // Indexed by LedgerEntryType; names match the database entity names.
+    for (auto const& name : {"account", "trust", "offer", "data"})
+    {
+        mTypeMetrics.emplace_back(
+            TypeMetrics{metrics.NewMeter({"entry-cache", "hit", name}, "entry"),
+                        metrics.NewMeter({"entry-cache", "miss", name}, "entry"),
+                        metrics.NewMeter({"entry-cache", "evict", name},
+                                         "entry")});
+    }
+}
+
+EntryCache::~EntryCache()
+{
+}
+
+EntryCache::Digest
+EntryCache::digest(LedgerKey const& key)
+{
+    size_t sz = xdr::xdr_size(key);
+    if (mKeyBuf.size() < sz)
+    {
+        mKeyBuf.resize(sz);
+    }
+    xdr::xdr_put p(mKeyBuf.data(), mKeyBuf.data() + sz);
+    xdr::xdr_argpack_archive(p, key);
+
+    unsigned char out[16];
+    if (crypto_generichash(out, sizeof(out),
+                           reinterpret_cast<unsigned char const*>(
+                               mKeyBuf.data()),
+                           sz, mHashKey.data(), mHashKey.size()) != 0)
+    {
+        throw std::runtime_error("error from crypto_generichash");
+    }
+    Digest d;
+    std::memcpy(&d.mLo, out, sizeof(d.mLo));
+    std::memcpy(&d.mHi, out + sizeof(d.mLo), sizeof(d.mHi));
+    return d;
+}
+
+EntryCache::Shard&
+EntryCache::shardFor(Digest const& d)
+{
+    return *mShards[d.mHi & (mShards.size() - 1)];
+}
+
+EntryCache::TypeMetrics&
+EntryCache::metricsFor(LedgerEntryType t)
+{
+    return mTypeMetrics.at(static_cast<size_t>(t));
+}
+
+void
+EntryCache::updateSize()
+{
+    mSizeCounter.set_count(size());
+}
+
+bool
+EntryCache::get(LedgerKey const& key, EntryPtr& entry)
+{
+    auto d = digest(key);
+    if (shardFor(d).get(d, entry))
+    {
+        metricsFor(key.type()).mHit.Mark();
+        return true;
+    }
+    metricsFor(key.type()).mMiss.Mark();
+    return false;
+}
+
+bool
+EntryCache::exists(LedgerKey const& key)
+{
+    auto d = digest(key);
+    return shardFor(d).exists(d);
+}
+
+void
+EntryCache::put(LedgerKey const& key, EntryPtr entry)
+{
+    auto d = digest(key);
+    LedgerEntryType evictedType;
+    if (shardFor(d).put(d, key.type(), std::move(entry), evictedType))
+    {
+        metricsFor(evictedType).mEvict.Mark();
+    }
+    updateSize();
+}
+
+void
+EntryCache::erase(LedgerKey const& key)
+{
+    auto d = digest(key);
+    shardFor(d).erase(d);
+    updateSize();
+}
+
+void
+EntryCache::erase_if(std::function<bool(EntryPtr const&)> const& f)
+{
+    for (auto& s : mShards)
+    {
+        s->eraseIf(f);
+    }
+    updateSize();
+}
+
+size_t
+EntryCache::eraseModifiedOnOrAfter(LedgerEntryType type, uint32_t ledgerSeq)
+{
+    size_t removed = 0;
+    for (auto& s : mShards)
+    {
+        removed += s->eraseModifiedOnOrAfter(type, ledgerSeq);
+    }
+    updateSize();
+    return removed;
+}
+
+void
+EntryCache::clear()
+{
+    for (auto& s : mShards)
+    {
+        s->clear();
+    }
+    updateSize();
+}
+
+size_t
+EntryCache::size() const
+{
+    size_t n = 0;
+    for (auto const& s : mShards)
+    {
+        n += s->size();
+    }
+    return n;
+}
+
+size_t
+EntryCache::maxSize() const
+{
+    return mMaxSize;
+}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace medida
+{
+class MetricsRegistry;
+class Meter;
+class Counter;
+}
+
+namespace stellar
+{
+
+/**
+ * Cache of LedgerEntries sitting in front of the SQL tables for accounts,
+ * trustlines, offers and data. A cached nullptr records that a key is known
+ * to be absent from the database.
+ *
+ * Entries are keyed by a fixed-width digest of their LedgerKey: a randomly
+ * keyed 128-bit BLAKE2b hash of the key's XDR encoding, serialized into a
+ * reusable buffer so that probing the cache does not allocate. The cache is
+ * split into a power-of-two number of shards selected by the digest. Each
+ * shard keeps its nodes in one contiguous vector, threads them onto an LRU
+ * list by index and finds them through an open-addressed (linear probing)
+ * slot table with backward-shift deletion.
+ *
+ * Each shard also indexes its non-null entries by type and
+ * lastModifiedLedgerSeq, so that invalidating the entries modified on or
+ * after some ledger (on rollback or rewind) costs time proportional to the
+ * number of entries removed rather than the size of the cache.
+ *
+ * Like the main database session it fronts, the cache may only be used from
+ * the main thread.
+ */
+class EntryCache : NonMovableOrCopyable
+{
+  public:
+    typedef std::shared_ptr<LedgerEntry const> EntryPtr;
+
+    struct Digest
+    {
+        uint64_t mLo;
+        uint64_t mHi;
+
+        bool
+        operator==(Digest const& other) const
+        {
+            return mLo == other.mLo && mHi == other.mHi;
+        }
+    };
+
+    EntryCache(medida::MetricsRegistry& metrics, size_t maxSize);
+    ~EntryCache();
+
+    // Return true if `key` is cached, setting `entry` to the cached value
+    // (which may be nullptr for a known-absent key). Counts as a hit or miss
+    // in the metrics and refreshes the key's LRU position on hit.
+    bool get(LedgerKey const& key, EntryPtr& entry);
+
+    // Return true if `key` is cached, without touching metrics or LRU order.
+    bool exists(LedgerKey const& key);
+
+    // Insert or replace the cached value of `key`, evicting the least
+    // recently used entry of its shard if the shard is full.
+    void put(LedgerKey const& key, EntryPtr entry);
+
+    // Remove `key` from the cache if present.
+    void erase(LedgerKey const& key);
+
+    // Remove every non-null cached entry of `type` whose
+    // lastModifiedLedgerSeq is >= `ledgerSeq`; returns the number removed.
+    // Known-absent (null) keys are left in place.
+    size_t eraseModifiedOnOrAfter(LedgerEntryType type, uint32_t ledgerSeq);
+
+    // Remove every cached entry for which `f` returns true. This scans the
+    // whole cache; prefer eraseModifiedOnOrAfter where it applies.
+    void erase_if(std::function<bool(EntryPtr const&)> const& f);
+
+    void clear();
+
+    size_t size() const;
+    size_t maxSize() const;
+
+    // Compute the digest the cache uses to identify `key`.
+    Digest digest(LedgerKey const& key);
+
+  private:
+    class Shard;
+
+    std::array<unsigned char, 16> mHashKey;
+    std::vector<char> mKeyBuf;
+    std::vector<std::unique_ptr<Shard>> mShards;
+    size_t mMaxSize;
+
+    struct TypeMetrics
+    {
+        medida::Meter& mHit;
+        medida::Meter& mMiss;
+        medida::Meter& mEvict;
+    };
+    std::vector<TypeMetrics> mTypeMetrics;
+    medida::Counter& mSizeCounter;
+
+    Shard& shardFor(Digest const& d);
+    TypeMetrics& metricsFor(LedgerEntryType t);
+    void updateSize();
+};
+}
@@ -0,0 +1,208 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/EntryCache.h"
+#include "ledger/EntryFrame.h"
+#include "ledger/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include <set>
+
+namespace stellar
+{
+using xdr::operator==;
+
+namespace
+{
+std::vector<LedgerEntry>
+uniqueEntries(size_t n)
+{
+    std::vector<LedgerEntry> res;
+    std::set<LedgerKey, LedgerEntryIdCmp> keys;
+    while (res.size() < n)
+    {
+        auto e = LedgerTestUtils::generateValidLedgerEntry();
+        if (keys.insert(LedgerEntryKey(e)).second)
+        {
+            res.emplace_back(e);
+        }
+    }
+    return res;
+}
+}
+
+TEST_CASE("entry cache get and put", "[entrycache]")
+{
+    medida::MetricsRegistry metrics;
+    EntryCache c{metrics, 1000};
+    auto entries = uniqueEntries(100);
+
+    for (auto const& e : entries)
+    {
+        c.put(LedgerEntryKey(e), std::make_shared<LedgerEntry const>(e));
+    }
+    REQUIRE(c.size() == entries.size());
+
+    for (auto const& e : entries)
+    {
+        EntryCache::EntryPtr p;
+        REQUIRE(c.get(LedgerEntryKey(e), p));
+        REQUIRE(p);
+        REQUIRE(*p == e);
+    }
+
+    SECTION("known-absent keys are cached as null")
+    {
+        auto k = LedgerEntryKey(entries[0]);
+        c.put(k, nullptr);
+        EntryCache::EntryPtr p;
+        REQUIRE(c.get(k, p));
+        REQUIRE(!p);
+        REQUIRE(c.size() == entries.size());
+    }
+
+    SECTION("erase")
+    {
+        for (size_t i = 0; i < entries.size(); i += 2)
+        {
+            c.erase(LedgerEntryKey(entries[i]));
+        }
+        REQUIRE(c.size() == entries.size() / 2);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            REQUIRE(c.exists(LedgerEntryKey(entries[i])) == (i % 2 == 1));
+        }
+    }
+
+    SECTION("erase_if")
+    {
+        c.erase_if([](EntryCache::EntryPtr const& p) {
+            return p && p->data.type() == ACCOUNT;
+        });
+        for (auto const& e : entries)
+        {
+            REQUIRE(c.exists(LedgerEntryKey(e)) == (e.data.type() != ACCOUNT));
+        }
+    }
+
+    SECTION("clear")
+    {
+        c.clear();
+        REQUIRE(c.size() == 0);
+        for (auto const& e : entries)
+        {
+            REQUIRE(!c.exists(LedgerEntryKey(e)));
+        }
+    }
+}
+
+TEST_CASE("entry cache invalidates by type and last modified ledger",
+          "[entrycache]")
+{
+    medida::MetricsRegistry metrics;
+    EntryCache c{metrics, 10000};
+    auto entries = uniqueEntries(1000);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i].lastModifiedLedgerSeq = static_cast<uint32_t>(i % 20 + 1);
+        c.put(LedgerEntryKey(entries[i]),
+              std::make_shared<LedgerEntry const>(entries[i]));
+    }
+
+    // A known-absent key survives invalidation.
+    LedgerKey absent;
+    absent.type(ACCOUNT);
+    absent.account().accountID =
+        LedgerTestUtils::generateValidAccountEntry().accountID;
+    c.put(absent, nullptr);
+
+    size_t expected = 0;
+    for (auto const& e : entries)
+    {
+        if (e.data.type() == TRUSTLINE && e.lastModifiedLedgerSeq >= 15)
+        {
+            ++expected;
+        }
+    }
+    REQUIRE(c.eraseModifiedOnOrAfter(TRUSTLINE, 15) == expected);
+    REQUIRE(c.size() == entries.size() + 1 - expected);
+    for (auto const& e : entries)
+    {
+        bool gone = e.data.type() == TRUSTLINE && e.lastModifiedLedgerSeq >= 15;
+        REQUIRE(c.exists(LedgerEntryKey(e)) == !gone);
+    }
+    REQUIRE(c.exists(absent));
+
+    SECTION("replacing an entry reindexes it")
+    {
+        auto e = entries[0];
+        e.lastModifiedLedgerSeq = 100;
+        c.put(LedgerEntryKey(e), std::make_shared<LedgerEntry const>(e));
+        REQUIRE(c.eraseModifiedOnOrAfter(e.data.type(), 100) == 1);
+        REQUIRE(!c.exists(LedgerEntryKey(e)));
+    }
+}
+
+TEST_CASE("entry cache evicts least recently used", "[entrycache]")
+{
+    medida::MetricsRegistry metrics;
+    // Small enough to use a single shard, so eviction order is exact.
+    size_t const n = 64;
+    EntryCache c{metrics, n};
+    auto entries = uniqueEntries(n + 1);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        c.put(LedgerEntryKey(entries[i]),
+              std::make_shared<LedgerEntry const>(entries[i]));
+    }
+    REQUIRE(c.size() == n);
+
+    // Refresh the oldest entry so the second one becomes the LRU victim.
+    EntryCache::EntryPtr p;
+    REQUIRE(c.get(LedgerEntryKey(entries[0]), p));
+
+    c.put(LedgerEntryKey(entries[n]),
+          std::make_shared<LedgerEntry const>(entries[n]));
+    REQUIRE(c.size() == n);
+    REQUIRE(c.exists(LedgerEntryKey(entries[0])));
+    REQUIRE(!c.exists(LedgerEntryKey(entries[1])));
+    REQUIRE(c.exists(LedgerEntryKey(entries[n])));
+
+    std::vector<std::string> const names{"account", "trust", "offer", "data"};
+    auto& evicted = metrics.NewMeter(
+        {"entry-cache", "evict", names.at(entries[1].data.type())}, "entry");
+    REQUIRE(evicted.count() == 1);
+}
+
+TEST_CASE("entry cache survives heavy churn", "[entrycache]")
+{
+    medida::MetricsRegistry metrics;
+    EntryCache c{metrics, 4096};
+    auto entries = uniqueEntries(20000);
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        c.put(LedgerEntryKey(entries[i]),
+              std::make_shared<LedgerEntry const>(entries[i]));
+        if (i % 3 == 0)
+        {
+            c.erase(LedgerEntryKey(entries[i / 2]));
+        }
+        REQUIRE(c.size() <= c.maxSize() + 16);
+    }
+
+    // Whatever survived must still map to the right entry.
+    for (auto const& e : entries)
+    {
+        EntryCache::EntryPtr p;
+        if (c.get(LedgerEntryKey(e), p))
+        {
+            REQUIRE(p);
+            REQUIRE(*p == e);
+        }
+    }
+}
+}
@@ -13,6 +13,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 namespace stellar
 {
@@ -103,6 +104,12 @@ class Herder
     virtual bool recvTxSet(Hash const& hash, TxSetFrame const& txset) = 0;
     // We are learning about a new transaction.
     virtual TransactionSubmitStatus recvTransaction(TransactionFramePtr tx) = 0;
+    // Verify the signatures of transactions we are about to receive on the
+    // worker threads, so that validating them hits the verify cache, then
+    // call `done` on the main thread. Calls to `done` keep submission order.
+    virtual void
+    preverifySignatures(std::vector<TransactionFramePtr> const& txs,
+                        std::function<void()> done) = 0;
     virtual void peerDoesntHave(stellar::MessageType type,
                                 uint256 const& itemID, PeerPtr peer) = 0;
     virtual TxSetFramePtr getTxSet(Hash const& hash) = 0;
@@ -110,6 +117,9 @@ class Herder
 
     // We are learning about a new envelope.
     virtual EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope) = 0;
+    // Same, with `envelopeHash` already computed by getSCPEnvelopeHash.
+    virtual EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
+                                           Hash const& envelopeHash) = 0;
 
     // We are learning about a new fully-fetched envelope.
     virtual EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
@@ -144,5 +154,11 @@ class Herder
     virtual void dumpInfo(Json::Value& ret, size_t limit) = 0;
     virtual void dumpQuorumInfo(Json::Value& ret, NodeID const& id,
                                 bool summary, uint64 index = 0) = 0;
+
+    // latest known quorum set of each node heard from in the slots SCP
+    // still tracks, and of the local node; nullptr for nodes whose quorum set
+    // has not been fetched
+    virtual std::unordered_map<NodeID, SCPQuorumSetPtr>
+    getCurrentQuorumMap() = 0;
 };
 }
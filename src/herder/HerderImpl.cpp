@@ -72,6 +72,7 @@ HerderImpl::SCPMetrics::SCPMetrics(Application& app)
 HerderImpl::HerderImpl(Application& app)
     : mPendingTransactions(4)
     , mPendingEnvelopes(app, *this)
+    , mSignaturePreVerifier(app)
     , mHerderSCPDriver(app, *this, mUpgrades, mPendingEnvelopes)
     , mLastSlotSaved(0)
     , mTrackingTimer(app)
@@ -360,6 +361,13 @@ HerderImpl::recvTransaction(TransactionFramePtr tx)
 
 Herder::EnvelopeStatus
 HerderImpl::recvSCPEnvelope(SCPEnvelope const& envelope)
+{
+    return recvSCPEnvelope(envelope, getSCPEnvelopeHash(envelope));
+}
+
+Herder::EnvelopeStatus
+HerderImpl::recvSCPEnvelope(SCPEnvelope const& envelope,
+                            Hash const& envelopeHash)
 {
     if (mApp.getConfig().MANUAL_CLOSE)
     {
@@ -414,7 +422,7 @@ HerderImpl::recvSCPEnvelope(SCPEnvelope const& envelope)
         return Herder::ENVELOPE_STATUS_DISCARDED;
     }
 
-    auto status = mPendingEnvelopes.recvSCPEnvelope(envelope);
+    auto status = mPendingEnvelopes.recvSCPEnvelope(envelope, envelopeHash);
     if (status == Herder::ENVELOPE_STATUS_READY)
     {
         processSCPQueue();
@@ -648,6 +656,13 @@ HerderImpl::recvSCPQuorumSet(Hash const& hash, const SCPQuorumSet& qset)
     return mPendingEnvelopes.recvSCPQuorumSet(hash, qset);
 }
 
+void
+HerderImpl::preverifySignatures(std::vector<TransactionFramePtr> const& txs,
+                                std::function<void()> done)
+{
+    mSignaturePreVerifier.verifyThen(txs, done);
+}
+
 bool
 HerderImpl::recvTxSet(Hash const& hash, const TxSetFrame& t)
 {
@@ -888,6 +903,37 @@ HerderImpl::dumpQuorumInfo(Json::Value& ret, NodeID const& id, bool summary,
     getSCP().dumpQuorumInfo(ret["slots"], id, summary, index);
 }
 
+std::unordered_map<NodeID, SCPQuorumSetPtr>
+HerderImpl::getCurrentQuorumMap()
+{
+    std::unordered_map<NodeID, SCPQuorumSetPtr> res;
+    auto localNode = getSCP().getLocalNode();
+    res[localNode->getNodeID()] =
+        std::make_shared<SCPQuorumSet>(localNode->getQuorumSet());
+
+    if (getSCP().empty())
+    {
+        return res;
+    }
+    // later slots override what earlier ones say
+    for (auto slot = getSCP().getLowSlotIndex();
+         slot <= getSCP().getHighSlotIndex(); ++slot)
+    {
+        for (auto const& e : getSCP().getCurrentState(slot))
+        {
+            auto const& st = e.statement;
+            auto qSet =
+                getQSet(Slot::getCompanionQuorumSetHashFromStatement(st));
+            auto& known = res[st.nodeID];
+            if (qSet || !known)
+            {
+                known = qSet;
+            }
+        }
+    }
+    return res;
+}
+
 void
 HerderImpl::persistSCPState(uint64 slot)
 {
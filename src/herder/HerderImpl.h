@@ -7,6 +7,7 @@
 #include "PendingEnvelopes.h"
 #include "herder/Herder.h"
 #include "herder/HerderSCPDriver.h"
+#include "herder/SignaturePreVerifier.h"
 #include "herder/Upgrades.h"
 #include "util/Timer.h"
 #include <deque>
@@ -60,8 +61,12 @@ class HerderImpl : public Herder
     void emitEnvelope(SCPEnvelope const& envelope);
 
     TransactionSubmitStatus recvTransaction(TransactionFramePtr tx) override;
+    void preverifySignatures(std::vector<TransactionFramePtr> const& txs,
+                             std::function<void()> done) override;
 
     EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope) override;
+    EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
+                                   Hash const& envelopeHash) override;
     EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
                                    const SCPQuorumSet& qset,
                                    TxSetFrame txset) override;
@@ -91,6 +96,7 @@ class HerderImpl : public Herder
     void dumpInfo(Json::Value& ret, size_t limit) override;
     void dumpQuorumInfo(Json::Value& ret, NodeID const& id, bool summary,
                         uint64 index) override;
+    std::unordered_map<NodeID, SCPQuorumSetPtr> getCurrentQuorumMap() override;
 
     struct TxMap
     {
@@ -124,6 +130,7 @@ class HerderImpl : public Herder
     updatePendingTransactions(std::vector<TransactionFramePtr> const& applied);
 
     PendingEnvelopes mPendingEnvelopes;
+    SignaturePreVerifier mSignaturePreVerifier;
     Upgrades mUpgrades;
     HerderSCPDriver mHerderSCPDriver;
 
@@ -23,6 +23,9 @@
 
 #include "xdrpp/marshal.h"
 
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -944,3 +947,58 @@ TEST_CASE("quick restart", "[herder][quickRestart]")
 
     simulation->stopAllNodes();
 }
+
+TEST_CASE("signature pre-verification", "[herder]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    app->start();
+
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("A", app->getLedgerManager().getMinBalance(1));
+
+    std::vector<TransactionFramePtr> txs;
+    for (int n = 0; n < 40; n++)
+    {
+        auto& source = n % 2 == 0 ? root : a1;
+        txs.emplace_back(source.tx({payment(root, n + 10)}));
+    }
+
+    PubKeyUtils::clearVerifySigCache();
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    // collecting the signatures to verify does not query the database
+    auto& accountSelects = app->getMetrics().NewTimer(
+        {"database", "select", "account"});
+    auto selectsBefore = accountSelects.count();
+
+    std::vector<int> order;
+    app->getHerder().preverifySignatures(txs, [&]() { order.push_back(1); });
+    // nothing to verify, but still completes after the batch ahead of it
+    app->getHerder().preverifySignatures({}, [&]() { order.push_back(2); });
+    REQUIRE(order.empty());
+    REQUIRE(accountSelects.count() == selectsBefore);
+
+    while (order.size() < 2)
+    {
+        clock.crank(true);
+    }
+    REQUIRE(order == std::vector<int>{1, 2});
+
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(misses >= txs.size());
+
+    // validation now finds every signature in the cache
+    for (auto const& tx : txs)
+    {
+        for (auto const& sig : tx->getEnvelope().signatures)
+        {
+            REQUIRE(PubKeyUtils::verifySig(tx->getSourceID(), sig.signature,
+                                           tx->getContentsHash()));
+        }
+    }
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(hits == txs.size());
+    REQUIRE(misses == 0);
+}
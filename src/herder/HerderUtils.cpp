@@ -3,6 +3,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/HerderUtils.h"
+#include "crypto/SHA.h"
+#include "overlay/StellarXDR.h"
 #include "scp/Slot.h"
 #include "xdr/Stellar-ledger.h"
 #include <algorithm>
@@ -40,4 +42,15 @@ getStellarValues(SCPStatement const& statement)
 
     return result;
 }
+
+Hash
+getSCPEnvelopeHash(SCPEnvelope const& envelope)
+{
+    // same bytes as xdr_to_opaque(StellarMessage), without copying the
+    // envelope into a message
+    auto hasher = SHA256::create();
+    hasher->add(xdr::xdr_to_opaque(SCP_MESSAGE));
+    hasher->add(xdr::xdr_to_opaque(envelope));
+    return hasher->finish();
+}
 }
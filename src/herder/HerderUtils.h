@@ -16,4 +16,8 @@ struct StellarValue;
 
 std::vector<Hash> getTxSetHashes(SCPEnvelope const& envelope);
 std::vector<StellarValue> getStellarValues(SCPStatement const& envelope);
+
+// Hash identifying an envelope: sha256 of the SCP_MESSAGE carrying it, which
+// is also the key Floodgate records that message under.
+Hash getSCPEnvelopeHash(SCPEnvelope const& envelope);
 }
@@ -167,7 +167,8 @@ PendingEnvelopes::isNodeInQuorum(NodeID const& node)
 
 // called from Peer and when an Item tracker completes
 Herder::EnvelopeStatus
-PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
+PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope,
+                                  Hash const& envelopeHash)
 {
     auto const& nodeID = envelope.statement.nodeID;
     if (!isNodeInQuorum(nodeID))
@@ -185,26 +186,25 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
 
     try
     {
-        if (isDiscarded(envelope))
+        if (isDiscarded(envelope, envelopeHash))
         {
             return Herder::ENVELOPE_STATUS_DISCARDED;
         }
 
         touchFetchCache(envelope);
 
-        auto& set = mEnvelopes[envelope.statement.slotIndex].mFetchingEnvelopes;
-        auto& processedList =
-            mEnvelopes[envelope.statement.slotIndex].mProcessedEnvelopes;
+        auto& slot = mEnvelopes[envelope.statement.slotIndex];
+        auto& fetchingMap = slot.mFetchingEnvelopes;
+        auto& processedSet = slot.mProcessedEnvelopes;
 
-        auto fetching = find(set.begin(), set.end(), envelope);
+        auto fetching = fetchingMap.find(envelopeHash);
 
-        if (fetching == set.end())
+        if (fetching == fetchingMap.end())
         { // we aren't fetching this envelope
-            if (find(processedList.begin(), processedList.end(), envelope) ==
-                processedList.end())
+            if (processedSet.find(envelopeHash) == processedSet.end())
             { // we haven't seen this envelope before
                 // insert it into the fetching set
-                fetching = set.insert(envelope).first;
+                fetching = fetchingMap.emplace(envelopeHash, envelope).first;
                 startFetch(envelope);
             }
             else
@@ -219,9 +219,9 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
         if (isFullyFetched(envelope))
         {
             // move the item from fetching to processed
-            processedList.emplace_back(*fetching);
-            set.erase(fetching);
-            envelopeReady(envelope);
+            processedSet.insert(envelopeHash);
+            fetchingMap.erase(fetching);
+            envelopeReady(envelope, envelopeHash);
             return Herder::ENVELOPE_STATUS_READY;
         } // else just keep waiting for it to come in
 
@@ -236,23 +236,26 @@ PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
     }
 }
 
+Herder::EnvelopeStatus
+PendingEnvelopes::recvSCPEnvelope(SCPEnvelope const& envelope)
+{
+    return recvSCPEnvelope(envelope, getSCPEnvelopeHash(envelope));
+}
+
 void
 PendingEnvelopes::discardSCPEnvelope(SCPEnvelope const& envelope)
 {
     try
     {
-        if (isDiscarded(envelope))
+        auto envelopeHash = getSCPEnvelopeHash(envelope);
+        if (isDiscarded(envelope, envelopeHash))
         {
             return;
         }
 
-        auto& discardedSet =
-            mEnvelopes[envelope.statement.slotIndex].mDiscardedEnvelopes;
-        discardedSet.insert(envelope);
-
-        auto& fetchingSet =
-            mEnvelopes[envelope.statement.slotIndex].mFetchingEnvelopes;
-        fetchingSet.erase(envelope);
+        auto& slot = mEnvelopes[envelope.statement.slotIndex];
+        slot.mDiscardedEnvelopes.insert(envelopeHash);
+        slot.mFetchingEnvelopes.erase(envelopeHash);
 
         stopFetch(envelope);
     }
@@ -265,7 +268,8 @@ PendingEnvelopes::discardSCPEnvelope(SCPEnvelope const& envelope)
 }
 
 bool
-PendingEnvelopes::isDiscarded(SCPEnvelope const& envelope) const
+PendingEnvelopes::isDiscarded(SCPEnvelope const& envelope,
+                              Hash const& envelopeHash) const
 {
     auto envelopes = mEnvelopes.find(envelope.statement.slotIndex);
     if (envelopes == mEnvelopes.end())
@@ -274,18 +278,17 @@ PendingEnvelopes::isDiscarded(SCPEnvelope const& envelope) const
     }
 
     auto& discardedSet = envelopes->second.mDiscardedEnvelopes;
-    auto discarded =
-        std::find(std::begin(discardedSet), std::end(discardedSet), envelope);
-    return discarded != discardedSet.end();
+    return discardedSet.find(envelopeHash) != discardedSet.end();
 }
 
 void
-PendingEnvelopes::envelopeReady(SCPEnvelope const& envelope)
+PendingEnvelopes::envelopeReady(SCPEnvelope const& envelope,
+                                Hash const& envelopeHash)
 {
     StellarMessage msg;
     msg.type(SCP_MESSAGE);
     msg.envelope() = envelope;
-    mApp.getOverlayManager().broadcastMessage(msg);
+    mApp.getOverlayManager().broadcastMessage(msg, false, envelopeHash);
 
     mEnvelopes[envelope.statement.slotIndex].mReadyEnvelopes.push_back(
         envelope);
@@ -473,7 +476,7 @@ PendingEnvelopes::dumpInfo(Json::Value& ret, size_t limit)
                 Json::Value& slot = q[std::to_string(it->first)]["fetching"];
                 for (auto const& e : it->second.mFetchingEnvelopes)
                 {
-                    slot.append(mHerder.getSCP().envToStr(e));
+                    slot.append(mHerder.getSCP().envToStr(e.second));
                 }
             }
             if (it->second.mReadyEnvelopes.size() != 0)
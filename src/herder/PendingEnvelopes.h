@@ -9,6 +9,9 @@
 #include <medida/medida.h>
 #include <queue>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <util/HashOfHash.h>
 #include <util/optional.h>
 
 /*
@@ -21,14 +24,15 @@ namespace stellar
 
 class HerderImpl;
 
+// Envelopes are identified by getSCPEnvelopeHash, computed once on receipt.
 struct SlotEnvelopes
 {
-    // list of envelopes we have processed already
-    std::vector<SCPEnvelope> mProcessedEnvelopes;
-    // list of envelopes we have discarded already
-    std::set<SCPEnvelope> mDiscardedEnvelopes;
-    // list of envelopes we are fetching right now
-    std::set<SCPEnvelope> mFetchingEnvelopes;
+    // envelopes we have processed already
+    std::unordered_set<Hash> mProcessedEnvelopes;
+    // envelopes we have discarded already
+    std::unordered_set<Hash> mDiscardedEnvelopes;
+    // envelopes we are fetching right now
+    std::unordered_map<Hash, SCPEnvelope> mFetchingEnvelopes;
     // list of ready envelopes that haven't been sent to SCP yet
     std::vector<SCPEnvelope> mReadyEnvelopes;
 };
@@ -68,10 +72,13 @@ class PendingEnvelopes
     ~PendingEnvelopes();
 
     /**
-     * Process received @p envelope.
+     * Process received @p envelope, whose getSCPEnvelopeHash is
+     * @p envelopeHash.
      *
      * Return status of received envelope.
      */
+    Herder::EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
+                                           Hash const& envelopeHash);
     Herder::EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope);
 
     /**
@@ -112,13 +119,14 @@ class PendingEnvelopes
     void peerDoesntHave(MessageType type, Hash const& itemID,
                         Peer::pointer peer);
 
-    bool isDiscarded(SCPEnvelope const& envelope) const;
+    bool isDiscarded(SCPEnvelope const& envelope,
+                     Hash const& envelopeHash) const;
     bool isFullyFetched(SCPEnvelope const& envelope);
     void startFetch(SCPEnvelope const& envelope);
     void stopFetch(SCPEnvelope const& envelope);
     void touchFetchCache(SCPEnvelope const& envelope);
 
-    void envelopeReady(SCPEnvelope const& envelope);
+    void envelopeReady(SCPEnvelope const& envelope, Hash const& envelopeHash);
 
     bool pop(uint64 slotIndex, SCPEnvelope& ret);
 
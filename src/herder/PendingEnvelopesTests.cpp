@@ -4,6 +4,7 @@
 
 #include "crypto/SHA.h"
 #include "herder/HerderImpl.h"
+#include "herder/HerderUtils.h"
 #include "herder/PendingEnvelopes.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
@@ -261,3 +262,24 @@ TEST_CASE("PendingEnvelopes::recvSCPEnvelope", "[herder]")
         }
     }
 }
+
+TEST_CASE("SCP envelope hash is the flood index", "[herder]")
+{
+    auto key = SecretKey::fromSeed(sha256("NODE_SEED_0"));
+
+    StellarMessage msg;
+    msg.type(SCP_MESSAGE);
+    auto& envelope = msg.envelope();
+    envelope.statement.nodeID = key.getPublicKey();
+    envelope.statement.slotIndex = 7;
+    envelope.statement.pledges.type(SCP_ST_NOMINATE);
+    envelope.statement.pledges.nominate().votes.emplace_back(Value(4, 1));
+    envelope.signature = key.sign(xdr::xdr_to_opaque(envelope.statement));
+
+    auto hash = getSCPEnvelopeHash(envelope);
+    REQUIRE(hash == sha256(xdr::xdr_to_opaque(msg)));
+
+    auto other = envelope;
+    other.statement.slotIndex++;
+    REQUIRE(getSCPEnvelopeHash(other) != hash);
+}
@@ -0,0 +1,545 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/QuorumIntersectionChecker.h"
+#include "util/Logging.h"
+#include <algorithm>
+#include <bitset>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace stellar
+{
+
+using xdr::operator<;
+
+namespace
+{
+typedef QuorumEvaluator::NodeBits NodeBits;
+
+// all sets below have the same number of words
+
+size_t
+countBits(NodeBits const& a)
+{
+    size_t res = 0;
+    for (auto w : a)
+    {
+        res += std::bitset<64>(w).count();
+    }
+    return res;
+}
+
+bool
+isEmpty(NodeBits const& a)
+{
+    return std::all_of(a.begin(), a.end(), [](uint64_t w) { return w == 0; });
+}
+
+bool
+isSubset(NodeBits const& a, NodeBits const& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i] & ~b[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+NodeBits
+unionOf(NodeBits a, NodeBits const& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        a[i] |= b[i];
+    }
+    return a;
+}
+
+NodeBits
+intersectionOf(NodeBits a, NodeBits const& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        a[i] &= b[i];
+    }
+    return a;
+}
+
+NodeBits
+differenceOf(NodeBits a, NodeBits const& b)
+{
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        a[i] &= ~b[i];
+    }
+    return a;
+}
+
+template <typename F>
+void
+forEachBit(NodeBits const& a, F f)
+{
+    for (size_t w = 0; w < a.size(); ++w)
+    {
+        for (auto bits = a[w]; bits != 0; bits &= bits - 1)
+        {
+            uint32 b = 0;
+            while (!((bits >> b) & 1))
+            {
+                ++b;
+            }
+            f(uint32(w * 64 + b));
+        }
+    }
+}
+
+void
+collectNodes(QuorumEvaluator::CompiledQSet const& qSet, NodeBits& nodes)
+{
+    for (size_t w = 0; w < std::min(nodes.size(), qSet.mValidators.size());
+         ++w)
+    {
+        nodes[w] |= qSet.mValidators[w];
+    }
+    for (auto const& inner : qSet.mInnerSets)
+    {
+        collectNodes(inner, nodes);
+    }
+}
+}
+
+struct QuorumIntersectionChecker::Search
+{
+    QuorumIntersectionChecker* mChecker;
+    NodeBits mComponent;
+    size_t mMaxCommit;
+    std::chrono::steady_clock::time_point mStart;
+    std::chrono::steady_clock::time_point mDeadline;
+    bool mHasDeadline;
+    std::atomic<int64_t> mNextReport{PROGRESS_INTERVAL};
+
+    std::atomic<bool> mStop{false};
+    std::atomic<bool> mTimedOut{false};
+    std::atomic<bool> mCancelled{false};
+
+    std::mutex mMutex;
+    std::deque<Task> mTasks;
+    size_t mTotalTasks{0};
+    size_t mInFlight{0};
+    bool mFound{false};
+    NodeBits mQuorumA;
+    NodeBits mQuorumB;
+};
+
+QuorumIntersectionChecker::QuorumIntersectionChecker(QuorumMap const& qmap)
+    : mExplored(0), mCancelled(false)
+{
+    for (auto const& q : qmap)
+    {
+        if (q.second)
+        {
+            mNodes.emplace_back(q.first);
+        }
+    }
+    // in a fixed order, so that runs over the same network are alike
+    std::sort(mNodes.begin(), mNodes.end());
+
+    std::unordered_map<NodeID, uint32> index;
+    for (auto const& n : mNodes)
+    {
+        index.emplace(n, uint32(index.size()));
+    }
+    auto indexOf = [&](NodeID const& n) {
+        auto res = index.emplace(n, uint32(mNodes.size()));
+        if (res.second)
+        {
+            mNodes.emplace_back(n);
+        }
+        return res.first->second;
+    };
+
+    size_t known = index.size();
+    for (size_t i = 0; i < known; ++i)
+    {
+        NodeID node = mNodes[i];
+        mQSets.emplace_back(QuorumEvaluator::compile(*qmap.at(node), indexOf));
+    }
+    mWords = (known + 63) / 64;
+
+    std::vector<size_t> inDegree(known, 0);
+    for (auto const& q : mQSets)
+    {
+        NodeBits nodes(mWords, 0);
+        collectNodes(q, nodes);
+        mEdges.emplace_back();
+        forEachBit(nodes, [&](uint32 n) {
+            // the last word may also hold nodes with no known quorum set
+            if (n < known)
+            {
+                mEdges.back().emplace_back(n);
+                inDegree[n]++;
+            }
+        });
+    }
+
+    for (uint32 i = 0; i < known; ++i)
+    {
+        mOrder.emplace_back(i);
+    }
+    std::stable_sort(mOrder.begin(), mOrder.end(), [&](uint32 a, uint32 b) {
+        return inDegree[a] > inDegree[b];
+    });
+}
+
+void
+QuorumIntersectionChecker::cancel()
+{
+    mCancelled = true;
+}
+
+uint64_t
+QuorumIntersectionChecker::getExplored() const
+{
+    return mExplored;
+}
+
+std::vector<QuorumIntersectionChecker::NodeBits>
+QuorumIntersectionChecker::components() const
+{
+    // Tarjan's algorithm, with an explicit call stack
+    size_t n = mQSets.size();
+    std::vector<int64_t> index(n, -1);
+    std::vector<int64_t> low(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<uint32> stack;
+    std::vector<std::pair<uint32, size_t>> calls;
+    std::vector<NodeBits> res;
+    int64_t next = 0;
+
+    auto visit = [&](uint32 v) {
+        index[v] = low[v] = next++;
+        stack.emplace_back(v);
+        onStack[v] = true;
+        calls.emplace_back(v, 0);
+    };
+
+    for (uint32 root = 0; root < n; ++root)
+    {
+        if (index[root] != -1)
+        {
+            continue;
+        }
+        visit(root);
+        while (!calls.empty())
+        {
+            uint32 v = calls.back().first;
+            if (calls.back().second < mEdges[v].size())
+            {
+                uint32 w = mEdges[v][calls.back().second++];
+                if (index[w] == -1)
+                {
+                    visit(w);
+                }
+                else if (onStack[w])
+                {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            calls.pop_back();
+            if (!calls.empty())
+            {
+                uint32 u = calls.back().first;
+                low[u] = std::min(low[u], low[v]);
+            }
+            if (low[v] == index[v])
+            {
+                NodeBits component(mWords, 0);
+                uint32 w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = false;
+                    QuorumEvaluator::setBit(component, w);
+                } while (w != v);
+                res.emplace_back(component);
+            }
+        }
+    }
+    return res;
+}
+
+QuorumIntersectionChecker::NodeBits
+QuorumIntersectionChecker::contract(NodeBits nodes) const
+{
+    bool changed;
+    do
+    {
+        changed = false;
+        forEachBit(nodes, [&](uint32 i) {
+            if (QuorumEvaluator::testBit(nodes, i) &&
+                !QuorumEvaluator::isQuorumSlice(mQSets[i], nodes))
+            {
+                QuorumEvaluator::clearBit(nodes, i);
+                changed = true;
+            }
+        });
+    } while (changed);
+    return nodes;
+}
+
+bool
+QuorumIntersectionChecker::isQuorum(NodeBits const& nodes) const
+{
+    return !isEmpty(nodes) && contract(nodes) == nodes;
+}
+
+bool
+QuorumIntersectionChecker::pickNode(NodeBits const& remaining,
+                                    uint32& node) const
+{
+    for (auto i : mOrder)
+    {
+        if (QuorumEvaluator::testBit(remaining, i))
+        {
+            node = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<NodeID>
+QuorumIntersectionChecker::toNodes(NodeBits const& nodes) const
+{
+    std::vector<NodeID> res;
+    forEachBit(nodes, [&](uint32 i) { res.emplace_back(mNodes[i]); });
+    return res;
+}
+
+QuorumIntersectionChecker::Result
+QuorumIntersectionChecker::check(size_t parallelism,
+                                 std::chrono::seconds budget)
+{
+    Result res{};
+    res.mStatus = QUORUM_INTERSECTION_OK;
+    res.mNodes = mQSets.size();
+    mExplored = 0;
+
+    NodeBits component;
+    std::vector<NodeBits> quorums;
+    for (auto const& c : components())
+    {
+        res.mComponents++;
+        auto q = contract(c);
+        if (!isEmpty(q))
+        {
+            res.mQuorumComponents++;
+            component = c;
+            quorums.emplace_back(q);
+        }
+    }
+    CLOG(INFO, "Herder") << "Quorum intersection check: " << res.mNodes
+                         << " nodes, " << res.mComponents << " components, "
+                         << res.mQuorumComponents << " containing a quorum";
+
+    if (quorums.size() >= 2)
+    {
+        res.mStatus = QUORUM_INTERSECTION_SPLIT;
+        res.mQuorumA = toNodes(quorums[0]);
+        res.mQuorumB = toNodes(quorums[1]);
+        return res;
+    }
+    if (quorums.empty())
+    {
+        return res;
+    }
+    if (mCancelled)
+    {
+        res.mStatus = QUORUM_INTERSECTION_CANCELLED;
+        return res;
+    }
+
+    auto search = std::make_shared<Search>();
+    search->mChecker = this;
+    search->mComponent = component;
+    search->mMaxCommit = countBits(component) / 2;
+    search->mStart = std::chrono::steady_clock::now();
+    search->mHasDeadline = budget.count() != 0;
+    search->mDeadline = search->mStart + budget;
+
+    parallelism = std::max<size_t>(1, parallelism);
+    search->mTasks.emplace_back(Task{NodeBits(mWords, 0), component});
+    while (search->mTasks.size() < parallelism * TASKS_PER_THREAD)
+    {
+        auto task = search->mTasks.front();
+        uint32 node;
+        if (!pickNode(task.mRemaining, node))
+        {
+            break;
+        }
+        search->mTasks.pop_front();
+        QuorumEvaluator::clearBit(task.mRemaining, node);
+        search->mTasks.emplace_back(task);
+        QuorumEvaluator::setBit(task.mCommitted, node);
+        search->mTasks.emplace_back(task);
+    }
+    search->mTotalTasks = search->mTasks.size();
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < parallelism; ++i)
+    {
+        threads.emplace_back([search]() { drain(search); });
+    }
+    drain(search);
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    res.mExplored = mExplored;
+    if (search->mFound)
+    {
+        res.mStatus = QUORUM_INTERSECTION_SPLIT;
+        res.mQuorumA = toNodes(search->mQuorumA);
+        res.mQuorumB = toNodes(search->mQuorumB);
+    }
+    else if (search->mCancelled)
+    {
+        res.mStatus = QUORUM_INTERSECTION_CANCELLED;
+    }
+    else if (search->mTimedOut)
+    {
+        res.mStatus = QUORUM_INTERSECTION_TIMED_OUT;
+    }
+    return res;
+}
+
+void
+QuorumIntersectionChecker::drain(std::shared_ptr<Search> search)
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(search->mMutex);
+            if (search->mStop || search->mTasks.empty())
+            {
+                return;
+            }
+            task = std::move(search->mTasks.front());
+            search->mTasks.pop_front();
+            search->mInFlight++;
+        }
+        search->mChecker->enumerate(*search, std::move(task.mCommitted),
+                                    std::move(task.mRemaining));
+        {
+            std::lock_guard<std::mutex> lock(search->mMutex);
+            search->mInFlight--;
+        }
+    }
+}
+
+void
+QuorumIntersectionChecker::enumerate(Search& search, NodeBits committed,
+                                     NodeBits remaining)
+{
+    if (search.mStop)
+    {
+        return;
+    }
+    auto explored = ++mExplored;
+    if (explored % CHECKPOINT_INTERVAL == 0 && !checkpoint(search, explored))
+    {
+        return;
+    }
+
+    if (countBits(committed) > search.mMaxCommit)
+    {
+        return;
+    }
+
+    auto disjoint = contract(differenceOf(search.mComponent, committed));
+    if (isEmpty(disjoint))
+    {
+        return;
+    }
+
+    if (isQuorum(committed))
+    {
+        std::lock_guard<std::mutex> lock(search.mMutex);
+        if (!search.mFound)
+        {
+            search.mFound = true;
+            search.mQuorumA = committed;
+            search.mQuorumB = disjoint;
+        }
+        search.mStop = true;
+        return;
+    }
+
+    auto perimeter = contract(unionOf(committed, remaining));
+    if (!isSubset(committed, perimeter))
+    {
+        return;
+    }
+    remaining = intersectionOf(remaining, perimeter);
+
+    uint32 node;
+    if (!pickNode(remaining, node))
+    {
+        return;
+    }
+    QuorumEvaluator::clearBit(remaining, node);
+    enumerate(search, committed, remaining);
+    QuorumEvaluator::setBit(committed, node);
+    enumerate(search, std::move(committed), std::move(remaining));
+}
+
+bool
+QuorumIntersectionChecker::checkpoint(Search& search, uint64_t explored)
+{
+    if (mCancelled)
+    {
+        search.mCancelled = true;
+        search.mStop = true;
+        return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (search.mHasDeadline && now > search.mDeadline)
+    {
+        search.mTimedOut = true;
+        search.mStop = true;
+        return false;
+    }
+
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::seconds>(now - search.mStart)
+            .count();
+    auto nextReport = search.mNextReport.load();
+    if (elapsed >= nextReport &&
+        search.mNextReport.compare_exchange_strong(
+            nextReport, elapsed + PROGRESS_INTERVAL))
+    {
+        size_t left;
+        {
+            std::lock_guard<std::mutex> lock(search.mMutex);
+            left = search.mTasks.size() + search.mInFlight;
+        }
+        CLOG(INFO, "Herder") << "Quorum intersection check: " << explored
+                             << " branches explored in " << elapsed << "s, "
+                             << left << " of " << search.mTotalTasks
+                             << " subproblems left";
+    }
+    return true;
+}
+}
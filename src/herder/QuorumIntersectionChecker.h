@@ -0,0 +1,135 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "scp/QuorumEvaluator.h"
+#include "scp/SCP.h"
+#include "util/NonCopyable.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Checks whether every two quorums of a network intersect, given the quorum
+ * set of each node. Any number of nodes can be checked, though the search is
+ * exponential in the worst case.
+ *
+ * Nodes whose quorum set is unknown cannot be part of any quorum and are left
+ * out. The graph in which each node points at the nodes of its quorum set is
+ * split into strongly connected components. Every quorum contains a quorum
+ * lying within a single component: if two components contain a quorum, the
+ * network is split. If only one does, only that component is searched.
+ *
+ * The search looks for a quorum whose complement still contains a quorum. It
+ * grows a committed set one node at a time, trying each node both in and out
+ * of the set (see Lachowski, "Complexity of Quorum Intersection in Federated
+ * Byzantine Agreement Systems"). A branch ends as soon as
+ *  - the committed set is a quorum, which is a split if its complement
+ *    contains a quorum,
+ *  - the complement of the committed set contains no quorum,
+ *  - the committed set is larger than half of the component, since one of
+ *    two disjoint quorums is at most that large, or
+ *  - no quorum within the committed and remaining nodes contains the
+ *    committed set.
+ *
+ * The first levels of the search are split into independent subproblems. The
+ * calling thread runs them together with threads of the checker's own, until
+ * a split is found, the time budget runs out or cancel() is called. The
+ * search does not use the application's worker threads, which other work
+ * such as signature pre-verification and bucket merges depends on.
+ */
+class QuorumIntersectionChecker : NonMovableOrCopyable
+{
+  public:
+    typedef std::unordered_map<NodeID, SCPQuorumSetPtr> QuorumMap;
+
+    enum Status
+    {
+        QUORUM_INTERSECTION_OK,
+        QUORUM_INTERSECTION_SPLIT,
+        QUORUM_INTERSECTION_TIMED_OUT,
+        QUORUM_INTERSECTION_CANCELLED
+    };
+
+    struct Result
+    {
+        Status mStatus;
+        // nodes with a known quorum set
+        size_t mNodes;
+        // strongly connected components among those nodes, and how many of
+        // them contain a quorum
+        size_t mComponents;
+        size_t mQuorumComponents;
+        // number of branches of the search visited
+        uint64_t mExplored;
+        // for QUORUM_INTERSECTION_SPLIT, two disjoint quorums
+        std::vector<NodeID> mQuorumA;
+        std::vector<NodeID> mQuorumB;
+    };
+
+    // number of subproblems queued per thread taking part in the search
+    static size_t const TASKS_PER_THREAD = 8;
+    // branches visited between two checks of the budget
+    static uint64_t const CHECKPOINT_INTERVAL = 4096;
+    // seconds between two progress reports
+    static int64_t const PROGRESS_INTERVAL = 10;
+
+    // nodes mapped to nullptr are treated as nodes with no known quorum set
+    explicit QuorumIntersectionChecker(QuorumMap const& qmap);
+
+    // Runs the check on the calling thread and `parallelism - 1` threads it
+    // starts and joins. A zero `budget` means no time limit.
+    Result check(size_t parallelism, std::chrono::seconds budget);
+
+    // Makes a running or later check stop within CHECKPOINT_INTERVAL
+    // branches and return QUORUM_INTERSECTION_CANCELLED; may be called from
+    // any thread.
+    void cancel();
+
+    // Number of branches visited so far; may be called from any thread.
+    uint64_t getExplored() const;
+
+  private:
+    typedef QuorumEvaluator::NodeBits NodeBits;
+
+    struct Task
+    {
+        NodeBits mCommitted;
+        NodeBits mRemaining;
+    };
+    struct Search;
+
+    // nodes with a known quorum set come first, in order; the others are
+    // only referred to by quorum sets
+    std::vector<NodeID> mNodes;
+    // quorum sets of the first mQSets.size() nodes
+    std::vector<QuorumEvaluator::CompiledQSet> mQSets;
+    // words in a set of nodes with a known quorum set
+    size_t mWords;
+    // nodes with a known quorum set that each one's quorum set refers to
+    std::vector<std::vector<uint32>> mEdges;
+    // nodes by decreasing number of quorum sets referring to them, the
+    // order in which the search adds them
+    std::vector<uint32> mOrder;
+    std::atomic<uint64_t> mExplored;
+    std::atomic<bool> mCancelled;
+
+    std::vector<NodeBits> components() const;
+    // largest quorum within `nodes`, empty if there is none
+    NodeBits contract(NodeBits nodes) const;
+    bool isQuorum(NodeBits const& nodes) const;
+    bool pickNode(NodeBits const& remaining, uint32& node) const;
+    std::vector<NodeID> toNodes(NodeBits const& nodes) const;
+
+    static void drain(std::shared_ptr<Search> search);
+    void enumerate(Search& search, NodeBits committed, NodeBits remaining);
+    bool checkpoint(Search& search, uint64_t explored);
+};
+}
@@ -0,0 +1,186 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/QuorumIntersectionChecker.h"
+#include "crypto/SecretKey.h"
+#include "lib/catch.hpp"
+#include "scp/LocalNode.h"
+#include <set>
+
+using namespace stellar;
+
+namespace
+{
+typedef QuorumIntersectionChecker::QuorumMap QuorumMap;
+
+std::vector<PublicKey>
+makeNodes(size_t n)
+{
+    std::vector<PublicKey> res;
+    for (size_t i = 0; i < n; ++i)
+    {
+        res.emplace_back(SecretKey::random().getPublicKey());
+    }
+    return res;
+}
+
+// `orgs` organizations of three nodes each; a quorum needs two nodes of each
+// of more than two thirds of the organizations
+std::vector<PublicKey>
+addCore(QuorumMap& qmap, size_t orgs)
+{
+    auto nodes = makeNodes(orgs * 3);
+    auto qSet = std::make_shared<SCPQuorumSet>();
+    qSet->threshold = uint32(orgs * 2 / 3 + 1);
+    for (size_t i = 0; i < orgs; ++i)
+    {
+        SCPQuorumSet org;
+        org.threshold = 2;
+        for (size_t j = 0; j < 3; ++j)
+        {
+            org.validators.emplace_back(nodes[i * 3 + j]);
+        }
+        qSet->innerSets.emplace_back(org);
+    }
+    for (auto const& n : nodes)
+    {
+        qmap[n] = qSet;
+    }
+    return nodes;
+}
+
+// nodes that follow `core` without being part of it
+void
+addWatchers(QuorumMap& qmap, std::vector<PublicKey> const& core, size_t n)
+{
+    auto qSet = qmap.at(core.front());
+    for (auto const& w : makeNodes(n))
+    {
+        qmap[w] = qSet;
+    }
+}
+
+bool
+disjoint(std::vector<NodeID> const& a, std::vector<NodeID> const& b)
+{
+    using xdr::operator<;
+    std::set<NodeID> nodes(a.begin(), a.end());
+    for (auto const& n : b)
+    {
+        if (nodes.find(n) != nodes.end())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// checked with the SCP code rather than the checker's compiled quorum sets
+bool
+isQuorum(QuorumMap const& qmap, std::vector<NodeID> const& nodes)
+{
+    if (nodes.empty())
+    {
+        return false;
+    }
+    for (auto const& n : nodes)
+    {
+        auto it = qmap.find(n);
+        if (it == qmap.end() || !it->second ||
+            !LocalNode::isQuorumSlice(*it->second, nodes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+TEST_CASE("quorum intersection of more than 64 nodes",
+          "[herder][quorumintersection]")
+{
+    QuorumMap qmap;
+    auto core = addCore(qmap, 7);
+    addWatchers(qmap, core, 50);
+
+    SECTION("one core intersects")
+    {
+        QuorumIntersectionChecker checker(qmap);
+        auto res = checker.check(1, std::chrono::seconds(0));
+        REQUIRE(res.mStatus ==
+                QuorumIntersectionChecker::QUORUM_INTERSECTION_OK);
+        REQUIRE(res.mNodes == 71);
+        REQUIRE(res.mComponents == 51);
+        REQUIRE(res.mQuorumComponents == 1);
+    }
+
+    SECTION("two cores are split")
+    {
+        auto other = addCore(qmap, 7);
+        addWatchers(qmap, other, 50);
+
+        QuorumIntersectionChecker checker(qmap);
+        auto res = checker.check(1, std::chrono::seconds(0));
+        REQUIRE(res.mStatus ==
+                QuorumIntersectionChecker::QUORUM_INTERSECTION_SPLIT);
+        REQUIRE(res.mQuorumComponents == 2);
+        REQUIRE(isQuorum(qmap, res.mQuorumA));
+        REQUIRE(isQuorum(qmap, res.mQuorumB));
+        REQUIRE(disjoint(res.mQuorumA, res.mQuorumB));
+    }
+
+    SECTION("nodes with no known quorum set are left out")
+    {
+        for (auto const& n : makeNodes(10))
+        {
+            qmap[n] = nullptr;
+        }
+        QuorumIntersectionChecker checker(qmap);
+        auto res = checker.check(1, std::chrono::seconds(0));
+        REQUIRE(res.mStatus ==
+                QuorumIntersectionChecker::QUORUM_INTERSECTION_OK);
+        REQUIRE(res.mNodes == 71);
+    }
+
+    SECTION("a cancelled check stops")
+    {
+        QuorumIntersectionChecker checker(qmap);
+        checker.cancel();
+        auto res = checker.check(4, std::chrono::seconds(0));
+        REQUIRE(res.mStatus ==
+                QuorumIntersectionChecker::QUORUM_INTERSECTION_CANCELLED);
+    }
+}
+
+TEST_CASE("quorum intersection split within a component",
+          "[herder][quorumintersection]")
+{
+    // each node needs two of the five others: any three nodes are a quorum
+    QuorumMap qmap;
+    auto nodes = makeNodes(6);
+    for (auto const& n : nodes)
+    {
+        auto qSet = std::make_shared<SCPQuorumSet>();
+        qSet->threshold = 2;
+        for (auto const& v : nodes)
+        {
+            if (!(v == n))
+            {
+                qSet->validators.emplace_back(v);
+            }
+        }
+        qmap[n] = qSet;
+    }
+
+    QuorumIntersectionChecker checker(qmap);
+    auto res = checker.check(4, std::chrono::seconds(0));
+    REQUIRE(res.mStatus == QuorumIntersectionChecker::QUORUM_INTERSECTION_SPLIT);
+    REQUIRE(res.mComponents == 1);
+    REQUIRE(res.mQuorumA.size() == 3);
+    REQUIRE(res.mQuorumB.size() == 3);
+    REQUIRE(isQuorum(qmap, res.mQuorumA));
+    REQUIRE(isQuorum(qmap, res.mQuorumB));
+    REQUIRE(disjoint(res.mQuorumA, res.mQuorumB));
+    REQUIRE(checker.getExplored() > 0);
+}
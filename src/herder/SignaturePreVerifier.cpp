@@ -0,0 +1,163 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/SignaturePreVerifier.h"
+#include "crypto/KeyUtils.h"
+#include "crypto/SecretKey.h"
+#include "crypto/SignerKey.h"
+#include "database/Database.h"
+#include "ledger/EntryFrame.h"
+#include "main/Application.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "transactions/OperationFrame.h"
+#include "transactions/SignatureUtils.h"
+#include "util/Timer.h"
+#include <atomic>
+#include <set>
+
+namespace stellar
+{
+
+// Number of triples verified by one worker task.
+static size_t const PREVERIFY_CHUNK_SIZE = 32;
+
+SignaturePreVerifier::SignaturePreVerifier(Application& app)
+    : mApp(app)
+    , mQueue(std::make_shared<Queue>())
+    , mSignatureMeter(app.getMetrics().NewMeter(
+          {"herder", "preverify", "signature"}, "signature"))
+{
+}
+
+void
+SignaturePreVerifier::Queue::drain()
+{
+    while (!mBatches.empty() && mBatches.front()->mVerified)
+    {
+        auto batch = mBatches.front();
+        mBatches.pop_front();
+        batch->mDone();
+    }
+}
+
+void
+SignaturePreVerifier::collect(TransactionFramePtr const& tx,
+                              std::vector<Triple>& triples)
+{
+    using xdr::operator<;
+
+    auto const& sigs = tx->getEnvelope().signatures;
+    if (sigs.empty())
+    {
+        return;
+    }
+
+    std::set<AccountID> accounts;
+    accounts.insert(tx->getSourceID());
+    for (auto const& op : tx->getOperations())
+    {
+        accounts.insert(op->getSourceID());
+    }
+
+    std::set<PublicKey> keys;
+    auto& db = mApp.getDatabase();
+    for (auto const& id : accounts)
+    {
+        keys.insert(id);
+        // Only look at accounts that are already cached: validation loads
+        // the account right after anyway, and a query here would double the
+        // main thread's database work for each transaction.
+        LedgerKey key(ACCOUNT);
+        key.account().accountID = id;
+        std::shared_ptr<LedgerEntry const> account;
+        if (!EntryFrame::getCachedEntry(key, account, db) || !account)
+        {
+            continue;
+        }
+        for (auto const& s : account->data.account().signers)
+        {
+            if (s.key.type() == SIGNER_KEY_TYPE_ED25519)
+            {
+                keys.insert(KeyUtils::convertKey<PublicKey>(s.key));
+            }
+        }
+    }
+
+    for (auto const& sig : sigs)
+    {
+        if (sig.signature.size() != 64)
+        {
+            continue;
+        }
+        for (auto const& k : keys)
+        {
+            if (SignatureUtils::doesHintMatch(k.ed25519(), sig.hint))
+            {
+                triples.emplace_back(
+                    Triple{k, sig.signature, tx->getContentsHash()});
+            }
+        }
+    }
+}
+
+void
+SignaturePreVerifier::verifyThen(std::vector<TransactionFramePtr> const& txs,
+                                 std::function<void()> done)
+{
+    auto triples = std::make_shared<std::vector<Triple>>();
+    for (auto const& tx : txs)
+    {
+        collect(tx, *triples);
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->mDone = done;
+
+    if (triples->empty())
+    {
+        batch->mVerified = true;
+        mQueue->mBatches.emplace_back(batch);
+        mQueue->drain();
+        return;
+    }
+
+    mQueue->mBatches.emplace_back(batch);
+    mSignatureMeter.Mark(triples->size());
+
+    size_t nChunks =
+        (triples->size() + PREVERIFY_CHUNK_SIZE - 1) / PREVERIFY_CHUNK_SIZE;
+    auto remaining = std::make_shared<std::atomic<size_t>>(nChunks);
+    std::weak_ptr<Queue> weakQueue = mQueue;
+    auto& mainIO = mApp.getClock().getIOService();
+
+    for (size_t i = 0; i < nChunks; ++i)
+    {
+        size_t begin = i * PREVERIFY_CHUNK_SIZE;
+        size_t end = std::min(begin + PREVERIFY_CHUNK_SIZE, triples->size());
+        mApp.getWorkerIOService().post([triples, begin, end, remaining,
+                                        weakQueue, batch, &mainIO]() {
+            std::vector<PubKeyUtils::VerifySigItem> items;
+            items.reserve(end - begin);
+            for (size_t j = begin; j < end; ++j)
+            {
+                auto const& t = (*triples)[j];
+                items.push_back({t.mKey, t.mSignature, t.mHash});
+            }
+            PubKeyUtils::verifySigsCached(items);
+            if (--*remaining == 0)
+            {
+                mainIO.post([weakQueue, batch]() {
+                    auto queue = weakQueue.lock();
+                    if (queue)
+                    {
+                        batch->mVerified = true;
+                        queue->drain();
+                    }
+                });
+            }
+        });
+    }
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrame.h"
+#include "util/NonCopyable.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+class Application;
+
+/**
+ * Warms the process-wide signature verify cache for transactions that are
+ * about to be validated on the main thread.
+ *
+ * For each transaction, the (key, signature, contents hash) triples that
+ * SignatureChecker will try are collected on the main thread: every Ed25519
+ * signature is paired with each candidate key whose hint matches, where the
+ * candidates are the source accounts of the transaction and its operations
+ * and, for those accounts already in the entry cache, their Ed25519 signers.
+ * Collecting never queries the database; signatures by the signers of an
+ * account that is not cached are left to validation to verify.
+ *
+ * The triples are then verified in chunks on the worker threads. Each
+ * signature is still checked on its own; a chunk only shares the verify
+ * cache's locking (see PubKeyUtils::verifySigsCached). Once all of a
+ * batch's chunks are done, its completion callback runs on the main
+ * thread. Callbacks run in submission order, so handing transactions on
+ * from the callbacks keeps their arrival order.
+ */
+class SignaturePreVerifier : NonMovableOrCopyable
+{
+  public:
+    explicit SignaturePreVerifier(Application& app);
+
+    // Verify the signatures of `txs` in the background, then call `done` on
+    // the main thread. `done` may be called before this returns if there
+    // is nothing to verify and nothing queued ahead of it.
+    void verifyThen(std::vector<TransactionFramePtr> const& txs,
+                    std::function<void()> done);
+
+  private:
+    struct Triple
+    {
+        PublicKey mKey;
+        Signature mSignature;
+        Hash mHash;
+    };
+
+    struct Batch
+    {
+        std::function<void()> mDone;
+        bool mVerified{false};
+    };
+
+    struct Queue
+    {
+        std::deque<std::shared_ptr<Batch>> mBatches;
+        void drain();
+    };
+
+    Application& mApp;
+    std::shared_ptr<Queue> mQueue;
+    medida::Meter& mSignatureMeter;
+
+    void collect(TransactionFramePtr const& tx, std::vector<Triple>& triples);
+};
+}
@@ -4,12 +4,16 @@
 
 #include "bucket/BucketManager.h"
 #include "catchup/CatchupWorkTests.h"
+#include "catchup/VerifyLedgerChainWork.h"
+#include "crypto/SHA.h"
+#include "history/FileTransferInfo.h"
 #include "history/HistoryManager.h"
 #include "history/HistoryTestsUtils.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
 #include "historywork/GunzipFileWork.h"
 #include "historywork/GzipFileWork.h"
 #include "historywork/PutHistoryArchiveStateWork.h"
+#include "ledger/LedgerHeaderFrame.h"
 #include "ledger/LedgerManager.h"
 #include "main/ExternalQueue.h"
 #include "main/PersistentState.h"
@@ -17,10 +21,16 @@
 #include "test/TestUtils.h"
 #include "test/test.h"
 #include "util/Fs.h"
+#include "util/Gzip.h"
+#include "util/TmpDir.h"
+#include "util/XDRStream.h"
 #include "work/WorkManager.h"
 
+#include <fstream>
 #include <lib/catch.hpp>
 #include <lib/util/format.h>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
 
 using namespace stellar;
 using namespace historytestutils;
@@ -68,6 +78,82 @@ TEST_CASE("HistoryManager::compress", "[history]")
     REQUIRE(!fs::exists(compressed));
 }
 
+TEST_CASE("HistoryManager::compress in process", "[history]")
+{
+    CatchupSimulation catchupSimulation{};
+
+    std::string s;
+    for (int i = 0; i < 100000; ++i)
+    {
+        s += std::to_string(i);
+    }
+    HistoryManager& hm = catchupSimulation.getApp().getHistoryManager();
+    std::string fname = hm.localFilename("compressme");
+    {
+        std::ofstream out(fname, std::ofstream::binary);
+        out.write(s.data(), s.size());
+    }
+    std::string compressed = fname + ".gz";
+    auto& wm = catchupSimulation.getApp().getWorkManager();
+
+    SECTION("decompressing hashes the output")
+    {
+        auto g = wm.executeWork<GzipFileWork>(true, fname, true);
+        REQUIRE(g->getState() == Work::WORK_SUCCESS);
+        REQUIRE(fs::exists(fname));
+        std::remove(fname.c_str());
+
+        optional<uint256> hash;
+        auto u = wm.executeWork<GunzipFileWork>(true, compressed, true,
+                                                Work::RETRY_NEVER, &hash);
+        REQUIRE(u->getState() == Work::WORK_SUCCESS);
+        REQUIRE(fs::exists(compressed));
+        REQUIRE(hash);
+        REQUIRE(*hash == sha256(s));
+
+        std::ifstream in(fname, std::ifstream::binary);
+        std::string decompressed((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+        REQUIRE(decompressed == s);
+    }
+
+    SECTION("concatenated members decompress like gzip -d")
+    {
+        gzip::compressFile(fname, compressed);
+        std::string part = fname + ".part.gz";
+        gzip::compressFile(fname, part);
+        {
+            std::ofstream out(compressed,
+                              std::ofstream::binary | std::ofstream::app);
+            std::ifstream in(part, std::ifstream::binary);
+            out << in.rdbuf();
+        }
+        gzip::decompressFile(compressed, fname);
+        std::ifstream in(fname, std::ifstream::binary);
+        std::string decompressed((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+        REQUIRE(decompressed == s + s);
+    }
+
+    SECTION("truncated input fails")
+    {
+        gzip::compressFile(fname, compressed);
+        std::string truncated = fname + ".truncated.gz";
+        {
+            std::ifstream in(compressed, std::ifstream::binary);
+            std::string data((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+            std::ofstream out(truncated, std::ofstream::binary);
+            out.write(data.data(), data.size() / 2);
+        }
+        REQUIRE_THROWS_AS(gzip::decompressFile(truncated, fname),
+                          std::runtime_error);
+
+        auto u = wm.executeWork<GunzipFileWork>(true, truncated);
+        REQUIRE(u->getState() != Work::WORK_SUCCESS);
+    }
+}
+
 TEST_CASE("HistoryArchiveState::get_put", "[history]")
 {
     CatchupSimulation catchupSimulation{};
@@ -166,6 +252,175 @@ TEST_CASE("Full history catchup", "[history][historycatchup]")
     }
 }
 
+TEST_CASE("Full history catchup with pipeline window",
+          "[history][historycatchup][catchuppipeline]")
+{
+    CatchupSimulation catchupSimulation{};
+
+    catchupSimulation.generateAndPublishInitialHistory(5);
+    auto initLedger =
+        catchupSimulation.getApp().getLedgerManager().getLastClosedLedgerNum();
+
+    // window of 1 applies each checkpoint while at most the next one is
+    // downloaded; a large window downloads everything up front
+    int instance = 0;
+    for (uint32_t window : {1u, 1000u})
+    {
+        auto cfg = getTestConfig(++instance);
+        cfg.CATCHUP_COMPLETE = true;
+        cfg.CATCHUP_PIPELINE_WINDOW = window;
+        auto app = createTestApplication(
+            catchupSimulation.getClock(),
+            catchupSimulation.getHistoryConfigurator().configure(cfg, false));
+        app->start();
+        REQUIRE(catchupSimulation.catchupApplication(
+            initLedger, std::numeric_limits<uint32_t>::max(), false, app));
+
+        // every downloaded checkpoint was applied exactly once
+        auto& download = app->getMetrics().NewMeter(
+            {"history", "download-transactions", "success"}, "event");
+        auto& apply = app->getMetrics().NewMeter(
+            {"history", "catchup-pipeline", "apply"}, "checkpoint");
+        REQUIRE(apply.count() > 0);
+        REQUIRE(apply.count() == download.count());
+
+        // and its transactions file deleted from the download directory
+        // right after
+        auto& deleted = app->getMetrics().NewMeter(
+            {"history", "catchup-pipeline", "delete"}, "checkpoint");
+        REQUIRE(deleted.count() == apply.count());
+    }
+}
+
+TEST_CASE("Ledger chain verification fails on bad checkpoint files",
+          "[history][verifyledgerchain]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    app->start();
+
+    auto& hm = app->getHistoryManager();
+    auto first = hm.checkpointContainingLedger(2);
+    auto second = first + hm.getCheckpointFrequency();
+    auto dir = app->getTmpDirManager().tmpDir("verify-chain");
+
+    // a valid chain of headers for ledgers 1 to `second`
+    std::vector<LedgerHeaderHistoryEntry> chain;
+    Hash prev;
+    for (uint32_t seq = 1; seq <= second; ++seq)
+    {
+        LedgerHeaderHistoryEntry e;
+        e.header.ledgerSeq = seq;
+        e.header.previousLedgerHash = prev;
+        e.header.scpValue.closeTime = seq;
+        e.hash = LedgerHeaderFrame(e.header).getHash();
+        prev = e.hash;
+        chain.emplace_back(e);
+    }
+
+    auto writeCheckpoint = [&](uint32_t checkpoint) {
+        FileTransferInfo ft(dir, HISTORY_FILE_TYPE_LEDGER, checkpoint);
+        XDROutputFileStream out;
+        out.open(ft.localPath_nogz());
+        for (auto const& e : chain)
+        {
+            if (hm.checkpointContainingLedger(e.header.ledgerSeq) ==
+                checkpoint)
+            {
+                out.writeOne(e);
+            }
+        }
+        out.close();
+        return ft.localPath_nogz();
+    };
+    writeCheckpoint(first);
+
+    auto& metrics = app->getMetrics();
+    auto& chainSuccess = metrics.NewMeter(
+        {"history", "verify-ledger-chain", "success"}, "event");
+    auto& chainFailure = metrics.NewMeter(
+        {"history", "verify-ledger-chain", "failure"}, "event");
+    auto& linkFailure =
+        metrics.NewMeter({"history", "verify-ledger", "failure-link"}, "event");
+
+    // files are read and hashed on the worker threads; a file that cannot
+    // be read must fail verification of its checkpoint like a bad hash does
+    LedgerHeaderHistoryEntry firstVerified, lastVerified;
+    auto verify = [&]() {
+        auto w = app->getWorkManager().executeWork<VerifyLedgerChainWork>(
+            true, dir, LedgerRange{2, second}, false, firstVerified,
+            lastVerified);
+        REQUIRE(w->getState() != Work::WORK_SUCCESS);
+        // only the second checkpoint is bad
+        REQUIRE(chainSuccess.count() == 1);
+        REQUIRE(lastVerified.header.ledgerSeq == first);
+    };
+
+    SECTION("missing checkpoint file")
+    {
+        verify();
+        REQUIRE(chainFailure.count() == 1);
+        REQUIRE(linkFailure.count() == 0);
+    }
+
+    SECTION("truncated checkpoint file")
+    {
+        auto path = writeCheckpoint(second);
+        std::string data;
+        {
+            std::ifstream in(path, std::ifstream::binary);
+            data.assign(std::istreambuf_iterator<char>(in),
+                        std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream out(path, std::ofstream::binary |
+                                        std::ofstream::trunc);
+            out.write(data.data(), data.size() - 8);
+        }
+        verify();
+        REQUIRE(chainFailure.count() == 1);
+        REQUIRE(linkFailure.count() == 0);
+    }
+
+    SECTION("corrupt checkpoint file")
+    {
+        // a header that no longer matches its hash
+        chain[second - 3].header.scpValue.closeTime++;
+        writeCheckpoint(second);
+        verify();
+        REQUIRE(linkFailure.count() == 1);
+    }
+}
+
+TEST_CASE("Catchup recent with newest-first bucket apply",
+          "[history][catchuprecent][bucketapply]")
+{
+    CatchupSimulation catchupSimulation{};
+
+    catchupSimulation.generateAndPublishInitialHistory(3);
+    auto initLedger =
+        catchupSimulation.getApp().getLedgerManager().getLastClosedLedgerNum();
+
+    auto cfg = getTestConfig(1);
+    cfg.CATCHUP_RECENT = 0;
+    cfg.CATCHUP_APPLY_BUCKETS_NEWEST_FIRST = true;
+    auto app = createTestApplication(
+        catchupSimulation.getClock(),
+        catchupSimulation.getHistoryConfigurator().configure(cfg, false));
+    app->start();
+    REQUIRE(catchupSimulation.catchupApplication(initLedger, 0, false, app));
+
+    // far enough ahead that only some levels differ and are applied again
+    catchupSimulation.generateAndPublishHistory(25);
+    initLedger =
+        catchupSimulation.getApp().getLedgerManager().getLastClosedLedgerNum();
+    REQUIRE(catchupSimulation.catchupApplication(initLedger, 80, false, app));
+
+    auto& applied = app->getMetrics().NewMeter(
+        {"history", "bucket-apply", "success"}, "event");
+    REQUIRE(applied.count() > 0);
+}
+
 TEST_CASE("History publish queueing", "[history][historydelay][historycatchup]")
 {
     CatchupSimulation catchupSimulation{};
@@ -8,6 +8,7 @@
 #include "main/Config.h"
 #include "overlay/StellarXDR.h"
 #include "util/HashOfHash.h"
+#include <chrono>
 #include <string>
 #include <unordered_map>
 
@@ -25,6 +26,11 @@ struct InferredQuorum
     void notePubKey(PublicKey const& pk);
     std::string toString(Config const& cfg) const;
     void writeQuorumGraph(Config const& cfg, std::ostream& out) const;
-    bool checkQuorumIntersection(Config const& cfg) const;
+    // Returns true if every two quorums of the nodes that have a known qset
+    // intersect; see QuorumIntersectionChecker for the meaning of the other
+    // arguments. A check that runs out of time returns false.
+    bool checkQuorumIntersection(
+        Config const& cfg, size_t parallelism = 1,
+        std::chrono::seconds budget = std::chrono::seconds(0)) const;
 };
 }
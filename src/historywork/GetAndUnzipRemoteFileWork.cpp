@@ -13,12 +13,14 @@ namespace stellar
 
 GetAndUnzipRemoteFileWork::GetAndUnzipRemoteFileWork(
     Application& app, WorkParent& parent, FileTransferInfo ft,
-    std::shared_ptr<HistoryArchive const> archive, size_t maxRetries)
+    std::shared_ptr<HistoryArchive const> archive, size_t maxRetries,
+    optional<uint256>* decompressedHash)
     : Work(app, parent,
            std::string("get-and-unzip-remote-file ") + ft.remoteName(),
            maxRetries)
     , mFt(std::move(ft))
     , mArchive(archive)
+    , mDecompressedHash(decompressedHash)
 {
 }
 
@@ -50,6 +52,10 @@ GetAndUnzipRemoteFileWork::onReset()
     clearChildren();
     mGetRemoteFileWork.reset();
     mGunzipFileWork.reset();
+    if (mDecompressedHash)
+    {
+        *mDecompressedHash = nullopt<uint256>();
+    }
 
     CLOG(DEBUG, "History") << "Downloading and unzipping " << mFt.remoteName()
                            << ": downloading";
@@ -111,8 +117,8 @@ GetAndUnzipRemoteFileWork::onSuccess()
 
     CLOG(DEBUG, "History") << "Downloading and unzipping " << mFt.remoteName()
                            << ": unzipping";
-    mGunzipFileWork =
-        addWork<GunzipFileWork>(mFt.localPath_gz(), false, RETRY_NEVER);
+    mGunzipFileWork = addWork<GunzipFileWork>(mFt.localPath_gz(), false,
+                                              RETRY_NEVER, mDecompressedHash);
     return WORK_PENDING;
 }
 
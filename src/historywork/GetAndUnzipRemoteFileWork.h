@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "util/optional.h"
 #include "work/Work.h"
 
 #include "history/FileTransferInfo.h"
@@ -20,15 +21,17 @@ class GetAndUnzipRemoteFileWork : public Work
 
     FileTransferInfo mFt;
     std::shared_ptr<HistoryArchive const> mArchive;
+    optional<uint256>* mDecompressedHash;
 
   public:
     // Passing `nullptr` for the archive argument will cause the work to
     // select a new readable history archive at random each time it runs /
-    // retries.
+    // retries. See GunzipFileWork for `decompressedHash`.
     GetAndUnzipRemoteFileWork(
         Application& app, WorkParent& parent, FileTransferInfo ft,
         std::shared_ptr<HistoryArchive const> archive = nullptr,
-        size_t maxRetries = Work::RETRY_A_LOT);
+        size_t maxRetries = Work::RETRY_A_LOT,
+        optional<uint256>* decompressedHash = nullptr);
     ~GetAndUnzipRemoteFileWork();
     std::string getStatus() const override;
     void onReset() override;
@@ -3,18 +3,23 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "historywork/GunzipFileWork.h"
+#include "crypto/SHA.h"
+#include "main/Application.h"
 #include "util/Fs.h"
+#include "util/Gzip.h"
+#include "util/Logging.h"
 
 namespace stellar
 {
 
 GunzipFileWork::GunzipFileWork(Application& app, WorkParent& parent,
                                std::string const& filenameGz, bool keepExisting,
-                               size_t maxRetries)
-    : RunCommandWork(app, parent, std::string("gunzip-file ") + filenameGz,
-                     maxRetries)
+                               size_t maxRetries,
+                               optional<uint256>* decompressedHash)
+    : Work(app, parent, std::string("gunzip-file ") + filenameGz, maxRetries)
     , mFilenameGz(filenameGz)
     , mKeepExisting(keepExisting)
+    , mDecompressedHash(decompressedHash)
 {
     fs::checkGzipSuffix(mFilenameGz);
 }
@@ -25,21 +30,71 @@ GunzipFileWork::~GunzipFileWork()
 }
 
 void
-GunzipFileWork::getCommand(std::string& cmdLine, std::string& outFile)
+GunzipFileWork::onReset()
 {
-    cmdLine = "gzip -d ";
-    if (mKeepExisting)
+    std::string filenameNoGz = mFilenameGz.substr(0, mFilenameGz.size() - 3);
+    std::remove(filenameNoGz.c_str());
+    if (mDecompressedHash)
     {
-        cmdLine += "-c ";
-        outFile = mFilenameGz.substr(0, mFilenameGz.size() - 3);
+        *mDecompressedHash = nullopt<uint256>();
     }
-    cmdLine += mFilenameGz;
 }
 
 void
-GunzipFileWork::onReset()
+GunzipFileWork::onStart()
 {
-    std::string filenameNoGz = mFilenameGz.substr(0, mFilenameGz.size() - 3);
-    std::remove(filenameNoGz.c_str());
+    std::string filenameGz = mFilenameGz;
+    bool keepExisting = mKeepExisting;
+    bool wantHash = mDecompressedHash != nullptr;
+    Application& app = this->mApp;
+    std::weak_ptr<GunzipFileWork> weak(
+        std::static_pointer_cast<GunzipFileWork>(shared_from_this()));
+    auto handler = callComplete();
+    app.getWorkerIOService().post([&app, filenameGz, keepExisting, wantHash,
+                                   weak, handler]() {
+        asio::error_code ec;
+        auto hash = make_optional<uint256>();
+        try
+        {
+            std::unique_ptr<SHA256> hasher;
+            if (wantHash)
+            {
+                hasher = SHA256::create();
+            }
+            std::string filenameNoGz =
+                filenameGz.substr(0, filenameGz.size() - 3);
+            gzip::decompressFile(filenameGz, filenameNoGz, hasher.get());
+            if (hasher)
+            {
+                *hash = hasher->finish();
+            }
+            if (!keepExisting)
+            {
+                std::remove(filenameGz.c_str());
+            }
+        }
+        catch (std::exception const& e)
+        {
+            CLOG(WARNING, "History")
+                << "FAILED decompressing " << filenameGz << ": " << e.what();
+            ec = std::make_error_code(std::errc::io_error);
+        }
+        app.getClock().getIOService().post([ec, handler, weak, hash]() {
+            // the hash is published before completion, so the parent sees
+            // it by the time it runs
+            auto self = weak.lock();
+            if (self && !ec && self->mDecompressedHash)
+            {
+                *self->mDecompressedHash = hash;
+            }
+            handler(ec);
+        });
+    });
+}
+
+void
+GunzipFileWork::onRun()
+{
+    // Do nothing: we spawned the decompression in onStart().
 }
 }
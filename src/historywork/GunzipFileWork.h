@@ -4,22 +4,35 @@
 
 #pragma once
 
-#include "historywork/RunCommandWork.h"
+#include "util/optional.h"
+#include "work/Work.h"
+#include "xdr/Stellar-types.h"
 
 namespace stellar
 {
 
-class GunzipFileWork : public RunCommandWork
+// Decompresses a .gz file next to itself, on a worker thread; the .gz file
+// is removed unless `keepExisting` is set.
+//
+// If `decompressedHash` is given, the decompressed bytes are hashed as they
+// are written and the hash is stored there once the work succeeds (it is
+// cleared when the work resets), so that whoever verifies the file does not
+// need to read it again. It must outlive the work, as a parent's member
+// does.
+class GunzipFileWork : public Work
 {
     std::string mFilenameGz;
     bool mKeepExisting;
-    void getCommand(std::string& cmdLine, std::string& outFile) override;
+    optional<uint256>* mDecompressedHash;
 
   public:
     GunzipFileWork(Application& app, WorkParent& parent,
                    std::string const& filenameGz, bool keepExisting = false,
-                   size_t maxRetries = Work::RETRY_NEVER);
+                   size_t maxRetries = Work::RETRY_NEVER,
+                   optional<uint256>* decompressedHash = nullptr);
     ~GunzipFileWork();
     void onReset() override;
+    void onStart() override;
+    void onRun() override;
 };
 }
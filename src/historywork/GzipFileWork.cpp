@@ -3,14 +3,17 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "historywork/GzipFileWork.h"
+#include "main/Application.h"
 #include "util/Fs.h"
+#include "util/Gzip.h"
+#include "util/Logging.h"
 
 namespace stellar
 {
 
 GzipFileWork::GzipFileWork(Application& app, WorkParent& parent,
                            std::string const& filenameNoGz, bool keepExisting)
-    : RunCommandWork(app, parent, std::string("gzip-file ") + filenameNoGz)
+    : Work(app, parent, std::string("gzip-file ") + filenameNoGz)
     , mFilenameNoGz(filenameNoGz)
     , mKeepExisting(keepExisting)
 {
@@ -30,14 +33,37 @@ GzipFileWork::onReset()
 }
 
 void
-GzipFileWork::getCommand(std::string& cmdLine, std::string& outFile)
+GzipFileWork::onStart()
 {
-    cmdLine = "gzip ";
-    if (mKeepExisting)
-    {
-        cmdLine += "-c ";
-        outFile = mFilenameNoGz + ".gz";
-    }
-    cmdLine += mFilenameNoGz;
+    std::string filenameNoGz = mFilenameNoGz;
+    bool keepExisting = mKeepExisting;
+    Application& app = this->mApp;
+    auto handler = callComplete();
+    app.getWorkerIOService().post(
+        [&app, filenameNoGz, keepExisting, handler]() {
+            asio::error_code ec;
+            try
+            {
+                gzip::compressFile(filenameNoGz, filenameNoGz + ".gz");
+                if (!keepExisting)
+                {
+                    std::remove(filenameNoGz.c_str());
+                }
+            }
+            catch (std::exception const& e)
+            {
+                CLOG(WARNING, "History") << "FAILED compressing "
+                                         << filenameNoGz << ": " << e.what();
+                ec = std::make_error_code(std::errc::io_error);
+            }
+            app.getClock().getIOService().post(
+                [ec, handler]() { handler(ec); });
+        });
+}
+
+void
+GzipFileWork::onRun()
+{
+    // Do nothing: we spawned the compression in onStart().
 }
 }
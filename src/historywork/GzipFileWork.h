@@ -4,21 +4,24 @@
 
 #pragma once
 
-#include "historywork/RunCommandWork.h"
+#include "work/Work.h"
 
 namespace stellar
 {
 
-class GzipFileWork : public RunCommandWork
+// Compresses a file into a .gz file next to it, on a worker thread; the
+// original is removed unless `keepExisting` is set.
+class GzipFileWork : public Work
 {
     std::string mFilenameNoGz;
     bool mKeepExisting;
-    void getCommand(std::string& cmdLine, std::string& outFile) override;
 
   public:
     GzipFileWork(Application& app, WorkParent& parent,
                  std::string const& filenameNoGz, bool keepExisting = false);
     ~GzipFileWork();
     void onReset() override;
+    void onStart() override;
+    void onRun() override;
 };
 }
@@ -45,7 +45,8 @@ RepairMissingBucketsWork::onReset()
         // Each bucket gets its own work-chain of download->gunzip->verify
         auto verify = addWork<VerifyBucketWork>(mBuckets, ft.localPath_nogz(),
                                                 hexToBin256(hash));
-        verify->addWork<GetAndUnzipRemoteFileWork>(ft);
+        verify->addWork<GetAndUnzipRemoteFileWork>(
+            ft, nullptr, Work::RETRY_A_LOT, verify->getDecompressedHashSink());
     }
 }
 
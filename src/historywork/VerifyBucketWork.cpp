@@ -39,6 +39,28 @@ VerifyBucketWork::~VerifyBucketWork()
     clearChildren();
 }
 
+optional<uint256>*
+VerifyBucketWork::getDecompressedHashSink()
+{
+    return &mDecompressedHash;
+}
+
+static asio::error_code
+checkHash(std::string const& filename, uint256 const& hash,
+          uint256 const& vHash)
+{
+    if (vHash == hash)
+    {
+        CLOG(DEBUG, "History")
+            << "Verified hash (" << hexAbbrev(hash) << ") for " << filename;
+        return asio::error_code();
+    }
+    CLOG(WARNING, "History") << "FAILED verifying hash for " << filename;
+    CLOG(WARNING, "History") << "expected hash: " << binToHex(hash);
+    CLOG(WARNING, "History") << "computed hash: " << binToHex(vHash);
+    return std::make_error_code(std::errc::io_error);
+}
+
 void
 VerifyBucketWork::onStart()
 {
@@ -46,6 +68,15 @@ VerifyBucketWork::onStart()
     uint256 hash = mHash;
     Application& app = this->mApp;
     auto handler = callComplete();
+
+    if (mDecompressedHash)
+    {
+        // hashed while decompressing: nothing to read
+        auto ec = checkHash(filename, hash, *mDecompressedHash);
+        app.getClock().getIOService().post([ec, handler]() { handler(ec); });
+        return;
+    }
+
     app.getWorkerIOService().post([&app, filename, handler, hash]() {
         auto hasher = SHA256::create();
         asio::error_code ec;
@@ -59,21 +90,7 @@ VerifyBucketWork::onStart()
                 in.read(buf, sizeof(buf));
                 hasher->add(ByteSlice(buf, in.gcount()));
             }
-            uint256 vHash = hasher->finish();
-            if (vHash == hash)
-            {
-                CLOG(DEBUG, "History") << "Verified hash (" << hexAbbrev(hash)
-                                       << ") for " << filename;
-            }
-            else
-            {
-                CLOG(WARNING, "History")
-                    << "FAILED verifying hash for " << filename;
-                CLOG(WARNING, "History") << "expected hash: " << binToHex(hash);
-                CLOG(WARNING, "History")
-                    << "computed hash: " << binToHex(vHash);
-                ec = std::make_error_code(std::errc::io_error);
-            }
+            ec = checkHash(filename, hash, hasher->finish());
         }
         app.getClock().getIOService().post([ec, handler]() { handler(ec); });
     });
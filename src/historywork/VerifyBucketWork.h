@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "util/optional.h"
 #include "work/Work.h"
 #include "xdr/Stellar-types.h"
 
@@ -22,6 +23,7 @@ class VerifyBucketWork : public Work
     std::map<std::string, std::shared_ptr<Bucket>>& mBuckets;
     std::string mBucketFile;
     uint256 mHash;
+    optional<uint256> mDecompressedHash;
 
     medida::Meter& mVerifyBucketSuccess;
     medida::Meter& mVerifyBucketFailure;
@@ -31,6 +33,12 @@ class VerifyBucketWork : public Work
                      std::map<std::string, std::shared_ptr<Bucket>>& buckets,
                      std::string const& bucketFile, uint256 const& hash);
     ~VerifyBucketWork();
+
+    // Where the GunzipFileWork producing the bucket file, if any, leaves the
+    // hash of what it decompressed; when it is there, the file is not read
+    // again.
+    optional<uint256>* getDecompressedHashSink();
+
     void onRun() override;
     void onStart() override;
     Work::State onSuccess() override;
@@ -143,7 +143,7 @@ getHistoryArchiveState(Application::pointer appGenerate,
     {
         auto& level = blGenerate.getLevel(i);
         {
-            BucketOutputIterator out(bmApply.getTmpDir(), true);
+            BucketOutputIterator out(bmApply.getTmpDir(), true, false);
             for (BucketInputIterator in (level.getCurr()); in; ++in)
             {
                 out.put(*in);
@@ -151,7 +151,7 @@ getHistoryArchiveState(Application::pointer appGenerate,
             out.getBucket(bmApply);
         }
         {
-            BucketOutputIterator out(bmApply.getTmpDir(), true);
+            BucketOutputIterator out(bmApply.getTmpDir(), true, false);
             for (BucketInputIterator in (level.getSnap()); in; ++in)
             {
                 out.put(*in);
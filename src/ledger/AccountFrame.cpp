@@ -15,6 +15,7 @@
 #include "util/basen.h"
 #include "util/types.h"
 #include <algorithm>
+#include <map>
 
 using namespace soci;
 using namespace std;
@@ -213,9 +214,9 @@ AccountFrame::loadAccount(AccountID const& accountID, Database& db)
     LedgerKey key;
     key.type(ACCOUNT);
     key.account().accountID = accountID;
-    if (cachedEntryExists(key, db))
+    std::shared_ptr<LedgerEntry const> p;
+    if (getCachedEntry(key, p, db))
     {
-        auto p = getCachedEntry(key, db);
         return p ? std::make_shared<AccountFrame>(*p) : nullptr;
     }
 
@@ -282,6 +283,136 @@ AccountFrame::loadAccount(AccountID const& accountID, Database& db)
     return res;
 }
 
+void
+AccountFrame::prefetch(std::vector<AccountID> const& accountIDs, Database& db)
+{
+    std::map<std::string, AccountID> wanted;
+    for (auto const& id : accountIDs)
+    {
+        LedgerKey key;
+        key.type(ACCOUNT);
+        key.account().accountID = id;
+        if (!db.getEntryCache().exists(key))
+        {
+            wanted.emplace(KeyUtils::toStrKey(id), id);
+        }
+    }
+    if (wanted.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> ids;
+    for (auto const& w : wanted)
+    {
+        ids.emplace_back(w.first);
+    }
+
+    std::map<std::string, AccountFrame::pointer> loaded;
+    std::vector<std::string> withSigners;
+    {
+        std::string actIDStrKey, inflationDest, homeDomain, thresholds;
+        soci::indicator inflationDestInd;
+        AccountEntry account;
+        uint32_t lastModified;
+
+        selectByIDs(
+            db,
+            "SELECT accountid, balance, seqnum, numsubentries, inflationdest, "
+            "homedomain, thresholds, flags, lastmodified "
+            "FROM accounts WHERE accountid",
+            ids, [&](StatementContext& prep) {
+                auto& st = prep.statement();
+                st.exchange(into(actIDStrKey));
+                st.exchange(into(account.balance));
+                st.exchange(into(account.seqNum));
+                st.exchange(into(account.numSubEntries));
+                st.exchange(into(inflationDest, inflationDestInd));
+                st.exchange(into(homeDomain));
+                st.exchange(into(thresholds));
+                st.exchange(into(account.flags));
+                st.exchange(into(lastModified));
+                st.define_and_bind();
+                {
+                    auto timer = db.getSelectTimer("account");
+                    st.execute(true);
+                }
+                while (st.got_data())
+                {
+                    auto res = make_shared<AccountFrame>(
+                        wanted.at(actIDStrKey));
+                    auto& a = res->getAccount();
+                    a.balance = account.balance;
+                    a.seqNum = account.seqNum;
+                    a.numSubEntries = account.numSubEntries;
+                    a.flags = account.flags;
+                    a.homeDomain = homeDomain;
+                    bn::decode_b64(thresholds.begin(), thresholds.end(),
+                                   a.thresholds.begin());
+                    if (inflationDestInd == soci::i_ok)
+                    {
+                        a.inflationDest.activate() =
+                            KeyUtils::fromStrKey<PublicKey>(inflationDest);
+                    }
+                    res->getLastModified() = lastModified;
+                    if (a.numSubEntries != 0)
+                    {
+                        withSigners.emplace_back(actIDStrKey);
+                    }
+                    loaded.emplace(actIDStrKey, res);
+                    st.fetch();
+                }
+            });
+    }
+
+    {
+        std::string actIDStrKey, pubKey;
+        Signer signer;
+
+        auto loadSigners = [&](StatementContext& prep) {
+            auto& st = prep.statement();
+            st.exchange(into(actIDStrKey));
+            st.exchange(into(pubKey));
+            st.exchange(into(signer.weight));
+            st.define_and_bind();
+            {
+                auto timer = db.getSelectTimer("signer");
+                st.execute(true);
+            }
+            while (st.got_data())
+            {
+                signer.key = KeyUtils::fromStrKey<SignerKey>(pubKey);
+                loaded.at(actIDStrKey)->getAccount().signers.push_back(signer);
+                st.fetch();
+            }
+        };
+        selectByIDs(db,
+                    "SELECT accountid, publickey, weight FROM signers "
+                    "WHERE accountid",
+                    withSigners, loadSigners);
+    }
+
+    for (auto const& w : wanted)
+    {
+        auto it = loaded.find(w.first);
+        if (it == loaded.end())
+        {
+            LedgerKey key;
+            key.type(ACCOUNT);
+            key.account().accountID = w.second;
+            putCachedEntry(key, nullptr, db);
+            continue;
+        }
+        auto& res = it->second;
+        auto& signers = res->getAccount().signers;
+        std::sort(signers.begin(), signers.end(), &AccountFrame::signerCompare);
+        res->normalize();
+        res->mUpdateSigners = false;
+        res->mKeyCalculated = false;
+        res->putCachedEntry(db);
+    }
+}
+
 std::vector<Signer>
 AccountFrame::loadSigners(Database& db, std::string const& actIDStrKey)
 {
@@ -315,7 +446,8 @@ AccountFrame::loadSigners(Database& db, std::string const& actIDStrKey)
 bool
 AccountFrame::exists(Database& db, LedgerKey const& key)
 {
-    if (cachedEntryExists(key, db) && getCachedEntry(key, db) != nullptr)
+    std::shared_ptr<LedgerEntry const> p;
+    if (getCachedEntry(key, p, db) && p != nullptr)
     {
         return true;
     }
@@ -358,11 +490,7 @@ void
 AccountFrame::deleteAccountsModifiedOnOrAfterLedger(Database& db,
                                                     uint32_t oldestLedger)
 {
-    db.getEntryCache().erase_if(
-        [oldestLedger](std::shared_ptr<LedgerEntry const> le) -> bool {
-            return le && le->data.type() == ACCOUNT &&
-                   le->lastModifiedLedgerSeq >= oldestLedger;
-        });
+    db.getEntryCache().eraseModifiedOnOrAfter(ACCOUNT, oldestLedger);
 
     {
         auto prep = db.getPreparedStatement(
@@ -383,6 +511,214 @@ AccountFrame::deleteAccountsModifiedOnOrAfterLedger(Database& db,
     }
 }
 
+void
+AccountFrame::storeUpsertBulk(Database& db,
+                              std::vector<LedgerEntry> const& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> ids, inflationDests, homeDomains, thresholds;
+    std::vector<soci::indicator> inflationDestInds;
+    std::vector<int64_t> balances, seqNums;
+    std::vector<uint32_t> numSubEntries, flags, lastModifieds;
+    std::vector<std::string> signerIDs, signerKeys;
+    std::vector<uint32_t> signerWeights;
+
+    for (auto const& e : entries)
+    {
+        flushCachedEntry(LedgerEntryKey(e), db);
+
+        auto const& a = e.data.account();
+        ids.emplace_back(KeyUtils::toStrKey(a.accountID));
+        balances.emplace_back(a.balance);
+        seqNums.emplace_back(a.seqNum);
+        numSubEntries.emplace_back(a.numSubEntries);
+        if (a.inflationDest)
+        {
+            inflationDests.emplace_back(KeyUtils::toStrKey(*a.inflationDest));
+            inflationDestInds.emplace_back(soci::i_ok);
+        }
+        else
+        {
+            inflationDests.emplace_back();
+            inflationDestInds.emplace_back(soci::i_null);
+        }
+        homeDomains.emplace_back(a.homeDomain);
+        thresholds.emplace_back(bn::encode_b64(a.thresholds));
+        flags.emplace_back(a.flags);
+        lastModifieds.emplace_back(e.lastModifiedLedgerSeq);
+
+        for (auto const& s : a.signers)
+        {
+            signerIDs.emplace_back(ids.back());
+            signerKeys.emplace_back(KeyUtils::toStrKey(s.key));
+            signerWeights.emplace_back(s.weight);
+        }
+    }
+
+    if (db.isSqlite())
+    {
+        {
+            auto prep = db.getPreparedStatement(
+                "INSERT OR REPLACE INTO accounts ( accountid, balance, "
+                "seqnum, numsubentries, inflationdest, homedomain, "
+                "thresholds, flags, lastmodified ) "
+                "VALUES ( :id, :v1, :v2, :v3, :v4, :v5, :v6, :v7, :v8 )");
+            auto& st = prep.statement();
+            st.exchange(use(ids));
+            st.exchange(use(balances));
+            st.exchange(use(seqNums));
+            st.exchange(use(numSubEntries));
+            st.exchange(use(inflationDests, inflationDestInds));
+            st.exchange(use(homeDomains));
+            st.exchange(use(thresholds));
+            st.exchange(use(flags));
+            st.exchange(use(lastModifieds));
+            st.define_and_bind();
+            auto timer = db.getUpsertTimer("account");
+            st.execute(true);
+        }
+        {
+            auto prep = db.getPreparedStatement(
+                "DELETE FROM signers WHERE accountid = :id");
+            auto& st = prep.statement();
+            st.exchange(use(ids));
+            st.define_and_bind();
+            auto timer = db.getDeleteTimer("signer");
+            st.execute(true);
+        }
+        if (!signerIDs.empty())
+        {
+            auto prep = db.getPreparedStatement(
+                "INSERT INTO signers (accountid, publickey, weight) "
+                "VALUES (:v1, :v2, :v3)");
+            auto& st = prep.statement();
+            st.exchange(use(signerIDs));
+            st.exchange(use(signerKeys));
+            st.exchange(use(signerWeights));
+            st.define_and_bind();
+            auto timer = db.getInsertTimer("signer");
+            st.execute(true);
+        }
+    }
+    else
+    {
+        std::string strIDs = toPostgresArray(ids);
+        {
+            std::string strBalances = toPostgresArray(balances);
+            std::string strSeqNums = toPostgresArray(seqNums);
+            std::string strNumSubEntries = toPostgresArray(numSubEntries);
+            std::string strInflationDests =
+                toPostgresArray(inflationDests, &inflationDestInds);
+            std::string strHomeDomains = toPostgresArray(homeDomains);
+            std::string strThresholds = toPostgresArray(thresholds);
+            std::string strFlags = toPostgresArray(flags);
+            std::string strLastModifieds = toPostgresArray(lastModifieds);
+
+            auto prep = db.getPreparedStatement(
+                "INSERT INTO accounts ( accountid, balance, seqnum, "
+                "numsubentries, inflationdest, homedomain, thresholds, flags, "
+                "lastmodified ) "
+                "SELECT * FROM unnest(:id::TEXT[], :v1::BIGINT[], "
+                ":v2::BIGINT[], :v3::INT[], :v4::TEXT[], :v5::TEXT[], "
+                ":v6::TEXT[], :v7::INT[], :v8::INT[]) "
+                "ON CONFLICT (accountid) DO UPDATE SET "
+                "balance = excluded.balance, seqnum = excluded.seqnum, "
+                "numsubentries = excluded.numsubentries, "
+                "inflationdest = excluded.inflationdest, "
+                "homedomain = excluded.homedomain, "
+                "thresholds = excluded.thresholds, flags = excluded.flags, "
+                "lastmodified = excluded.lastmodified");
+            auto& st = prep.statement();
+            st.exchange(use(strIDs));
+            st.exchange(use(strBalances));
+            st.exchange(use(strSeqNums));
+            st.exchange(use(strNumSubEntries));
+            st.exchange(use(strInflationDests));
+            st.exchange(use(strHomeDomains));
+            st.exchange(use(strThresholds));
+            st.exchange(use(strFlags));
+            st.exchange(use(strLastModifieds));
+            st.define_and_bind();
+            auto timer = db.getUpsertTimer("account");
+            st.execute(true);
+        }
+        {
+            auto prep = db.getPreparedStatement(
+                "DELETE FROM signers WHERE accountid = ANY(:id::TEXT[])");
+            auto& st = prep.statement();
+            st.exchange(use(strIDs));
+            st.define_and_bind();
+            auto timer = db.getDeleteTimer("signer");
+            st.execute(true);
+        }
+        if (!signerIDs.empty())
+        {
+            std::string strSignerIDs = toPostgresArray(signerIDs);
+            std::string strSignerKeys = toPostgresArray(signerKeys);
+            std::string strSignerWeights = toPostgresArray(signerWeights);
+            auto prep = db.getPreparedStatement(
+                "INSERT INTO signers (accountid, publickey, weight) "
+                "SELECT * FROM unnest(:v1::TEXT[], :v2::TEXT[], :v3::INT[])");
+            auto& st = prep.statement();
+            st.exchange(use(strSignerIDs));
+            st.exchange(use(strSignerKeys));
+            st.exchange(use(strSignerWeights));
+            st.define_and_bind();
+            auto timer = db.getInsertTimer("signer");
+            st.execute(true);
+        }
+    }
+}
+
+void
+AccountFrame::storeDeleteBulk(Database& db, std::vector<LedgerKey> const& keys)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> ids;
+    for (auto const& k : keys)
+    {
+        flushCachedEntry(k, db);
+        ids.emplace_back(KeyUtils::toStrKey(k.account().accountID));
+    }
+
+    if (db.isSqlite())
+    {
+        for (auto const& sql : {"DELETE FROM accounts WHERE accountid = :id",
+                                "DELETE FROM signers WHERE accountid = :id"})
+        {
+            auto prep = db.getPreparedStatement(sql);
+            auto& st = prep.statement();
+            st.exchange(use(ids));
+            st.define_and_bind();
+            auto timer = db.getDeleteTimer("account");
+            st.execute(true);
+        }
+    }
+    else
+    {
+        std::string strIDs = toPostgresArray(ids);
+        for (auto const& sql :
+             {"DELETE FROM accounts WHERE accountid = ANY(:id::TEXT[])",
+              "DELETE FROM signers WHERE accountid = ANY(:id::TEXT[])"})
+        {
+            auto prep = db.getPreparedStatement(sql);
+            auto& st = prep.statement();
+            st.exchange(use(strIDs));
+            st.define_and_bind();
+            auto timer = db.getDeleteTimer("account");
+            st.execute(true);
+        }
+    }
+}
+
 void
 AccountFrame::storeDelete(LedgerDelta& delta, Database& db) const
 {
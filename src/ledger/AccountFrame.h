@@ -125,11 +125,20 @@ class AccountFrame : public EntryFrame
     static void deleteAccountsModifiedOnOrAfterLedger(Database& db,
                                                       uint32_t oldestLedger);
 
+    static void storeUpsertBulk(Database& db,
+                                std::vector<LedgerEntry> const& entries);
+    static void storeDeleteBulk(Database& db,
+                                std::vector<LedgerKey> const& keys);
+
     // database utilities
     static AccountFrame::pointer
     loadAccount(LedgerDelta& delta, AccountID const& accountID, Database& db);
     static AccountFrame::pointer loadAccount(AccountID const& accountID,
                                              Database& db);
+    // loads the accounts that are not cached yet into the entry cache, with
+    // their signers, in a few bulk queries (see EntryFrame::prefetch)
+    static void prefetch(std::vector<AccountID> const& accountIDs,
+                         Database& db);
 
     // compare signers, ignores weight
     static bool signerCompare(Signer const& s1, Signer const& s2);
@@ -191,11 +191,7 @@ void
 DataFrame::deleteDataModifiedOnOrAfterLedger(Database& db,
                                              uint32_t oldestLedger)
 {
-    db.getEntryCache().erase_if(
-        [oldestLedger](std::shared_ptr<LedgerEntry const> le) -> bool {
-            return le && le->data.type() == DATA &&
-                   le->lastModifiedLedgerSeq >= oldestLedger;
-        });
+    db.getEntryCache().eraseModifiedOnOrAfter(DATA, oldestLedger);
 
     {
         auto prep = db.getPreparedStatement(
@@ -207,6 +203,113 @@ DataFrame::deleteDataModifiedOnOrAfterLedger(Database& db,
     }
 }
 
+void
+DataFrame::storeUpsertBulk(Database& db,
+                           std::vector<LedgerEntry> const& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> actIDs, dataNames, dataValues;
+    std::vector<uint32_t> lastModifieds;
+
+    for (auto const& e : entries)
+    {
+        flushCachedEntry(LedgerEntryKey(e), db);
+
+        auto const& d = e.data.data();
+        actIDs.emplace_back(KeyUtils::toStrKey(d.accountID));
+        dataNames.emplace_back(d.dataName);
+        dataValues.emplace_back(bn::encode_b64(d.dataValue));
+        lastModifieds.emplace_back(e.lastModifiedLedgerSeq);
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep = db.getPreparedStatement(
+            "INSERT OR REPLACE INTO accountdata "
+            "(accountid,dataname,datavalue,lastmodified)"
+            " VALUES (:aid,:dn,:dv,:lm)");
+        auto& st = prep.statement();
+        st.exchange(use(actIDs));
+        st.exchange(use(dataNames));
+        st.exchange(use(dataValues));
+        st.exchange(use(lastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("data");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strActIDs = toPostgresArray(actIDs);
+        std::string strDataNames = toPostgresArray(dataNames);
+        std::string strDataValues = toPostgresArray(dataValues);
+        std::string strLastModifieds = toPostgresArray(lastModifieds);
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO accountdata "
+            "(accountid,dataname,datavalue,lastmodified) "
+            "SELECT * FROM unnest(:aid::TEXT[], :dn::TEXT[], :dv::TEXT[], "
+            ":lm::INT[]) "
+            "ON CONFLICT (accountid, dataname) DO UPDATE SET "
+            "datavalue = excluded.datavalue, "
+            "lastmodified = excluded.lastmodified");
+        auto& st = prep.statement();
+        st.exchange(use(strActIDs));
+        st.exchange(use(strDataNames));
+        st.exchange(use(strDataValues));
+        st.exchange(use(strLastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("data");
+        st.execute(true);
+    }
+}
+
+void
+DataFrame::storeDeleteBulk(Database& db, std::vector<LedgerKey> const& keys)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> actIDs, dataNames;
+    for (auto const& k : keys)
+    {
+        flushCachedEntry(k, db);
+        actIDs.emplace_back(KeyUtils::toStrKey(k.data().accountID));
+        dataNames.emplace_back(k.data().dataName);
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM accountdata WHERE accountid=:id AND dataname=:s");
+        auto& st = prep.statement();
+        st.exchange(use(actIDs));
+        st.exchange(use(dataNames));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("data");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strActIDs = toPostgresArray(actIDs);
+        std::string strDataNames = toPostgresArray(dataNames);
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM accountdata USING "
+            "unnest(:id::TEXT[], :s::TEXT[]) AS x(a, n) "
+            "WHERE accountid = x.a AND dataname = x.n");
+        auto& st = prep.statement();
+        st.exchange(use(strActIDs));
+        st.exchange(use(strDataNames));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("data");
+        st.execute(true);
+    }
+}
+
 void
 DataFrame::storeDelete(LedgerDelta& delta, Database& db) const
 {
@@ -74,6 +74,11 @@ class DataFrame : public EntryFrame
     static void deleteDataModifiedOnOrAfterLedger(Database& db,
                                                   uint32_t oldestLedger);
 
+    static void storeUpsertBulk(Database& db,
+                                std::vector<LedgerEntry> const& entries);
+    static void storeDeleteBulk(Database& db,
+                                std::vector<LedgerKey> const& keys);
+
     // database utilities
     static pointer loadData(AccountID const& accountID, std::string dataName,
                             Database& db);
@@ -4,7 +4,6 @@
 
 #include "ledger/EntryFrame.h"
 #include "LedgerManager.h"
-#include "crypto/Hex.h"
 #include "database/Database.h"
 #include "ledger/AccountFrame.h"
 #include "ledger/DataFrame.h"
@@ -13,11 +12,16 @@
 #include "ledger/TrustFrame.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/printer.h"
+#include <algorithm>
 
 namespace stellar
 {
 using xdr::operator==;
 
+// number of ids selectByIDs binds per query on SQLite, which has no array
+// parameters
+static size_t const SELECT_BY_IDS_BATCH_SIZE = 64;
+
 EntryFrame::pointer
 EntryFrame::FromXDR(LedgerEntry const& from)
 {
@@ -77,6 +81,75 @@ EntryFrame::storeLoad(LedgerKey const& key, Database& db)
     return res;
 }
 
+void
+EntryFrame::prefetch(std::vector<LedgerKey> const& keys, Database& db)
+{
+    std::vector<AccountID> accounts;
+    std::vector<LedgerKey> trustLines;
+    for (auto const& key : keys)
+    {
+        switch (key.type())
+        {
+        case ACCOUNT:
+            accounts.emplace_back(key.account().accountID);
+            break;
+        case TRUSTLINE:
+            trustLines.emplace_back(key);
+            break;
+        default:
+            break;
+        }
+    }
+    AccountFrame::prefetch(accounts, db);
+    TrustFrame::prefetch(trustLines, db);
+}
+
+void
+EntryFrame::selectByIDs(Database& db, std::string const& select,
+                        std::vector<std::string> const& ids,
+                        std::function<void(StatementContext&)> const& load)
+{
+    if (ids.empty())
+    {
+        return;
+    }
+
+    if (!db.isSqlite())
+    {
+        std::string strIDs = toPostgresArray(ids);
+        auto prep = db.getPreparedStatement(select + " = ANY(:ids::TEXT[])");
+        prep.statement().exchange(soci::use(strIDs));
+        load(prep);
+        return;
+    }
+
+    // every batch has the same number of parameters, so that they all share
+    // one prepared statement: the last one repeats its last id
+    std::string query = select + " IN (";
+    for (size_t i = 0; i < SELECT_BY_IDS_BATCH_SIZE; ++i)
+    {
+        query += (i == 0 ? ":id" : ", :id") + std::to_string(i);
+    }
+    query += ")";
+
+    std::vector<std::string> batch(SELECT_BY_IDS_BATCH_SIZE);
+    for (size_t first = 0; first < ids.size();
+         first += SELECT_BY_IDS_BATCH_SIZE)
+    {
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            batch[i] = ids[std::min(first + i, ids.size() - 1)];
+        }
+        auto prep = db.getPreparedStatement(query);
+        auto& st = prep.statement();
+        for (auto& id : batch)
+        {
+            st.exchange(soci::use(id));
+        }
+        load(prep);
+    }
+}
+
 uint32
 EntryFrame::getLastModified() const
 {
@@ -109,30 +182,38 @@ EntryFrame::touch(LedgerDelta const& delta)
 void
 EntryFrame::flushCachedEntry(LedgerKey const& key, Database& db)
 {
-    auto s = binToHex(xdr::xdr_to_opaque(key));
-    db.getEntryCache().erase_if_exists(s);
+    db.getEntryCache().erase(key);
 }
 
 bool
 EntryFrame::cachedEntryExists(LedgerKey const& key, Database& db)
 {
-    auto s = binToHex(xdr::xdr_to_opaque(key));
-    return db.getEntryCache().exists(s);
+    return db.getEntryCache().exists(key);
 }
 
 std::shared_ptr<LedgerEntry const>
 EntryFrame::getCachedEntry(LedgerKey const& key, Database& db)
 {
-    auto s = binToHex(xdr::xdr_to_opaque(key));
-    return db.getEntryCache().get(s);
+    std::shared_ptr<LedgerEntry const> p;
+    if (!db.getEntryCache().get(key, p))
+    {
+        throw std::range_error("There is no such key in cache");
+    }
+    return p;
+}
+
+bool
+EntryFrame::getCachedEntry(LedgerKey const& key,
+                           std::shared_ptr<LedgerEntry const>& p, Database& db)
+{
+    return db.getEntryCache().get(key, p);
 }
 
 void
 EntryFrame::putCachedEntry(LedgerKey const& key,
                            std::shared_ptr<LedgerEntry const> p, Database& db)
 {
-    auto s = binToHex(xdr::xdr_to_opaque(key));
-    db.getEntryCache().put(s, p);
+    db.getEntryCache().put(key, std::move(p));
 }
 
 void
@@ -7,6 +7,9 @@
 #include "bucket/LedgerCmp.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
+#include <functional>
+#include <string>
+#include <vector>
 
 /*
 Frame
@@ -19,6 +22,7 @@ namespace stellar
 {
 class Database;
 class LedgerDelta;
+class StatementContext;
 
 class EntryFrame : public NonMovableOrCopyable
 {
@@ -31,6 +35,15 @@ class EntryFrame : public NonMovableOrCopyable
         mKeyCalculated = false;
     }
 
+    // Runs `select`, a query ending in "WHERE <column>", completed with a
+    // condition that <column> is one of `ids`. `load` binds the results,
+    // then executes the statement and fetches its rows; it may be called
+    // several times, for batches of `ids`.
+    static void
+    selectByIDs(Database& db, std::string const& select,
+                std::vector<std::string> const& ids,
+                std::function<void(StatementContext&)> const& load);
+
   public:
     typedef std::shared_ptr<EntryFrame> pointer;
 
@@ -42,11 +55,22 @@ class EntryFrame : public NonMovableOrCopyable
     static pointer FromXDR(LedgerEntry const& from);
     static pointer storeLoad(LedgerKey const& key, Database& db);
 
+    // Loads the entries of `keys` that are not cached yet into the entry
+    // cache with a few bulk queries, so that loading them afterwards does
+    // not go to the database. Only accounts and trust lines are loaded,
+    // other keys are ignored.
+    static void prefetch(std::vector<LedgerKey> const& keys, Database& db);
+
     // Static helpers for working with the DB LedgerEntry cache.
     static void flushCachedEntry(LedgerKey const& key, Database& db);
     static bool cachedEntryExists(LedgerKey const& key, Database& db);
     static std::shared_ptr<LedgerEntry const>
     getCachedEntry(LedgerKey const& key, Database& db);
+    // Single-probe variant: returns false on a cache miss, otherwise sets
+    // `p` to the cached entry (nullptr for a key known not to exist).
+    static bool getCachedEntry(LedgerKey const& key,
+                               std::shared_ptr<LedgerEntry const>& p,
+                               Database& db);
     static void putCachedEntry(LedgerKey const& key,
                                std::shared_ptr<LedgerEntry const> p,
                                Database& db);
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "ledger/LedgerDelta.h"
+#include "database/Database.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "medida/meter.h"
@@ -244,14 +245,47 @@ LedgerDelta::rollback()
     for (auto& d : mDelete)
     {
         EntryFrame::flushCachedEntry(d, mDb);
+        rollbackOrderBook(d, false);
     }
     for (auto& n : mNew)
     {
         EntryFrame::flushCachedEntry(n.first, mDb);
+        rollbackOrderBook(n.first, true);
     }
     for (auto& m : mMod)
     {
         EntryFrame::flushCachedEntry(m.first, mDb);
+        rollbackOrderBook(m.first, false);
+    }
+}
+
+void
+LedgerDelta::rollbackOrderBook(LedgerKey const& key, bool isNew)
+{
+    if (key.type() != OFFER)
+    {
+        return;
+    }
+
+    // undo what this delta wrote...
+    auto& book = mDb.getOrderBook();
+    book.erase(key.offer().offerID);
+
+    if (isNew)
+    {
+        return;
+    }
+
+    // ...by restoring what was there before it
+    auto it = mPrevious.find(key);
+    if (it != mPrevious.end())
+    {
+        book.put(it->second->mEntry);
+    }
+    else
+    {
+        // we don't know where it was, so we can't tell which pair is stale
+        book.clear();
     }
 }
 
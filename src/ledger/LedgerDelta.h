@@ -37,7 +37,8 @@ class LedgerDelta
     std::set<LedgerKey, LedgerEntryIdCmp> mDelete;
     KeyEntryMap mPrevious;
 
-    Database& mDb; // Used strictly for rollback of db entry cache.
+    Database& mDb; // Used strictly for rollback of db entry cache and
+                   // order book.
 
     bool mUpdateLastModified;
 
@@ -47,6 +48,9 @@ class LedgerDelta
     void modEntry(EntryFrame::pointer entry);
     void recordEntry(EntryFrame::pointer entry);
 
+    // invalidates the order book pairs a rolled back offer change touched
+    void rollbackOrderBook(LedgerKey const& key, bool isNew);
+
     // merge "other" into current ledgerDelta
     void mergeEntries(LedgerDelta& other);
 
@@ -274,4 +274,86 @@ TEST_CASE("Ledger Entry tests", "[ledgerentry]")
         app->getLedgerManager().checkDbState();
     }
 }
+
+TEST_CASE("Prefetch accounts and trust lines", "[ledgerentry][prefetch]")
+{
+    Config cfg(getTestConfig(0));
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    app->start();
+    Database& db = app->getDatabase();
+
+    LedgerHeader lh;
+    LedgerDelta delta(lh, db, false);
+
+    // more accounts than one SQLite batch of selectByIDs
+    std::vector<AccountFrame::pointer> accounts;
+    std::vector<TrustFrame::pointer> lines;
+    std::vector<LedgerKey> keys;
+    for (int i = 0; i < 100; i++)
+    {
+        LedgerEntry le;
+        le.data.type(ACCOUNT);
+        le.data.account() = LedgerTestUtils::generateValidAccountEntry(5);
+        le.data.account().numSubEntries =
+            static_cast<uint32>(le.data.account().signers.size()) + 1;
+        auto af = std::make_shared<AccountFrame>(le);
+        af->storeAdd(delta, db);
+        accounts.emplace_back(af);
+        keys.emplace_back(af->getKey());
+
+        LedgerEntry tle;
+        tle.data.type(TRUSTLINE);
+        tle.data.trustLine() = LedgerTestUtils::generateValidTrustLineEntry(5);
+        tle.data.trustLine().accountID = af->getID();
+        auto tf = std::make_shared<TrustFrame>(tle);
+        tf->storeAdd(delta, db);
+        lines.emplace_back(tf);
+        keys.emplace_back(tf->getKey());
+    }
+
+    LedgerKey missingAccount(ACCOUNT);
+    missingAccount.account().accountID = PubKeyUtils::random();
+    keys.emplace_back(missingAccount);
+
+    LedgerKey missingLine = lines.front()->getKey();
+    missingLine.trustLine().asset =
+        LedgerTestUtils::generateValidTrustLineEntry(5).asset;
+    keys.emplace_back(missingLine);
+
+    db.getEntryCache().clear();
+    EntryFrame::prefetch(keys, db);
+
+    for (auto const& key : keys)
+    {
+        REQUIRE(EntryFrame::cachedEntryExists(key, db));
+    }
+
+    for (auto const& af : accounts)
+    {
+        auto fromCache = AccountFrame::loadAccount(af->getID(), db);
+        REQUIRE(fromCache);
+        REQUIRE(fromCache->getAccount() == af->getAccount());
+    }
+    for (auto const& tf : lines)
+    {
+        auto const& tl = tf->getTrustLine();
+        auto fromCache = TrustFrame::loadTrustLine(tl.accountID, tl.asset, db);
+        REQUIRE(fromCache);
+        REQUIRE(fromCache->getTrustLine() == tl);
+    }
+    REQUIRE(!AccountFrame::loadAccount(missingAccount.account().accountID,
+                                       db));
+    REQUIRE(!TrustFrame::loadTrustLine(missingLine.trustLine().accountID,
+                                       missingLine.trustLine().asset, db));
+
+    // what was prefetched is what loading from the database gives
+    db.getEntryCache().clear();
+    for (auto const& af : accounts)
+    {
+        auto fromDb = AccountFrame::loadAccount(af->getID(), db);
+        REQUIRE(fromDb->getAccount() == af->getAccount());
+    }
+}
 }
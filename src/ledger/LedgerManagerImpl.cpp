@@ -727,6 +727,21 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     // sorted such that sequence numbers are respected
     vector<TransactionFramePtr> txs = ledgerData.getTxSet()->sortForApply();
 
+    // load the accounts and trust lines the set is known to touch with a few
+    // bulk queries rather than one query each while applying. A set touching
+    // more than the cache can hold would only evict its own entries.
+    {
+        std::vector<LedgerKey> keys;
+        for (auto& tx : txs)
+        {
+            tx->insertLedgerKeysToPrefetch(keys);
+        }
+        if (keys.size() <= getDatabase().getEntryCache().maxSize() / 2)
+        {
+            EntryFrame::prefetch(keys, getDatabase());
+        }
+    }
+
     // first, charge fees
     processFeesSeqNums(txs, ledgerDelta);
 
@@ -889,13 +904,18 @@ LedgerManagerImpl::processFeesSeqNums(std::vector<TransactionFramePtr>& txs,
     try
     {
         soci::transaction sqlTx(mApp.getDatabase().getSession());
+        std::vector<TransactionFrame::FeeHistoryRow> rows;
+        rows.reserve(txs.size());
         for (auto tx : txs)
         {
             LedgerDelta thisTxDelta(delta);
             tx->processFeeSeqNum(thisTxDelta, *this);
-            tx->storeTransactionFee(*this, thisTxDelta.getChanges(), ++index);
+            tx->addFeeHistoryRow(thisTxDelta.getChanges(), rows);
+            ++index;
             thisTxDelta.commit();
         }
+        TransactionFrame::storeFeeHistoryRows(
+            mApp, mCurrentLedger->mHeader.ledgerSeq, rows);
         sqlTx.commit();
     }
     catch (std::exception& e)
@@ -914,6 +934,10 @@ LedgerManagerImpl::applyTransactions(std::vector<TransactionFramePtr>& txs,
     CLOG(DEBUG, "Tx") << "applyTransactions: ledger = "
                       << mCurrentLedger->mHeader.ledgerSeq;
     int index = 0;
+    // history rows are encoded and written for the whole ledger at once,
+    // within the ledger's database transaction
+    std::vector<TransactionFrame::HistoryRow> rows;
+    rows.reserve(txs.size());
     for (auto tx : txs)
     {
         auto txTime = mTransactionApply.TimeScope();
@@ -951,8 +975,11 @@ LedgerManagerImpl::applyTransactions(std::vector<TransactionFramePtr>& txs,
             CLOG(ERROR, "Ledger") << "Unknown exception during tx->apply";
             tx->getResult().result.code(txINTERNAL_ERROR);
         }
-        tx->storeTransaction(*this, tm, ++index, txResultSet);
+        tx->addHistoryRow(std::move(tm), txResultSet, rows);
+        ++index;
     }
+    TransactionFrame::storeHistoryRows(mApp, mCurrentLedger->mHeader.ledgerSeq,
+                                       rows);
 }
 
 void
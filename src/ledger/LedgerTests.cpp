@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "LedgerTestUtils.h"
+#include "crypto/Hex.h"
 #include "database/Database.h"
 #include "ledger/AccountFrame.h"
 #include "ledger/EntryFrame.h"
@@ -11,12 +12,17 @@
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "test/TestAccount.h"
 #include "test/TestUtils.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
 #include "util/Timer.h"
+#include "util/basen.h"
 #include "util/types.h"
+#include <map>
 #include <xdrpp/autocheck.h>
+#include <xdrpp/marshal.h>
 
 using namespace stellar;
 
@@ -138,3 +144,90 @@ TEST_CASE("DB cache interaction with transactions", "[ledger][dbcache]")
 
     CHECK(balance0 == acc->getAccount().balance);
 }
+
+TEST_CASE("transaction history of a ledger is stored in apply order",
+          "[ledger][txhistory]")
+{
+    using namespace stellar::txtest;
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    app->start();
+
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("A", app->getLedgerManager().getMinBalance(0));
+
+    // enough transactions for the rows to be encoded in several chunks
+    std::vector<TransactionFramePtr> txs;
+    std::map<std::string, TransactionFramePtr> byID;
+    for (int i = 0; i < 50; ++i)
+    {
+        txs.emplace_back(root.tx({payment(a1, i + 1)}));
+        byID[binToHex(txs.back()->getContentsHash())] = txs.back();
+    }
+    uint32 ledgerSeq = app->getLedgerManager().getLedgerNum();
+    closeLedgerOn(*app, ledgerSeq, 1, 1, 2015, txs);
+
+    auto& sess = app->getDatabase().getSession();
+    std::string txID, txBody, txResult, txMeta, txChanges;
+    int txIndex;
+
+    // each row reads back as storing it on its own used to write it
+    std::vector<std::string> historyIDs;
+    soci::statement st =
+        (sess.prepare << "SELECT txid, txindex, txbody, txresult, txmeta "
+                         "FROM txhistory WHERE ledgerseq = :seq "
+                         "ORDER BY txindex",
+         soci::into(txID), soci::into(txIndex), soci::into(txBody),
+         soci::into(txResult), soci::into(txMeta), soci::use(ledgerSeq));
+    st.execute(true);
+    while (st.got_data())
+    {
+        REQUIRE(txIndex == static_cast<int>(historyIDs.size()) + 1);
+        auto it = byID.find(txID);
+        REQUIRE(it != byID.end());
+        auto const& tx = it->second;
+        REQUIRE(txBody ==
+                bn::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope())));
+        REQUIRE(txResult ==
+                bn::encode_b64(xdr::xdr_to_opaque(tx->getResultPair())));
+
+        std::vector<uint8_t> raw;
+        bn::decode_b64(txMeta, raw);
+        TransactionMeta tm;
+        xdr::xdr_from_opaque(raw, tm);
+        REQUIRE(tm.operations().size() ==
+                tx->getEnvelope().tx.operations.size());
+        REQUIRE(txMeta == bn::encode_b64(xdr::xdr_to_opaque(tm)));
+
+        historyIDs.emplace_back(txID);
+        st.fetch();
+    }
+    REQUIRE(historyIDs.size() == txs.size());
+
+    // fee rows follow the same order
+    size_t nFeeRows = 0;
+    soci::statement feeSt =
+        (sess.prepare << "SELECT txid, txindex, txchanges "
+                         "FROM txfeehistory WHERE ledgerseq = :seq "
+                         "ORDER BY txindex",
+         soci::into(txID), soci::into(txIndex), soci::into(txChanges),
+         soci::use(ledgerSeq));
+    feeSt.execute(true);
+    while (feeSt.got_data())
+    {
+        REQUIRE(txIndex == static_cast<int>(nFeeRows) + 1);
+        REQUIRE(txID == historyIDs[nFeeRows]);
+
+        std::vector<uint8_t> raw;
+        bn::decode_b64(txChanges, raw);
+        LedgerEntryChanges changes;
+        xdr::xdr_from_opaque(raw, changes);
+        REQUIRE(!changes.empty());
+        REQUIRE(txChanges == bn::encode_b64(xdr::xdr_to_opaque(changes)));
+
+        ++nFeeRows;
+        feeSt.fetch();
+    }
+    REQUIRE(nFeeRows == txs.size());
+}
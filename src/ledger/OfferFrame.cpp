@@ -241,9 +241,10 @@ OfferFrame::loadOffers(StatementContext& prep,
 }
 
 void
-OfferFrame::loadBestOffers(size_t numOffers, size_t offset,
-                           Asset const& selling, Asset const& buying,
-                           vector<OfferFrame::pointer>& retOffers, Database& db)
+OfferFrame::loadPairOffers(
+    Asset const& selling, Asset const& buying, size_t numOffers,
+    size_t offset, OrderBook::OfferRank const* after,
+    std::function<void(LedgerEntry const&)> offerProcessor, Database& db)
 {
     std::string sql = offerColumnSelector;
 
@@ -305,9 +306,22 @@ OfferFrame::loadBestOffers(size_t numOffers, size_t offset,
         sql += " AND buyingassetcode = :gcur AND buyingissuer = :gi";
     }
 
+    double afterPrice = 0;
+    uint64_t afterOfferID = 0;
+    if (after)
+    {
+        afterPrice = after->first;
+        afterOfferID = after->second;
+        sql += " AND (price > :ap OR (price = :ap2 AND offerid > :aid))";
+    }
+
     // price is an approximation of the actual n/d (truncated math, 15 digits)
     // ordering by offerid gives precendence to older offers for fairness
-    sql += " ORDER BY price, offerid LIMIT :n OFFSET :o";
+    sql += " ORDER BY price, offerid";
+    if (numOffers != 0)
+    {
+        sql += " LIMIT :n OFFSET :o";
+    }
 
     auto prep = db.getPreparedStatement(sql);
     auto& st = prep.statement();
@@ -324,13 +338,75 @@ OfferFrame::loadBestOffers(size_t numOffers, size_t offset,
         st.exchange(use(buyingIssuerStrKey));
     }
 
-    st.exchange(use(numOffers));
-    st.exchange(use(offset));
+    if (after)
+    {
+        st.exchange(use(afterPrice));
+        st.exchange(use(afterPrice));
+        st.exchange(use(afterOfferID));
+    }
+
+    if (numOffers != 0)
+    {
+        st.exchange(use(numOffers));
+        st.exchange(use(offset));
+    }
 
     auto timer = db.getSelectTimer("offer");
-    loadOffers(prep, [&retOffers](LedgerEntry const& of) {
-        retOffers.emplace_back(make_shared<OfferFrame>(of));
-    });
+    loadOffers(prep, offerProcessor);
+}
+
+void
+OfferFrame::loadBestOffers(size_t numOffers, size_t offset,
+                           Asset const& selling, Asset const& buying,
+                           vector<OfferFrame::pointer>& retOffers, Database& db)
+{
+    if (numOffers == 0)
+    {
+        return;
+    }
+    loadPairOffers(selling, buying, numOffers, offset, nullptr,
+                   [&retOffers](LedgerEntry const& of) {
+                       retOffers.emplace_back(make_shared<OfferFrame>(of));
+                   },
+                   db);
+}
+
+OfferFrame::pointer
+OfferFrame::loadNextBestOffer(Asset const& selling, Asset const& buying,
+                              OfferFrame const* after, Database& db)
+{
+    auto& book = db.getOrderBook();
+    auto pair = book.find(selling, buying);
+    for (;;)
+    {
+        if (pair)
+        {
+            auto const& offers = pair->mOffers;
+            auto it = after
+                          ? offers.upper_bound(OrderBook::rank(after->mOffer))
+                          : offers.begin();
+            if (it != offers.end())
+            {
+                return make_shared<OfferFrame>(it->second);
+            }
+            if (pair->mComplete)
+            {
+                return nullptr;
+            }
+        }
+
+        // everything up to the loaded part was looked at: load the next page
+        std::vector<LedgerEntry> page;
+        page.reserve(OrderBook::PAGE_SIZE);
+        loadPairOffers(selling, buying, OrderBook::PAGE_SIZE, 0,
+                       pair ? &pair->mLast : nullptr,
+                       [&page](LedgerEntry const& of) {
+                           page.emplace_back(of);
+                       },
+                       db);
+        bool complete = page.size() < OrderBook::PAGE_SIZE;
+        pair = &book.addPage(selling, buying, page, complete);
+    }
 }
 
 std::unordered_map<AccountID, std::vector<OfferFrame::pointer>>
@@ -389,11 +465,8 @@ void
 OfferFrame::deleteOffersModifiedOnOrAfterLedger(Database& db,
                                                 uint32_t oldestLedger)
 {
-    db.getEntryCache().erase_if(
-        [oldestLedger](std::shared_ptr<LedgerEntry const> le) -> bool {
-            return le && le->data.type() == OFFER &&
-                   le->lastModifiedLedgerSeq >= oldestLedger;
-        });
+    db.getEntryCache().eraseModifiedOnOrAfter(OFFER, oldestLedger);
+    db.getOrderBook().clear();
 
     {
         auto prep = db.getPreparedStatement(
@@ -405,6 +478,199 @@ OfferFrame::deleteOffersModifiedOnOrAfterLedger(Database& db,
     }
 }
 
+static soci::indicator
+assetFieldsForBulk(Asset const& asset, std::string& assetCode,
+                   std::string& issuerStrKey)
+{
+    if (asset.type() == ASSET_TYPE_CREDIT_ALPHANUM4)
+    {
+        assetCodeToStr(asset.alphaNum4().assetCode, assetCode);
+        issuerStrKey = KeyUtils::toStrKey(asset.alphaNum4().issuer);
+        return soci::i_ok;
+    }
+    else if (asset.type() == ASSET_TYPE_CREDIT_ALPHANUM12)
+    {
+        assetCodeToStr(asset.alphaNum12().assetCode, assetCode);
+        issuerStrKey = KeyUtils::toStrKey(asset.alphaNum12().issuer);
+        return soci::i_ok;
+    }
+    return soci::i_null;
+}
+
+void
+OfferFrame::storeUpsertBulk(Database& db,
+                            std::vector<LedgerEntry> const& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    size_t n = entries.size();
+    std::vector<std::string> sellerIDs;
+    std::vector<uint64_t> offerIDs;
+    std::vector<uint32_t> sellingTypes(n), buyingTypes(n);
+    std::vector<std::string> sellingCodes(n), sellingIssuers(n);
+    std::vector<std::string> buyingCodes(n), buyingIssuers(n);
+    std::vector<soci::indicator> sellingInds(n), buyingInds(n);
+    std::vector<int64_t> amounts;
+    std::vector<int32_t> priceNs, priceDs;
+    std::vector<double> prices;
+    std::vector<uint32_t> flags, lastModifieds;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto const& e = entries[i];
+        flushCachedEntry(LedgerEntryKey(e), db);
+        db.getOrderBook().put(e);
+
+        auto const& o = e.data.offer();
+        sellerIDs.emplace_back(KeyUtils::toStrKey(o.sellerID));
+        offerIDs.emplace_back(o.offerID);
+        sellingTypes[i] = o.selling.type();
+        sellingInds[i] =
+            assetFieldsForBulk(o.selling, sellingCodes[i], sellingIssuers[i]);
+        buyingTypes[i] = o.buying.type();
+        buyingInds[i] =
+            assetFieldsForBulk(o.buying, buyingCodes[i], buyingIssuers[i]);
+        amounts.emplace_back(o.amount);
+        priceNs.emplace_back(o.price.n);
+        priceDs.emplace_back(o.price.d);
+        prices.emplace_back(double(o.price.n) / double(o.price.d));
+        flags.emplace_back(o.flags);
+        lastModifieds.emplace_back(e.lastModifiedLedgerSeq);
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep = db.getPreparedStatement(
+            "INSERT OR REPLACE INTO offers (sellerid,offerid,"
+            "sellingassettype,sellingassetcode,sellingissuer,"
+            "buyingassettype,buyingassetcode,buyingissuer,"
+            "amount,pricen,priced,price,flags,lastmodified) VALUES "
+            "(:sid,:oid,:sat,:sac,:si,:bat,:bac,:bi,:a,:pn,:pd,:p,:f,:l)");
+        auto& st = prep.statement();
+        st.exchange(use(sellerIDs));
+        st.exchange(use(offerIDs));
+        st.exchange(use(sellingTypes));
+        st.exchange(use(sellingCodes, sellingInds));
+        st.exchange(use(sellingIssuers, sellingInds));
+        st.exchange(use(buyingTypes));
+        st.exchange(use(buyingCodes, buyingInds));
+        st.exchange(use(buyingIssuers, buyingInds));
+        st.exchange(use(amounts));
+        st.exchange(use(priceNs));
+        st.exchange(use(priceDs));
+        st.exchange(use(prices));
+        st.exchange(use(flags));
+        st.exchange(use(lastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("offer");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strSellerIDs = toPostgresArray(sellerIDs);
+        std::string strOfferIDs = toPostgresArray(offerIDs);
+        std::string strSellingTypes = toPostgresArray(sellingTypes);
+        std::string strSellingCodes =
+            toPostgresArray(sellingCodes, &sellingInds);
+        std::string strSellingIssuers =
+            toPostgresArray(sellingIssuers, &sellingInds);
+        std::string strBuyingTypes = toPostgresArray(buyingTypes);
+        std::string strBuyingCodes = toPostgresArray(buyingCodes, &buyingInds);
+        std::string strBuyingIssuers =
+            toPostgresArray(buyingIssuers, &buyingInds);
+        std::string strAmounts = toPostgresArray(amounts);
+        std::string strPriceNs = toPostgresArray(priceNs);
+        std::string strPriceDs = toPostgresArray(priceDs);
+        std::string strFlags = toPostgresArray(flags);
+        std::string strLastModifieds = toPostgresArray(lastModifieds);
+
+        // The double-valued price column is computed server-side from the
+        // exact rational, which is what computePrice() does locally.
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO offers (sellerid,offerid,"
+            "sellingassettype,sellingassetcode,sellingissuer,"
+            "buyingassettype,buyingassetcode,buyingissuer,"
+            "amount,pricen,priced,price,flags,lastmodified) "
+            "SELECT sid, oid, sat, sac, si, bat, bac, bi, a, pn, pd, "
+            "pn::DOUBLE PRECISION / pd::DOUBLE PRECISION, f, l FROM "
+            "unnest(:sid::TEXT[], :oid::BIGINT[], :sat::INT[], "
+            ":sac::TEXT[], :si::TEXT[], :bat::INT[], :bac::TEXT[], "
+            ":bi::TEXT[], :a::BIGINT[], :pn::INT[], :pd::INT[], :f::INT[], "
+            ":l::INT[]) "
+            "AS x(sid, oid, sat, sac, si, bat, bac, bi, a, pn, pd, f, l) "
+            "ON CONFLICT (offerid) DO UPDATE SET "
+            "sellerid = excluded.sellerid, "
+            "sellingassettype = excluded.sellingassettype, "
+            "sellingassetcode = excluded.sellingassetcode, "
+            "sellingissuer = excluded.sellingissuer, "
+            "buyingassettype = excluded.buyingassettype, "
+            "buyingassetcode = excluded.buyingassetcode, "
+            "buyingissuer = excluded.buyingissuer, "
+            "amount = excluded.amount, pricen = excluded.pricen, "
+            "priced = excluded.priced, price = excluded.price, "
+            "flags = excluded.flags, lastmodified = excluded.lastmodified");
+        auto& st = prep.statement();
+        st.exchange(use(strSellerIDs));
+        st.exchange(use(strOfferIDs));
+        st.exchange(use(strSellingTypes));
+        st.exchange(use(strSellingCodes));
+        st.exchange(use(strSellingIssuers));
+        st.exchange(use(strBuyingTypes));
+        st.exchange(use(strBuyingCodes));
+        st.exchange(use(strBuyingIssuers));
+        st.exchange(use(strAmounts));
+        st.exchange(use(strPriceNs));
+        st.exchange(use(strPriceDs));
+        st.exchange(use(strFlags));
+        st.exchange(use(strLastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("offer");
+        st.execute(true);
+    }
+}
+
+void
+OfferFrame::storeDeleteBulk(Database& db, std::vector<LedgerKey> const& keys)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    std::vector<uint64_t> offerIDs;
+    for (auto const& k : keys)
+    {
+        flushCachedEntry(k, db);
+        db.getOrderBook().erase(k.offer().offerID);
+        offerIDs.emplace_back(k.offer().offerID);
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep =
+            db.getPreparedStatement("DELETE FROM offers WHERE offerid=:s");
+        auto& st = prep.statement();
+        st.exchange(use(offerIDs));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("offer");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strOfferIDs = toPostgresArray(offerIDs);
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM offers WHERE offerid = ANY(:s::BIGINT[])");
+        auto& st = prep.statement();
+        st.exchange(use(strOfferIDs));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("offer");
+        st.execute(true);
+    }
+}
+
 void
 OfferFrame::storeDelete(LedgerDelta& delta, Database& db) const
 {
@@ -420,6 +686,7 @@ OfferFrame::storeDelete(LedgerDelta& delta, Database& db, LedgerKey const& key)
     st.exchange(use(key.offer().offerID));
     st.define_and_bind();
     st.execute(true);
+    db.getOrderBook().erase(key.offer().offerID);
     delta.deleteEntry(key);
 }
 
@@ -535,6 +802,8 @@ OfferFrame::storeUpdateHelper(LedgerDelta& delta, Database& db, bool insert)
         throw std::runtime_error("could not update SQL");
     }
 
+    db.getOrderBook().put(mEntry);
+
     if (insert)
     {
         delta.addEntry(*this);
@@ -548,6 +817,7 @@ OfferFrame::storeUpdateHelper(LedgerDelta& delta, Database& db, bool insert)
 void
 OfferFrame::dropAll(Database& db)
 {
+    db.getOrderBook().clear();
     db.getSession() << "DROP TABLE IF EXISTS offers;";
     db.getSession() << kSQLCreateStatement1;
     db.getSession() << kSQLCreateStatement2;
@@ -5,6 +5,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "ledger/EntryFrame.h"
+#include "ledger/OrderBook.h"
 #include <functional>
 #include <unordered_map>
 
@@ -25,6 +26,15 @@ class OfferFrame : public EntryFrame
     loadOffers(StatementContext& prep,
                std::function<void(LedgerEntry const&)> offerProcessor);
 
+    // loads the offers of a (selling, buying) pair in price order, starting
+    // after the rank `after` if it is set; a numOffers of 0 loads all of them
+    static void
+    loadPairOffers(Asset const& selling, Asset const& buying,
+                   size_t numOffers, size_t offset,
+                   OrderBook::OfferRank const* after,
+                   std::function<void(LedgerEntry const&)> offerProcessor,
+                   Database& db);
+
     double computePrice() const;
 
     OfferEntry& mOffer;
@@ -85,6 +95,11 @@ class OfferFrame : public EntryFrame
     static void deleteOffersModifiedOnOrAfterLedger(Database& db,
                                                     uint32_t oldestLedger);
 
+    static void storeUpsertBulk(Database& db,
+                                std::vector<LedgerEntry> const& entries);
+    static void storeDeleteBulk(Database& db,
+                                std::vector<LedgerKey> const& keys);
+
     // database utilities
     static pointer loadOffer(AccountID const& accountID, uint64_t offerID,
                              Database& db, LedgerDelta* delta = nullptr);
@@ -94,6 +109,14 @@ class OfferFrame : public EntryFrame
                                std::vector<OfferFrame::pointer>& retOffers,
                                Database& db);
 
+    // returns the best offer selling `selling` for `buying` that ranks
+    // strictly after `after` (the best overall if `after` is null), or null
+    // if there is none. Served from the database's in-memory order book,
+    // which loads the pair on first use.
+    static pointer loadNextBestOffer(Asset const& selling,
+                                     Asset const& buying,
+                                     OfferFrame const* after, Database& db);
+
     // load all offers from the database (very slow)
     static std::unordered_map<AccountID, std::vector<OfferFrame::pointer>>
     loadAllOffers(Database& db);
@@ -0,0 +1,183 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/OrderBook.h"
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include <cassert>
+
+namespace stellar
+{
+
+size_t const OrderBook::PAGE_SIZE;
+
+OrderBook::OrderBook(medida::MetricsRegistry& metrics, size_t maxSize)
+    : mMaxSize(maxSize)
+    , mPairLoad(metrics.NewMeter({"order-book", "pair", "load"}, "pair"))
+    , mPageLoad(metrics.NewMeter({"order-book", "page", "load"}, "page"))
+    , mPairEvict(metrics.NewMeter({"order-book", "pair", "evict"}, "pair"))
+    , mSizeCounter(metrics.NewCounter({"order-book", "memory", "size"}))
+{
+}
+
+bool
+OrderBook::AssetPairCmp::operator()(AssetPair const& a,
+                                    AssetPair const& b) const
+{
+    using xdr::operator<;
+    if (a.first < b.first)
+    {
+        return true;
+    }
+    if (b.first < a.first)
+    {
+        return false;
+    }
+    return a.second < b.second;
+}
+
+OrderBook::OfferRank
+OrderBook::rank(OfferEntry const& offer)
+{
+    // Must match OfferFrame::computePrice, which fills the price column.
+    return std::make_pair(double(offer.price.n) / double(offer.price.d),
+                          offer.offerID);
+}
+
+OrderBook::Pair const*
+OrderBook::find(Asset const& selling, Asset const& buying)
+{
+    auto it = mPairs.find(std::make_pair(selling, buying));
+    if (it == mPairs.end())
+    {
+        return nullptr;
+    }
+    touch(it);
+    return &it->second.mPair;
+}
+
+OrderBook::Pair const&
+OrderBook::addPage(Asset const& selling, Asset const& buying,
+                   std::vector<LedgerEntry> const& page, bool complete)
+{
+    auto key = std::make_pair(selling, buying);
+    auto it = mPairs.find(key);
+    if (it == mPairs.end())
+    {
+        mLru.push_front(key);
+        it = mPairs.emplace(key, LoadedPair{Pair{}, mLru.begin()}).first;
+        mPairLoad.Mark();
+    }
+    else
+    {
+        touch(it);
+    }
+
+    // an incomplete pair always has a last loaded rank
+    assert(complete || !page.empty());
+    auto& pair = it->second.mPair;
+    for (auto const& o : page)
+    {
+        auto const& oe = o.data.offer();
+        auto r = rank(oe);
+        // An offer can only be in one pair; a stale position elsewhere
+        // means that pair is out of date.
+        auto prev = mByOfferID.find(oe.offerID);
+        if (prev != mByOfferID.end())
+        {
+            if (prev->second.mPair == it)
+            {
+                erase(oe.offerID);
+            }
+            else
+            {
+                erasePair(prev->second.mPair);
+            }
+        }
+        pair.mOffers.emplace(r, o);
+        mByOfferID.emplace(oe.offerID, Position{it, r});
+        mSizeCounter.inc();
+        pair.mLast = r;
+    }
+    pair.mComplete = complete;
+    mPageLoad.Mark();
+
+    // the pair just loaded is at the front, so it is never evicted
+    while (mByOfferID.size() > mMaxSize && mLru.size() > 1)
+    {
+        erasePair(mPairs.find(mLru.back()));
+        mPairEvict.Mark();
+    }
+    return pair;
+}
+
+void
+OrderBook::put(LedgerEntry const& offer)
+{
+    auto const& oe = offer.data.offer();
+    erase(oe.offerID);
+
+    auto it = mPairs.find(std::make_pair(oe.selling, oe.buying));
+    if (it == mPairs.end())
+    {
+        return;
+    }
+    auto& pair = it->second.mPair;
+    auto r = rank(oe);
+    // offers past the loaded part show up when the next page is loaded
+    if (pair.mComplete || !(pair.mLast < r))
+    {
+        pair.mOffers.emplace(r, offer);
+        mByOfferID.emplace(oe.offerID, Position{it, r});
+        mSizeCounter.inc();
+    }
+}
+
+void
+OrderBook::erase(uint64_t offerID)
+{
+    auto pos = mByOfferID.find(offerID);
+    if (pos != mByOfferID.end())
+    {
+        pos->second.mPair->second.mPair.mOffers.erase(pos->second.mRank);
+        mByOfferID.erase(pos);
+        mSizeCounter.dec();
+    }
+}
+
+void
+OrderBook::clear()
+{
+    mPairs.clear();
+    mByOfferID.clear();
+    mLru.clear();
+    mSizeCounter.clear();
+}
+
+size_t
+OrderBook::size() const
+{
+    return mByOfferID.size();
+}
+
+void
+OrderBook::touch(PairMap::iterator it)
+{
+    mLru.splice(mLru.begin(), mLru, it->second.mLruPos);
+}
+
+void
+OrderBook::erasePair(PairMap::iterator it)
+{
+    auto const& offers = it->second.mPair.mOffers;
+    for (auto const& o : offers)
+    {
+        mByOfferID.erase(o.first.second);
+    }
+    mSizeCounter.dec(offers.size());
+    mLru.erase(it->second.mLruPos);
+    mPairs.erase(it);
+}
+}
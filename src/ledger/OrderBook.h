@@ -0,0 +1,130 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "util/NonCopyable.h"
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace medida
+{
+class MetricsRegistry;
+class Meter;
+class Counter;
+}
+
+namespace stellar
+{
+
+/**
+ * In-memory mirror of the offers table, organized for crossing.
+ *
+ * Offers are grouped by (selling, buying) asset pair and, within a pair,
+ * kept in the order OfferExchange crosses them: by price and then by
+ * offerID, oldest first. The price is the same double approximation of n/d
+ * that is stored in (and ordered by) the offers table's price column, so
+ * the book yields offers in exactly the order the SQL query would.
+ *
+ * Pairs are loaded from the database in pages of PAGE_SIZE offers, as far as
+ * crossing actually walks into them: a loaded pair holds every offer ranked
+ * up to and including its last loaded rank, or all of its offers once the
+ * last page has been read. After that, every write to the offers table must
+ * be reported through put() or erase(), including the undoing of writes that
+ * are rolled back (see LedgerDelta::rollback). Writes to pairs that are not
+ * loaded, or beyond the loaded part of a pair, are ignored.
+ *
+ * Like the entry cache, the book is bounded: once it holds more than
+ * `maxSize` offers, the least recently used pairs are evicted and simply
+ * reloaded on next use.
+ *
+ * Like the database session it mirrors, the book may only be used from the
+ * main thread.
+ */
+class OrderBook : NonMovableOrCopyable
+{
+  public:
+    typedef std::pair<double, uint64_t> OfferRank;
+    typedef std::map<OfferRank, LedgerEntry> Offers;
+
+    static size_t const PAGE_SIZE = 20;
+
+    // The loaded part of a pair.
+    struct Pair
+    {
+        Offers mOffers;
+        // every offer of the pair is loaded
+        bool mComplete{false};
+        // rank of the last offer loaded, when any is
+        OfferRank mLast;
+    };
+
+    OrderBook(medida::MetricsRegistry& metrics, size_t maxSize);
+
+    // Position of `offer` within its pair.
+    static OfferRank rank(OfferEntry const& offer);
+
+    // Return the loaded part of the given pair, or nullptr if it is not
+    // loaded, and mark it as the most recently used.
+    Pair const* find(Asset const& selling, Asset const& buying);
+
+    // Append the next page of a pair, as loaded from the database: the offers
+    // ranked after the loaded part (or the first ones, if the pair is not
+    // loaded), in rank order. `complete` tells that the page reaches the end
+    // of the pair. May evict other pairs to stay within the size limit.
+    Pair const& addPage(Asset const& selling, Asset const& buying,
+                        std::vector<LedgerEntry> const& page, bool complete);
+
+    // Record that `offer` was inserted or updated in the database.
+    void put(LedgerEntry const& offer);
+
+    // Record that the offer `offerID` was deleted from the database.
+    void erase(uint64_t offerID);
+
+    void clear();
+
+    // Number of offers held across all loaded pairs.
+    size_t size() const;
+
+  private:
+    typedef std::pair<Asset, Asset> AssetPair;
+
+    struct AssetPairCmp
+    {
+        bool operator()(AssetPair const& a, AssetPair const& b) const;
+    };
+
+    struct LoadedPair
+    {
+        Pair mPair;
+        std::list<AssetPair>::iterator mLruPos;
+    };
+
+    typedef std::map<AssetPair, LoadedPair, AssetPairCmp> PairMap;
+
+    struct Position
+    {
+        PairMap::iterator mPair;
+        OfferRank mRank;
+    };
+
+    size_t const mMaxSize;
+    PairMap mPairs;
+    std::unordered_map<uint64_t, Position> mByOfferID;
+    // most recently used pair first
+    std::list<AssetPair> mLru;
+
+    medida::Meter& mPairLoad;
+    medida::Meter& mPageLoad;
+    medida::Meter& mPairEvict;
+    medida::Counter& mSizeCounter;
+
+    void touch(PairMap::iterator it);
+    void erasePair(PairMap::iterator it);
+};
+}
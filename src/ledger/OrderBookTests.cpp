@@ -0,0 +1,221 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SecretKey.h"
+#include "database/Database.h"
+#include "ledger/LedgerDelta.h"
+#include "ledger/LedgerTestUtils.h"
+#include "ledger/OfferFrame.h"
+#include "ledger/OrderBook.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+#include "util/types.h"
+
+using namespace stellar;
+
+namespace
+{
+Asset
+makeCreditAsset(std::string const& code, PublicKey const& issuer)
+{
+    Asset a;
+    a.type(ASSET_TYPE_CREDIT_ALPHANUM4);
+    strToAssetCode(a.alphaNum4().assetCode, code);
+    a.alphaNum4().issuer = issuer;
+    return a;
+}
+
+// offer IDs in crossing order, as served by the order book
+std::vector<uint64_t>
+bookOrder(Asset const& selling, Asset const& buying, Database& db)
+{
+    std::vector<uint64_t> res;
+    OfferFrame::pointer o;
+    while ((o = OfferFrame::loadNextBestOffer(selling, buying, o.get(), db)))
+    {
+        res.emplace_back(o->getOfferID());
+    }
+    return res;
+}
+
+// offer IDs in crossing order, as served by SQL
+std::vector<uint64_t>
+sqlOrder(Asset const& selling, Asset const& buying, Database& db)
+{
+    std::vector<OfferFrame::pointer> offers;
+    OfferFrame::loadBestOffers(10000, 0, selling, buying, offers, db);
+    std::vector<uint64_t> res;
+    for (auto const& o : offers)
+    {
+        res.emplace_back(o->getOfferID());
+    }
+    return res;
+}
+
+// 48 offers selling cad for eur and 12 the other way around
+std::vector<OfferFrame::pointer>
+addOffers(Asset const& cad, Asset const& eur, LedgerDelta& delta,
+          Database& db)
+{
+    std::vector<OfferFrame::pointer> offers;
+    for (uint64_t i = 1; i <= 60; ++i)
+    {
+        LedgerEntry le;
+        le.data.type(OFFER);
+        auto& oe = le.data.offer();
+        oe = LedgerTestUtils::generateValidOfferEntry();
+        oe.offerID = i;
+        // few distinct prices, so ties are broken by offerID
+        oe.price.n = static_cast<int32_t>(i % 3 + 1);
+        oe.price.d = static_cast<int32_t>(i % 4 + 1);
+        oe.selling = i % 5 == 0 ? eur : cad;
+        oe.buying = i % 5 == 0 ? cad : eur;
+        offers.emplace_back(std::make_shared<OfferFrame>(le));
+        offers.back()->storeAdd(delta, db);
+    }
+    return offers;
+}
+}
+
+TEST_CASE("order book serves offers in SQL order", "[orderbook]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    app->start();
+    Database& db = app->getDatabase();
+    auto& book = db.getOrderBook();
+
+    auto issuer = SecretKey::random().getPublicKey();
+    auto cad = makeCreditAsset("CAD", issuer);
+    auto eur = makeCreditAsset("EUR", issuer);
+
+    LedgerHeader lh;
+    LedgerDelta delta(lh, db, false);
+
+    auto offers = addOffers(cad, eur, delta, db);
+
+    REQUIRE(book.find(cad, eur) == nullptr);
+    // only the first page of a pair is loaded until crossing gets past it
+    REQUIRE(OfferFrame::loadNextBestOffer(cad, eur, nullptr, db));
+    REQUIRE(book.size() == OrderBook::PAGE_SIZE);
+    REQUIRE(!book.find(cad, eur)->mComplete);
+    REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+    REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+    REQUIRE(book.find(cad, eur)->mComplete);
+    REQUIRE(book.size() == offers.size());
+
+    auto changeOffers = [&]() {
+        for (size_t i = 0; i < offers.size(); i += 3)
+        {
+            auto& o = offers[i];
+            o->getOffer().price.n = 7;
+            o->getOffer().price.d = static_cast<int32_t>(i % 5 + 1);
+            if (i % 2 == 0)
+            {
+                // move the offer to the other side of the book
+                std::swap(o->getOffer().selling, o->getOffer().buying);
+            }
+            o->storeChange(delta, db);
+        }
+        for (size_t i = 1; i < offers.size(); i += 4)
+        {
+            offers[i]->storeDelete(delta, db);
+        }
+    };
+
+    SECTION("writes keep loaded pairs in sync")
+    {
+        changeOffers();
+        REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+        REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+        REQUIRE(book.size() == sqlOrder(cad, eur, db).size() +
+                                   sqlOrder(eur, cad, db).size());
+    }
+
+    SECTION("writes keep partially loaded pairs in sync")
+    {
+        book.clear();
+        REQUIRE(OfferFrame::loadNextBestOffer(cad, eur, nullptr, db));
+        REQUIRE(OfferFrame::loadNextBestOffer(eur, cad, nullptr, db));
+        changeOffers();
+        REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+        REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+    }
+
+    SECTION("rollback restores the offers it touched")
+    {
+        {
+            soci::transaction sqlTx(db.getSession());
+            LedgerDelta inner(delta);
+            for (size_t i = 0; i < offers.size(); i += 2)
+            {
+                auto o = std::make_shared<OfferFrame>(*offers[i]);
+                inner.recordEntry(*o);
+                if (i % 4 == 0)
+                {
+                    o->storeDelete(inner, db);
+                }
+                else
+                {
+                    o->getOffer().price.n = 9;
+                    std::swap(o->getOffer().selling, o->getOffer().buying);
+                    o->storeChange(inner, db);
+                }
+            }
+            REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+            REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+        }
+
+        // restored in place, without reloading the pairs
+        REQUIRE(book.size() == offers.size());
+        REQUIRE(book.find(cad, eur)->mComplete);
+        REQUIRE(book.find(eur, cad)->mComplete);
+        REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+        REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+        REQUIRE(book.size() == offers.size());
+    }
+
+    SECTION("rollback of an unrecorded delete drops the whole book")
+    {
+        {
+            soci::transaction sqlTx(db.getSession());
+            LedgerDelta inner(delta);
+            OfferFrame::storeDelete(inner, db, offers[0]->getKey());
+        }
+        REQUIRE(book.size() == 0);
+        REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+    }
+}
+
+TEST_CASE("order book evicts least recently used pairs", "[orderbook]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.ORDER_BOOK_CACHE_SIZE = 30;
+    Application::pointer app = createTestApplication(clock, cfg);
+    app->start();
+    Database& db = app->getDatabase();
+    auto& book = db.getOrderBook();
+
+    auto issuer = SecretKey::random().getPublicKey();
+    auto cad = makeCreditAsset("CAD", issuer);
+    auto eur = makeCreditAsset("EUR", issuer);
+
+    LedgerHeader lh;
+    LedgerDelta delta(lh, db, false);
+    addOffers(cad, eur, delta, db);
+
+    // the pair in use is kept even when it is larger than the limit
+    REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+    REQUIRE(book.size() == 48);
+
+    REQUIRE(bookOrder(eur, cad, db) == sqlOrder(eur, cad, db));
+    REQUIRE(book.find(cad, eur) == nullptr);
+    REQUIRE(book.size() == 12);
+
+    REQUIRE(bookOrder(cad, eur, db) == sqlOrder(cad, eur, db));
+    REQUIRE(book.find(eur, cad) == nullptr);
+}
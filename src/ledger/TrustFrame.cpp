@@ -10,6 +10,7 @@
 #include "database/Database.h"
 #include "ledger/LedgerRange.h"
 #include "util/types.h"
+#include <set>
 
 using namespace std;
 using namespace soci;
@@ -142,7 +143,8 @@ TrustFrame::getMaxAmountReceive() const
 bool
 TrustFrame::exists(Database& db, LedgerKey const& key)
 {
-    if (cachedEntryExists(key, db) && getCachedEntry(key, db) != nullptr)
+    std::shared_ptr<LedgerEntry const> p;
+    if (getCachedEntry(key, p, db) && p != nullptr)
     {
         return true;
     }
@@ -186,11 +188,7 @@ void
 TrustFrame::deleteTrustLinesModifiedOnOrAfterLedger(Database& db,
                                                     uint32_t oldestLedger)
 {
-    db.getEntryCache().erase_if(
-        [oldestLedger](std::shared_ptr<LedgerEntry const> le) -> bool {
-            return le && le->data.type() == TRUSTLINE &&
-                   le->lastModifiedLedgerSeq >= oldestLedger;
-        });
+    db.getEntryCache().eraseModifiedOnOrAfter(TRUSTLINE, oldestLedger);
 
     {
         auto prep = db.getPreparedStatement(
@@ -202,6 +200,146 @@ TrustFrame::deleteTrustLinesModifiedOnOrAfterLedger(Database& db,
     }
 }
 
+void
+TrustFrame::storeUpsertBulk(Database& db,
+                            std::vector<LedgerEntry> const& entries)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> actIDs, issuers, assetCodes;
+    std::vector<uint32_t> assetTypes, flags, lastModifieds;
+    std::vector<int64_t> balances, limits;
+
+    for (auto const& e : entries)
+    {
+        auto key = LedgerEntryKey(e);
+        flushCachedEntry(key, db);
+
+        std::string actIDStrKey, issuerStrKey, assetCode;
+        getKeyFields(key, actIDStrKey, issuerStrKey, assetCode);
+        auto const& tl = e.data.trustLine();
+        actIDs.emplace_back(std::move(actIDStrKey));
+        assetTypes.emplace_back(tl.asset.type());
+        issuers.emplace_back(std::move(issuerStrKey));
+        assetCodes.emplace_back(std::move(assetCode));
+        balances.emplace_back(tl.balance);
+        limits.emplace_back(tl.limit);
+        flags.emplace_back(tl.flags);
+        lastModifieds.emplace_back(e.lastModifiedLedgerSeq);
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep = db.getPreparedStatement(
+            "INSERT OR REPLACE INTO trustlines "
+            "(accountid, assettype, issuer, assetcode, balance, tlimit, "
+            "flags, lastmodified) "
+            "VALUES (:v1, :v2, :v3, :v4, :v5, :v6, :v7, :v8)");
+        auto& st = prep.statement();
+        st.exchange(use(actIDs));
+        st.exchange(use(assetTypes));
+        st.exchange(use(issuers));
+        st.exchange(use(assetCodes));
+        st.exchange(use(balances));
+        st.exchange(use(limits));
+        st.exchange(use(flags));
+        st.exchange(use(lastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("trust");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strActIDs = toPostgresArray(actIDs);
+        std::string strAssetTypes = toPostgresArray(assetTypes);
+        std::string strIssuers = toPostgresArray(issuers);
+        std::string strAssetCodes = toPostgresArray(assetCodes);
+        std::string strBalances = toPostgresArray(balances);
+        std::string strLimits = toPostgresArray(limits);
+        std::string strFlags = toPostgresArray(flags);
+        std::string strLastModifieds = toPostgresArray(lastModifieds);
+
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO trustlines "
+            "(accountid, assettype, issuer, assetcode, balance, tlimit, "
+            "flags, lastmodified) "
+            "SELECT * FROM unnest(:v1::TEXT[], :v2::INT[], :v3::TEXT[], "
+            ":v4::TEXT[], :v5::BIGINT[], :v6::BIGINT[], :v7::INT[], "
+            ":v8::INT[]) "
+            "ON CONFLICT (accountid, issuer, assetcode) DO UPDATE SET "
+            "assettype = excluded.assettype, balance = excluded.balance, "
+            "tlimit = excluded.tlimit, flags = excluded.flags, "
+            "lastmodified = excluded.lastmodified");
+        auto& st = prep.statement();
+        st.exchange(use(strActIDs));
+        st.exchange(use(strAssetTypes));
+        st.exchange(use(strIssuers));
+        st.exchange(use(strAssetCodes));
+        st.exchange(use(strBalances));
+        st.exchange(use(strLimits));
+        st.exchange(use(strFlags));
+        st.exchange(use(strLastModifieds));
+        st.define_and_bind();
+        auto timer = db.getUpsertTimer("trust");
+        st.execute(true);
+    }
+}
+
+void
+TrustFrame::storeDeleteBulk(Database& db, std::vector<LedgerKey> const& keys)
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> actIDs, issuers, assetCodes;
+    for (auto const& k : keys)
+    {
+        flushCachedEntry(k, db);
+
+        std::string actIDStrKey, issuerStrKey, assetCode;
+        getKeyFields(k, actIDStrKey, issuerStrKey, assetCode);
+        actIDs.emplace_back(std::move(actIDStrKey));
+        issuers.emplace_back(std::move(issuerStrKey));
+        assetCodes.emplace_back(std::move(assetCode));
+    }
+
+    if (db.isSqlite())
+    {
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM trustlines "
+            "WHERE accountid=:v1 AND issuer=:v2 AND assetcode=:v3");
+        auto& st = prep.statement();
+        st.exchange(use(actIDs));
+        st.exchange(use(issuers));
+        st.exchange(use(assetCodes));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("trust");
+        st.execute(true);
+    }
+    else
+    {
+        std::string strActIDs = toPostgresArray(actIDs);
+        std::string strIssuers = toPostgresArray(issuers);
+        std::string strAssetCodes = toPostgresArray(assetCodes);
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM trustlines USING "
+            "unnest(:v1::TEXT[], :v2::TEXT[], :v3::TEXT[]) AS x(a, i, c) "
+            "WHERE accountid = x.a AND issuer = x.i AND assetcode = x.c");
+        auto& st = prep.statement();
+        st.exchange(use(strActIDs));
+        st.exchange(use(strIssuers));
+        st.exchange(use(strAssetCodes));
+        st.define_and_bind();
+        auto timer = db.getDeleteTimer("trust");
+        st.execute(true);
+    }
+}
+
 void
 TrustFrame::storeDelete(LedgerDelta& delta, Database& db) const
 {
@@ -347,18 +485,19 @@ TrustFrame::loadTrustLine(AccountID const& accountID, Asset const& asset,
     key.type(TRUSTLINE);
     key.trustLine().accountID = accountID;
     key.trustLine().asset = asset;
-    if (cachedEntryExists(key, db))
+    std::shared_ptr<LedgerEntry const> p;
+    if (getCachedEntry(key, p, db))
     {
-        auto p = getCachedEntry(key, db);
-        if (p)
+        if (!p)
         {
-            pointer ret = std::make_shared<TrustFrame>(*p);
-            if (delta)
-            {
-                delta->recordEntry(*ret);
-            }
-            return ret;
+            return nullptr;
         }
+        pointer ret = std::make_shared<TrustFrame>(*p);
+        if (delta)
+        {
+            delta->recordEntry(*ret);
+        }
+        return ret;
     }
 
     std::string accStr, issuerStr, assetStr;
@@ -407,6 +546,51 @@ TrustFrame::loadTrustLine(AccountID const& accountID, Asset const& asset,
     return retLine;
 }
 
+void
+TrustFrame::prefetch(std::vector<LedgerKey> const& keys, Database& db)
+{
+    std::set<LedgerKey, LedgerEntryIdCmp> wanted;
+    std::set<std::string> accounts;
+    for (auto const& key : keys)
+    {
+        auto const& tl = key.trustLine();
+        // issuers get a generated trust line, they never hit the database
+        if (tl.asset.type() == ASSET_TYPE_NATIVE ||
+            tl.accountID == getIssuer(tl.asset) ||
+            db.getEntryCache().exists(key))
+        {
+            continue;
+        }
+        if (wanted.insert(key).second)
+        {
+            accounts.insert(KeyUtils::toStrKey(tl.accountID));
+        }
+    }
+
+    // accounts have few trust lines: load all of theirs and keep the ones
+    // asked for
+    std::vector<std::string> ids(accounts.begin(), accounts.end());
+    selectByIDs(db, std::string(trustLineColumnSelector) + " WHERE accountid",
+                ids, [&](StatementContext& prep) {
+                    auto timer = db.getSelectTimer("trust");
+                    loadLines(prep, [&](LedgerEntry const& trust) {
+                        auto it = wanted.find(LedgerEntryKey(trust));
+                        if (it != wanted.end())
+                        {
+                            putCachedEntry(
+                                *it, std::make_shared<LedgerEntry const>(trust),
+                                db);
+                            wanted.erase(it);
+                        }
+                    });
+                });
+
+    for (auto const& key : wanted)
+    {
+        putCachedEntry(key, nullptr, db);
+    }
+}
+
 std::pair<TrustFrame::pointer, AccountFrame::pointer>
 TrustFrame::loadTrustLineIssuer(AccountID const& accountID, Asset const& asset,
                                 Database& db, LedgerDelta& delta)
@@ -71,10 +71,19 @@ class TrustFrame : public EntryFrame
     static void deleteTrustLinesModifiedOnOrAfterLedger(Database& db,
                                                         uint32_t oldestLedger);
 
+    static void storeUpsertBulk(Database& db,
+                                std::vector<LedgerEntry> const& entries);
+    static void storeDeleteBulk(Database& db,
+                                std::vector<LedgerKey> const& keys);
+
     // returns the specified trustline or a generated one for issuers
     static pointer loadTrustLine(AccountID const& accountID, Asset const& asset,
                                  Database& db, LedgerDelta* delta = nullptr);
 
+    // loads the trust lines of `keys` that are not cached yet into the entry
+    // cache in a few bulk queries (see EntryFrame::prefetch)
+    static void prefetch(std::vector<LedgerKey> const& keys, Database& db);
+
     // overload that also returns the issuer
     static std::pair<TrustFrame::pointer, AccountFrame::pointer>
     loadTrustLineIssuer(AccountID const& accountID, Asset const& asset,
@@ -12,6 +12,7 @@
 #include "StellarCoreVersion.h"
 #include "bucket/Bucket.h"
 #include "bucket/BucketManager.h"
+#include "bucket/BucketMergeScheduler.h"
 #include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "database/Database.h"
@@ -82,6 +83,8 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
 
     mNetworkID = sha256(mConfig.NETWORK_PASSPHRASE);
 
+    PubKeyUtils::setVerifySigCacheSize(mConfig.VERIFY_SIG_CACHE_SIZE);
+
     unsigned t = std::thread::hardware_concurrency();
     LOG(DEBUG) << "Application constructing "
                << "(worker threads: " << t << ")";
@@ -444,6 +447,13 @@ ApplicationImpl::shutdownMainIOService()
 void
 ApplicationImpl::joinAllThreads()
 {
+    // Merges still queued run to completion first, as they did when they
+    // were worker tasks; they may in turn post work to the worker threads.
+    if (mBucketManager)
+    {
+        mBucketManager->getMergeScheduler().shutdown();
+    }
+
     // We never strictly stop the worker IO service, just release the work-lock
     // that keeps the worker threads alive. This gives them the chance to finish
     // any work that the main thread queued.
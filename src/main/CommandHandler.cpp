@@ -6,6 +6,7 @@
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
 #include "herder/Herder.h"
+#include "herder/QuorumIntersectionChecker.h"
 #include "ledger/LedgerManager.h"
 #include "lib/http/server.hpp"
 #include "lib/json/json.h"
@@ -29,6 +30,7 @@
 #include "test/TestAccount.h"
 #include "test/TxTests.h"
 #include <regex>
+#include <thread>
 
 using namespace stellar::txtest;
 
@@ -39,7 +41,25 @@ namespace stellar
 {
 using xdr::operator<;
 
-CommandHandler::CommandHandler(Application& app) : mApp(app)
+// longest a /checkquorum search may run, in seconds
+static uint32_t const MAX_QUORUM_CHECK_TIMEOUT = 600;
+
+struct CommandHandler::QuorumCheck
+{
+    explicit QuorumCheck(Application& app) : mApp(app)
+    {
+    }
+
+    // only used on the main thread, while the CommandHandler is alive
+    Application& mApp;
+    bool mRunning{false};
+    std::shared_ptr<QuorumIntersectionChecker> mChecker;
+    std::thread mThread;
+    Json::Value mResult;
+};
+
+CommandHandler::CommandHandler(Application& app)
+    : mApp(app), mQuorumCheck(std::make_shared<QuorumCheck>(app))
 {
     if (mApp.getConfig().HTTP_PORT)
     {
@@ -72,6 +92,7 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
     addRoute("bans", &CommandHandler::bans);
     addRoute("catchup", &CommandHandler::catchup);
     addRoute("checkdb", &CommandHandler::checkdb);
+    addRoute("checkquorum", &CommandHandler::checkQuorum);
     addRoute("connect", &CommandHandler::connect);
     addRoute("dropcursor", &CommandHandler::dropcursor);
     addRoute("droppeer", &CommandHandler::dropPeer);
@@ -94,6 +115,21 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
     addRoute("unban", &CommandHandler::unban);
 }
 
+CommandHandler::~CommandHandler()
+{
+    // a running quorum check stops at its next checkpoint; its result is
+    // dropped, as nothing is left to hold it
+    auto& state = *mQuorumCheck;
+    if (state.mChecker)
+    {
+        state.mChecker->cancel();
+    }
+    if (state.mThread.joinable())
+    {
+        state.mThread.join();
+    }
+}
+
 void
 CommandHandler::addRoute(std::string const& name, HandlerRoute route)
 {
@@ -252,6 +288,11 @@ CommandHandler::fileNotFound(std::string const& params, std::string& retStr)
         "mode is either 'minimal' (the default, if omitted) or 'complete'."
         "</p><p><h1> /checkdb</h1>"
         "triggers the instance to perform an integrity check of the database."
+        "</p><p><h1> /checkquorum?[timeout=SECONDS]</h1>"
+        "starts checking, in the background, that every two quorums of the "
+        "nodes this instance currently hears from intersect, giving up after "
+        "SECONDS (60 by default, at most 600). Returns the progress of the"
+        " running check, if any, and the result of the last one."
         "</p><p><h1> /connect?peer=NAME&port=NNN</h1>"
         "triggers the instance to connect to peer NAME at port NNN."
         "</p><p><h1> "
@@ -557,6 +598,112 @@ CommandHandler::checkdb(std::string const& params, std::string& retStr)
     retStr = "CheckDB started.";
 }
 
+void
+CommandHandler::checkQuorum(std::string const& params, std::string& retStr)
+{
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+
+    uint32_t timeout = 60;
+    maybeParseNumParam(retMap, "timeout", timeout);
+    if (timeout == 0)
+    {
+        // an endless check would hold up shutdown
+        throw std::invalid_argument("timeout must be positive");
+    }
+    timeout = std::min(timeout, MAX_QUORUM_CHECK_TIMEOUT);
+
+    auto state = mQuorumCheck;
+    if (!state->mRunning)
+    {
+        if (state->mThread.joinable())
+        {
+            // the last check is over, its thread has only posted the result
+            state->mThread.join();
+        }
+        auto qmap = mApp.getHerder().getCurrentQuorumMap();
+        state->mRunning = true;
+        state->mChecker = std::make_shared<QuorumIntersectionChecker>(qmap);
+
+        // The search gets threads of its own rather than worker threads,
+        // which transaction pre-verification and merges wait on. It leaves
+        // half of the cores to everything else.
+        auto threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        auto checker = state->mChecker;
+        auto budget = std::chrono::seconds(timeout);
+        std::weak_ptr<QuorumCheck> weak(state);
+        // the main io_service is owned by the clock, which outlives this
+        // handler; the destructor joins the thread before returning
+        auto& mainIO = mApp.getClock().getIOService();
+        state->mThread = std::thread([checker, threads, budget, weak,
+                                      &mainIO]() {
+            auto res = checker->check(threads, budget);
+            mainIO.post([weak, res]() {
+                auto state = weak.lock();
+                if (!state)
+                {
+                    return;
+                }
+                auto const& cfg = state->mApp.getConfig();
+                Json::Value result;
+                switch (res.mStatus)
+                {
+                case QuorumIntersectionChecker::QUORUM_INTERSECTION_OK:
+                    result["status"] = "ok";
+                    break;
+                case QuorumIntersectionChecker::QUORUM_INTERSECTION_SPLIT:
+                    result["status"] = "split";
+                    break;
+                case QuorumIntersectionChecker::QUORUM_INTERSECTION_TIMED_OUT:
+                    result["status"] = "timed out";
+                    break;
+                case QuorumIntersectionChecker::QUORUM_INTERSECTION_CANCELLED:
+                    result["status"] = "cancelled";
+                    break;
+                }
+                result["nodes"] = (Json::UInt64)res.mNodes;
+                result["components"] = (Json::UInt64)res.mComponents;
+                result["quorum_components"] =
+                    (Json::UInt64)res.mQuorumComponents;
+                result["explored"] = (Json::UInt64)res.mExplored;
+                if (!res.mQuorumA.empty())
+                {
+                    Json::Value a, b;
+                    for (auto const& n : res.mQuorumA)
+                    {
+                        a.append(cfg.toShortString(n));
+                    }
+                    for (auto const& n : res.mQuorumB)
+                    {
+                        b.append(cfg.toShortString(n));
+                    }
+                    result["split"].append(a);
+                    result["split"].append(b);
+                }
+                state->mResult = result;
+                state->mChecker.reset();
+                state->mRunning = false;
+            });
+        });
+    }
+
+    Json::Value root;
+    if (state->mRunning)
+    {
+        root["running"] = true;
+        root["explored"] = (Json::UInt64)state->mChecker->getExplored();
+    }
+    else
+    {
+        root["running"] = false;
+    }
+    if (!state->mResult.isNull())
+    {
+        root["last"] = state->mResult;
+    }
+    retStr = root.toStyledString();
+}
+
 void
 CommandHandler::connect(std::string const& params, std::string& retStr)
 {
@@ -5,6 +5,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "lib/http/server.hpp"
+#include <memory>
 #include <string>
 
 /*
@@ -24,12 +25,18 @@ class CommandHandler
     Application& mApp;
     std::unique_ptr<http::server::server> mServer;
 
+    // state of the quorum intersection check started by /checkquorum,
+    // shared with the thread running it
+    struct QuorumCheck;
+    std::shared_ptr<QuorumCheck> mQuorumCheck;
+
     void addRoute(std::string const& name, HandlerRoute route);
     void safeRouter(HandlerRoute route, std::string const& params,
                     std::string& retStr);
 
   public:
     CommandHandler(Application& app);
+    ~CommandHandler();
 
     void manualCmd(std::string const& cmd);
 
@@ -38,6 +45,7 @@ class CommandHandler
     void bans(std::string const& params, std::string& retStr);
     void catchup(std::string const& params, std::string& retStr);
     void checkdb(std::string const& params, std::string& retStr);
+    void checkQuorum(std::string const& params, std::string& retStr);
     void connect(std::string const& params, std::string& retStr);
     void dropcursor(std::string const& params, std::string& retStr);
     void dropPeer(std::string const& params, std::string& retStr);
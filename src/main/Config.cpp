@@ -42,6 +42,9 @@ Config::Config() : NODE_SEED(SecretKey::random())
     MANUAL_CLOSE = false;
     CATCHUP_COMPLETE = false;
     CATCHUP_RECENT = 0;
+    CATCHUP_PIPELINE_WINDOW = 16;
+    CATCHUP_APPLY_BUCKETS_NEWEST_FIRST = false;
+    DISABLE_XDR_FSYNC = false;
     AUTOMATIC_MAINTENANCE_PERIOD = std::chrono::seconds{3600};
     AUTOMATIC_MAINTENANCE_COUNT = 50000;
     ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING = false;
@@ -75,9 +78,13 @@ Config::Config() : NODE_SEED(SecretKey::random())
     MINIMUM_IDLE_PERCENT = 0;
 
     MAX_CONCURRENT_SUBPROCESSES = 16;
+    MAX_CONCURRENT_DEEP_MERGES = 1;
     NODE_IS_VALIDATOR = false;
 
     DATABASE = SecretValue{"sqlite3://:memory:"};
+    ENTRY_CACHE_SIZE = 100000;
+    ORDER_BOOK_CACHE_SIZE = 100000;
+    VERIFY_SIG_CACHE_SIZE = 0xffff;
     NTP_SERVER = "pool.ntp.org";
 }
 
@@ -293,6 +300,14 @@ Config::load(std::string const& filename)
             {
                 CATCHUP_RECENT = readInt<uint32_t>(item, 0, UINT32_MAX - 1);
             }
+            else if (item.first == "CATCHUP_PIPELINE_WINDOW")
+            {
+                CATCHUP_PIPELINE_WINDOW = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "CATCHUP_APPLY_BUCKETS_NEWEST_FIRST")
+            {
+                CATCHUP_APPLY_BUCKETS_NEWEST_FIRST = readBool(item);
+            }
             else if (item.first == "ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING")
             {
                 ARTIFICIALLY_GENERATE_LOAD_FOR_TESTING = readBool(item);
@@ -337,6 +352,10 @@ Config::load(std::string const& filename)
             {
                 BUCKET_DIR_PATH = readString(item);
             }
+            else if (item.first == "DISABLE_XDR_FSYNC")
+            {
+                DISABLE_XDR_FSYNC = readBool(item);
+            }
             else if (item.first == "NODE_NAMES")
             {
                 auto names = readStringArray(item);
@@ -411,6 +430,11 @@ Config::load(std::string const& filename)
                 MAX_CONCURRENT_SUBPROCESSES =
                     static_cast<size_t>(readInt<int>(item, 1));
             }
+            else if (item.first == "MAX_CONCURRENT_DEEP_MERGES")
+            {
+                MAX_CONCURRENT_DEEP_MERGES =
+                    static_cast<size_t>(readInt<int>(item, 1));
+            }
             else if (item.first == "MINIMUM_IDLE_PERCENT")
             {
                 MINIMUM_IDLE_PERCENT = readInt<uint32_t>(item, 0, 100);
@@ -468,6 +492,21 @@ Config::load(std::string const& filename)
             {
                 DATABASE = SecretValue{readString(item)};
             }
+            else if (item.first == "ENTRY_CACHE_SIZE")
+            {
+                ENTRY_CACHE_SIZE = static_cast<size_t>(readInt<int64_t>(
+                    item, 1, std::numeric_limits<uint32_t>::max()));
+            }
+            else if (item.first == "ORDER_BOOK_CACHE_SIZE")
+            {
+                ORDER_BOOK_CACHE_SIZE = static_cast<size_t>(readInt<int64_t>(
+                    item, 1, std::numeric_limits<uint32_t>::max()));
+            }
+            else if (item.first == "VERIFY_SIG_CACHE_SIZE")
+            {
+                VERIFY_SIG_CACHE_SIZE = static_cast<size_t>(readInt<int64_t>(
+                    item, 1, std::numeric_limits<uint32_t>::max()));
+            }
             else if (item.first == "NETWORK_PASSPHRASE")
             {
                 NETWORK_PASSPHRASE = readString(item);
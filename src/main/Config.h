@@ -78,6 +78,20 @@ class Config : public std::enable_shared_from_this<Config>
     // If you want, say, a week of history, set this to 120000.
     uint32_t CATCHUP_RECENT;
 
+    // Number of checkpoints of transactions that catchup may download ahead
+    // of the checkpoint it is applying. Default is 16.
+    uint32_t CATCHUP_PIPELINE_WINDOW;
+
+    // Apply buckets from the newest to the oldest, writing each ledger entry
+    // to the database only once. Invariants are not checked on bucket apply
+    // in this mode. Default is false.
+    bool CATCHUP_APPLY_BUCKETS_NEWEST_FIRST;
+
+    // Skip flushing bucket files and the bucket dir to disk. A crash may
+    // then leave the bucket directory without buckets the database refers
+    // to. Default is false; tests set it to true.
+    bool DISABLE_XDR_FSYNC;
+
     // Interval between automatic maintenance executions
     std::chrono::seconds AUTOMATIC_MAINTENANCE_PERIOD;
 
@@ -177,6 +191,10 @@ class Config : public std::enable_shared_from_this<Config>
     // process-management config
     size_t MAX_CONCURRENT_SUBPROCESSES;
 
+    // Maximum number of merges into deep bucket list levels that run at
+    // once. At least one merge thread is always left to shallow levels.
+    size_t MAX_CONCURRENT_DEEP_MERGES;
+
     // SCP config
     SecretKey NODE_SEED;
     bool NODE_IS_VALIDATOR;
@@ -193,6 +211,18 @@ class Config : public std::enable_shared_from_this<Config>
     // Database config
     SecretValue DATABASE;
 
+    // Maximum number of ledger entries (including known-absent keys) held in
+    // the in-memory cache in front of the ledger tables.
+    size_t ENTRY_CACHE_SIZE;
+
+    // Maximum number of offers held in the in-memory order book; least
+    // recently used asset pairs are evicted beyond it.
+    size_t ORDER_BOOK_CACHE_SIZE;
+
+    // Maximum number of signature verification results held in the
+    // process-wide verify cache.
+    size_t VERIFY_SIG_CACHE_SIZE;
+
     std::vector<std::string> COMMANDS;
     std::vector<std::string> REPORT_METRICS;
 
@@ -35,6 +35,7 @@
 #include <limits>
 #include <locale>
 #include <sodium.h>
+#include <thread>
 
 INITIALIZE_EASYLOGGINGPP
 
@@ -149,7 +150,9 @@ usage(int err = 1)
           "      --help               Display this string\n"
           "      --inferquorum        Print a quorum set inferred from "
           "history\n"
-          "      --checkquorum        Check quorum intersection from history\n"
+          "      --checkquorum[=SECONDS] Check quorum intersection from "
+          "history,\n"
+          "                           giving up after SECONDS if given\n"
           "      --graphquorum        Print a quorum set graph from history\n"
           "      --output-file        Output file for --graphquorum and "
           "--report-last-history-checkpoint commands\n"
@@ -471,6 +474,20 @@ parseLedgerCount(std::string const& str)
     return result;
 }
 
+static uint32_t
+parseCheckQuorumBudget(std::string const& str)
+{
+    auto pos = std::size_t{0};
+    auto result = std::stoul(str, &pos);
+    if (pos < str.length())
+    {
+        throw std::runtime_error(
+            fmt::format("{} is not a valid number of seconds", str));
+    }
+
+    return result;
+}
+
 static void
 setForceSCPFlag(Config const& cfg, bool isOn)
 {
@@ -550,12 +567,13 @@ inferQuorumAndWrite(Config const& cfg)
 }
 
 static void
-checkQuorumIntersection(Config const& cfg)
+checkQuorumIntersection(Config const& cfg, std::chrono::seconds budget)
 {
     VirtualClock clock;
     Application::pointer app = Application::create(clock, cfg, false);
     InferredQuorum iq = app->getHistoryManager().inferQuorum();
-    iq.checkQuorumIntersection(cfg);
+    auto threads = std::max(1u, std::thread::hardware_concurrency());
+    iq.checkQuorumIntersection(cfg, threads, budget);
 }
 
 static void
@@ -687,6 +705,7 @@ main(int argc, char* const* argv)
     uint32_t catchupToTarget = 0;
     bool inferQuorum = false;
     bool checkQuorum = false;
+    std::chrono::seconds checkQuorumBudget(0);
     bool graphQuorum = false;
     bool newDB = false;
     bool getOfflineInfo = false;
@@ -773,6 +792,11 @@ main(int argc, char* const* argv)
             break;
         case OPT_CHECKQUORUM:
             checkQuorum = true;
+            if (optarg)
+            {
+                checkQuorumBudget =
+                    std::chrono::seconds(parseCheckQuorumBudget(optarg));
+            }
             break;
         case OPT_GRAPHQUORUM:
             graphQuorum = true;
@@ -892,7 +916,7 @@ main(int argc, char* const* argv)
             if ((result == 0) && inferQuorum)
                 inferQuorumAndWrite(cfg);
             if ((result == 0) && checkQuorum)
-                checkQuorumIntersection(cfg);
+                checkQuorumIntersection(cfg, checkQuorumBudget);
             if ((result == 0) && graphQuorum)
                 writeQuorumGraph(cfg, outputFile);
             return result;
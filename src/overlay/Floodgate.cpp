@@ -62,7 +62,17 @@ Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer)
     {
         return false;
     }
-    Hash index = sha256(xdr::xdr_to_opaque(msg));
+    return addRecord(msg, peer, sha256(xdr::xdr_to_opaque(msg)));
+}
+
+bool
+Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer,
+                     Hash const& index)
+{
+    if (mShuttingDown)
+    {
+        return false;
+    }
     auto result = mFloodMap.find(index);
     if (result == mFloodMap.end())
     { // we have never seen this message
@@ -86,7 +96,26 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
     {
         return;
     }
-    Hash index = sha256(xdr::xdr_to_opaque(msg));
+    // Serialized once, for the index and for every peer it is sent to.
+    auto serialized = std::make_shared<SerializedMessage const>(msg);
+    broadcast(serialized, msg, force, sha256(serialized->mBytes));
+}
+
+void
+Floodgate::broadcast(StellarMessage const& msg, bool force, Hash const& index)
+{
+    if (mShuttingDown)
+    {
+        return;
+    }
+    broadcast(std::make_shared<SerializedMessage const>(msg), msg, force,
+              index);
+}
+
+void
+Floodgate::broadcast(std::shared_ptr<SerializedMessage const> const& serialized,
+                     StellarMessage const& msg, bool force, Hash const& index)
+{
     CLOG(TRACE, "Overlay") << "broadcast " << hexAbbrev(index);
 
     auto result = mFloodMap.find(index);
@@ -109,7 +138,7 @@ Floodgate::broadcast(StellarMessage const& msg, bool force)
         if (peersTold.find(peer.second) == peersTold.end())
         {
             mSendFromBroadcast.Mark();
-            peer.second->sendMessage(msg);
+            peer.second->sendMessage(serialized);
             peersTold.insert(peer.second);
         }
     }
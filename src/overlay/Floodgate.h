@@ -50,14 +50,21 @@ class Floodgate
     medida::Meter& mSendFromBroadcast;
     bool mShuttingDown;
 
+    void broadcast(std::shared_ptr<SerializedMessage const> const& serialized,
+                   StellarMessage const& msg, bool force, Hash const& index);
+
   public:
     Floodgate(Application& app);
     // Floodgate will be cleared after every ledger close
     void clearBelow(uint32_t currentLedger);
     // returns true if this is a new record
     bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer);
+    // same, for a caller that already has sha256(xdr_to_opaque(msg))
+    bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer,
+                   Hash const& index);
 
     void broadcast(StellarMessage const& msg, bool force);
+    void broadcast(StellarMessage const& msg, bool force, Hash const& index);
 
     // returns the list of peers that sent us the item with hash `h`
     std::set<Peer::pointer> getPeersKnows(Hash const& h);
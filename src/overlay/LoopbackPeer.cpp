@@ -39,7 +39,8 @@ LoopbackPeer::getAuthCert()
 }
 
 void
-LoopbackPeer::sendMessage(xdr::msg_ptr&& msg)
+LoopbackPeer::enqueueMessage(
+    std::shared_ptr<SerializedMessage const> const& msg)
 {
     if (mRemote.expired())
     {
@@ -55,7 +56,7 @@ LoopbackPeer::sendMessage(xdr::msg_ptr&& msg)
     }
 
     // CLOG(TRACE, "Overlay") << "LoopbackPeer queueing message";
-    mOutQueue.emplace_back(std::move(msg));
+    mOutQueue.emplace_back(authenticateMessage(msg).toMsg());
     // Possibly flush some queued messages if queue's full.
     while (mOutQueue.size() > mMaxQueueDepth && !mCorked)
     {
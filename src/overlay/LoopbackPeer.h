@@ -52,7 +52,8 @@ class LoopbackPeer : public Peer
 
     Stats mStats;
 
-    void sendMessage(xdr::msg_ptr&& xdrBytes) override;
+    void enqueueMessage(
+        std::shared_ptr<SerializedMessage const> const& msg) override;
     AuthCert getAuthCert() override;
 
     void processInQueue();
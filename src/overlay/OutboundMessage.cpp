@@ -0,0 +1,62 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/OutboundMessage.h"
+#include "xdrpp/marshal.h"
+#include <cassert>
+#include <cstring>
+
+namespace stellar
+{
+
+size_t const OutboundMessage::HEADER_SIZE;
+
+SerializedMessage::SerializedMessage(StellarMessage const& msg)
+    : mType(msg.type()), mBytes(xdr::xdr_to_opaque(msg))
+{
+}
+
+static void
+putUint32(uint8_t* out, uint32_t v)
+{
+    out[0] = static_cast<uint8_t>(v >> 24);
+    out[1] = static_cast<uint8_t>(v >> 16);
+    out[2] = static_cast<uint8_t>(v >> 8);
+    out[3] = static_cast<uint8_t>(v);
+}
+
+OutboundMessage::OutboundMessage(std::shared_ptr<SerializedMessage const> body,
+                                 uint64_t sequence, HmacSha256Mac const& mac)
+    : mBody(std::move(body)), mMac(mac)
+{
+    // Record mark: the length of everything after it, with the high bit set
+    // to flag the last (only) fragment.
+    auto len = static_cast<uint32_t>(size() - 4);
+    assert(len < 0x80000000);
+    putUint32(mHeader.data(), len | 0x80000000);
+    // AuthenticatedMessage version, then v0's sequence.
+    putUint32(mHeader.data() + 4, 0);
+    putUint32(mHeader.data() + 8, static_cast<uint32_t>(sequence >> 32));
+    putUint32(mHeader.data() + 12, static_cast<uint32_t>(sequence));
+}
+
+size_t
+OutboundMessage::size() const
+{
+    return HEADER_SIZE + mBody->mBytes.size() + mMac.mac.size();
+}
+
+xdr::msg_ptr
+OutboundMessage::toMsg() const
+{
+    auto msg = xdr::message_t::alloc(size() - 4);
+    auto out = reinterpret_cast<uint8_t*>(msg->raw_data());
+    std::memcpy(out, mHeader.data(), HEADER_SIZE);
+    out += HEADER_SIZE;
+    std::memcpy(out, mBody->mBytes.data(), mBody->mBytes.size());
+    out += mBody->mBytes.size();
+    std::memcpy(out, mMac.mac.data(), mMac.mac.size());
+    return msg;
+}
+}
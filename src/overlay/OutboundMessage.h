@@ -0,0 +1,51 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/StellarXDR.h"
+#include "xdrpp/message.h"
+#include <array>
+#include <memory>
+
+namespace stellar
+{
+
+/**
+ * A StellarMessage serialized once, to be sent to any number of peers.
+ */
+struct SerializedMessage
+{
+    explicit SerializedMessage(StellarMessage const& msg);
+
+    MessageType const mType;
+    xdr::opaque_vec<> const mBytes;
+};
+
+/**
+ * A message as it goes on the wire to one peer: the record-marked XDR of an
+ * AuthenticatedMessage, held in three parts so that the StellarMessage in the
+ * middle can be shared with the other peers it is sent to. Only the header
+ * (record mark, union version and MAC sequence) and the MAC belong to this
+ * peer.
+ */
+struct OutboundMessage
+{
+    static size_t const HEADER_SIZE = 16;
+
+    OutboundMessage(std::shared_ptr<SerializedMessage const> body,
+                    uint64_t sequence, HmacSha256Mac const& mac);
+
+    std::array<uint8_t, HEADER_SIZE> mHeader;
+    std::shared_ptr<SerializedMessage const> mBody;
+    HmacSha256Mac mMac;
+
+    // Number of bytes on the wire.
+    size_t size() const;
+
+    // The whole message in one contiguous buffer, as xdr::xdr_to_msg() would
+    // have made it.
+    xdr::msg_ptr toMsg() const;
+};
+}
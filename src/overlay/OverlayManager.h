@@ -67,6 +67,9 @@ class OverlayManager
     // Herder.
     virtual void broadcastMessage(StellarMessage const& msg,
                                   bool force = false) = 0;
+    // Same, for a caller that already has sha256(xdr_to_opaque(msg)).
+    virtual void broadcastMessage(StellarMessage const& msg, bool force,
+                                  Hash const& index) = 0;
 
     // Make a note in the FloodGate that a given peer has provided us with a
     // given broadcast message, so that it is inhibited from being resent to
@@ -74,6 +77,8 @@ class OverlayManager
     // that, call broadcastMessage, above.
     virtual void recvFloodedMsg(StellarMessage const& msg,
                                 Peer::pointer peer) = 0;
+    virtual void recvFloodedMsg(StellarMessage const& msg, Peer::pointer peer,
+                                Hash const& index) = 0;
 
     // Return a list of random peers from the set of authenticated peers.
     virtual std::vector<Peer::pointer> getRandomAuthenticatedPeers() = 0;
@@ -484,6 +484,14 @@ OverlayManagerImpl::recvFloodedMsg(StellarMessage const& msg,
     mFloodGate.addRecord(msg, peer);
 }
 
+void
+OverlayManagerImpl::recvFloodedMsg(StellarMessage const& msg,
+                                   Peer::pointer peer, Hash const& index)
+{
+    mMessagesReceived.Mark();
+    mFloodGate.addRecord(msg, peer, index);
+}
+
 void
 OverlayManagerImpl::broadcastMessage(StellarMessage const& msg, bool force)
 {
@@ -491,6 +499,14 @@ OverlayManagerImpl::broadcastMessage(StellarMessage const& msg, bool force)
     mFloodGate.broadcast(msg, force);
 }
 
+void
+OverlayManagerImpl::broadcastMessage(StellarMessage const& msg, bool force,
+                                     Hash const& index)
+{
+    mMessagesBroadcast.Mark();
+    mFloodGate.broadcast(msg, force, index);
+}
+
 void
 OverlayManager::dropAll(Database& db)
 {
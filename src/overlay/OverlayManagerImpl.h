@@ -71,8 +71,12 @@ class OverlayManagerImpl : public OverlayManager
 
     void ledgerClosed(uint32_t lastClosedledgerSeq) override;
     void recvFloodedMsg(StellarMessage const& msg, Peer::pointer peer) override;
+    void recvFloodedMsg(StellarMessage const& msg, Peer::pointer peer,
+                        Hash const& index) override;
     void broadcastMessage(StellarMessage const& msg,
                           bool force = false) override;
+    void broadcastMessage(StellarMessage const& msg, bool force,
+                          Hash const& index) override;
     void connectTo(std::string const& addr) override;
     virtual void connectTo(PeerRecord& pr) override;
 
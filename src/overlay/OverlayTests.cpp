@@ -4,11 +4,13 @@
 
 #include "BanManager.h"
 #include "crypto/KeyUtils.h"
+#include "crypto/SHA.h"
 #include "crypto/SecretKey.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/LoopbackPeer.h"
+#include "overlay/OutboundMessage.h"
 #include "overlay/OverlayManagerImpl.h"
 #include "overlay/PeerRecord.h"
 #include "overlay/TCPPeer.h"
@@ -22,6 +24,8 @@
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
+#include "xdrpp/marshal.h"
+#include <algorithm>
 #include <numeric>
 
 using namespace stellar;
@@ -441,3 +445,33 @@ TEST_CASE("connecting to saturated nodes", "[overlay]")
     REQUIRE(numberOfSimulationConnections() == 6);
     simulation->crankForAtLeast(std::chrono::seconds{1}, true);
 }
+
+TEST_CASE("outbound message framing matches xdr", "[overlay]")
+{
+    StellarMessage msg;
+    msg.type(GET_SCP_STATE);
+    msg.getSCPLedgerSeq() = 42;
+
+    HmacSha256Key key;
+    key.key.fill(7);
+    uint64_t sequence = 0x0102030405060708;
+
+    auto serialized = std::make_shared<SerializedMessage const>(msg);
+    auto mac =
+        hmacSha256(key, xdr::xdr_to_opaque(sequence), serialized->mBytes);
+    REQUIRE(mac.mac == hmacSha256(key, xdr::xdr_to_opaque(sequence, msg)).mac);
+
+    OutboundMessage out(serialized, sequence, mac);
+
+    AuthenticatedMessage amsg;
+    amsg.v0().sequence = sequence;
+    amsg.v0().message = msg;
+    amsg.v0().mac = mac;
+    xdr::msg_ptr expected = xdr::xdr_to_msg(amsg);
+
+    xdr::msg_ptr got = out.toMsg();
+    REQUIRE(out.size() == expected->raw_size());
+    REQUIRE(got->raw_size() == expected->raw_size());
+    REQUIRE(std::equal(got->raw_data(), got->raw_data() + got->raw_size(),
+                       expected->raw_data()));
+}
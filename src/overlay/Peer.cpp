@@ -10,6 +10,7 @@
 #include "crypto/SHA.h"
 #include "database/Database.h"
 #include "herder/Herder.h"
+#include "herder/HerderUtils.h"
 #include "herder/TxSetFrame.h"
 #include "main/Application.h"
 #include "main/Config.h"
@@ -411,9 +412,9 @@ Peer::sendPeers()
 }
 
 static std::string
-msgSummary(StellarMessage const& msg)
+msgSummary(MessageType type)
 {
-    switch (msg.type())
+    switch (type)
     {
     case ERROR_MSG:
         return "ERROR";
@@ -460,16 +461,22 @@ msgSummary(StellarMessage const& msg)
 
 void
 Peer::sendMessage(StellarMessage const& msg)
+{
+    sendMessage(std::make_shared<SerializedMessage const>(msg));
+}
+
+void
+Peer::sendMessage(std::shared_ptr<SerializedMessage const> const& msg)
 {
     if (Logging::logTrace("Overlay"))
         CLOG(TRACE, "Overlay")
             << "("
             << mApp.getConfig().toShortString(
                    mApp.getConfig().NODE_SEED.getPublicKey())
-            << ") send: " << msgSummary(msg)
+            << ") send: " << msgSummary(msg->mType)
             << " to : " << mApp.getConfig().toShortString(mPeerID);
 
-    switch (msg.type())
+    switch (msg->mType)
     {
     case ERROR_MSG:
         mSendErrorMeter.Mark();
@@ -512,17 +519,22 @@ Peer::sendMessage(StellarMessage const& msg)
         break;
     };
 
-    AuthenticatedMessage amsg;
-    amsg.v0().message = msg;
-    if (msg.type() != HELLO && msg.type() != ERROR_MSG)
+    this->enqueueMessage(msg);
+}
+
+OutboundMessage
+Peer::authenticateMessage(std::shared_ptr<SerializedMessage const> const& msg)
+{
+    uint64_t sequence = 0;
+    HmacSha256Mac mac;
+    if (msg->mType != HELLO && msg->mType != ERROR_MSG)
     {
-        amsg.v0().sequence = mSendMacSeq;
-        amsg.v0().mac =
-            hmacSha256(mSendMacKey, xdr::xdr_to_opaque(mSendMacSeq, msg));
+        sequence = mSendMacSeq;
+        mac = hmacSha256(mSendMacKey, xdr::xdr_to_opaque(mSendMacSeq),
+                         msg->mBytes);
         ++mSendMacSeq;
     }
-    xdr::msg_ptr xdrBytes(xdr::xdr_to_msg(amsg));
-    this->sendMessage(std::move(xdrBytes));
+    return OutboundMessage(msg, sequence, mac);
 }
 
 void
@@ -616,7 +628,7 @@ Peer::recvMessage(StellarMessage const& stellarMsg)
             << "("
             << mApp.getConfig().toShortString(
                    mApp.getConfig().NODE_SEED.getPublicKey())
-            << ") recv: " << msgSummary(stellarMsg)
+            << ") recv: " << msgSummary(stellarMsg.type())
             << " from:" << mApp.getConfig().toShortString(mPeerID);
 
     if (!isAuthenticated() && (stellarMsg.type() != HELLO) &&
@@ -755,8 +767,11 @@ Peer::recvGetTxSet(StellarMessage const& msg)
 void
 Peer::recvTxSet(StellarMessage const& msg)
 {
-    TxSetFrame frame(mApp.getNetworkID(), msg.txSet());
-    mApp.getHerder().recvTxSet(frame.getContentsHash(), frame);
+    auto frame = std::make_shared<TxSetFrame>(mApp.getNetworkID(), msg.txSet());
+    auto& app = mApp;
+    app.getHerder().preverifySignatures(frame->mTransactions, [&app, frame]() {
+        app.getHerder().recvTxSet(frame->getContentsHash(), *frame);
+    });
 }
 
 void
@@ -766,21 +781,38 @@ Peer::recvTransaction(StellarMessage const& msg)
         mApp.getNetworkID(), msg.transaction());
     if (transaction)
     {
-        // add it to our current set
-        // and make sure it is valid
-        auto recvRes = mApp.getHerder().recvTransaction(transaction);
-
-        if (recvRes == Herder::TX_STATUS_PENDING ||
-            recvRes == Herder::TX_STATUS_DUPLICATE)
-        {
-            // record that this peer sent us this transaction
-            mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
-
-            if (recvRes == Herder::TX_STATUS_PENDING)
+        // the peer may be dropped while the signatures are verified, and
+        // must not be kept alive (or credited with the message) past that
+        std::weak_ptr<Peer> weak(shared_from_this());
+        mApp.getHerder().preverifySignatures({transaction}, [weak, transaction,
+                                                             msg]() {
+            auto self = weak.lock();
+            if (self && !self->shouldAbort())
             {
-                // if it's a new transaction, broadcast it
-                mApp.getOverlayManager().broadcastMessage(msg);
+                self->recvVerifiedTransaction(msg, transaction);
             }
+        });
+    }
+}
+
+void
+Peer::recvVerifiedTransaction(StellarMessage const& msg,
+                              TransactionFramePtr transaction)
+{
+    // add it to our current set
+    // and make sure it is valid
+    auto recvRes = mApp.getHerder().recvTransaction(transaction);
+
+    if (recvRes == Herder::TX_STATUS_PENDING ||
+        recvRes == Herder::TX_STATUS_DUPLICATE)
+    {
+        // record that this peer sent us this transaction
+        mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
+
+        if (recvRes == Herder::TX_STATUS_PENDING)
+        {
+            // if it's a new transaction, broadcast it
+            mApp.getOverlayManager().broadcastMessage(msg);
         }
     }
 }
@@ -819,7 +851,10 @@ Peer::recvSCPMessage(StellarMessage const& msg)
             << "recvSCPMessage node: "
             << mApp.getConfig().toShortString(msg.envelope().statement.nodeID);
 
-    mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this());
+    // the envelope is hashed once, for both Floodgate and Herder
+    Hash envelopeHash = getSCPEnvelopeHash(envelope);
+    mApp.getOverlayManager().recvFloodedMsg(msg, shared_from_this(),
+                                            envelopeHash);
 
     auto type = msg.envelope().statement.pledges.type();
     auto t = (type == SCP_ST_PREPARE
@@ -830,7 +865,7 @@ Peer::recvSCPMessage(StellarMessage const& msg)
                                 ? mRecvSCPExternalizeTimer.TimeScope()
                                 : (mRecvSCPNominateTimer.TimeScope()))));
 
-    mApp.getHerder().recvSCPEnvelope(envelope);
+    mApp.getHerder().recvSCPEnvelope(envelope, envelopeHash);
 }
 
 void
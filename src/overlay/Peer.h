@@ -6,6 +6,7 @@
 
 #include "util/asio.h"
 #include "database/Database.h"
+#include "overlay/OutboundMessage.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
@@ -24,6 +25,8 @@ typedef std::shared_ptr<SCPQuorumSet> SCPQuorumSetPtr;
 
 class Application;
 class LoopbackPeer;
+class TransactionFrame;
+using TransactionFramePtr = std::shared_ptr<TransactionFrame>;
 
 /*
  * Another peer out there that we are connected to
@@ -152,6 +155,8 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void recvGetTxSet(StellarMessage const& msg);
     void recvTxSet(StellarMessage const& msg);
     void recvTransaction(StellarMessage const& msg);
+    void recvVerifiedTransaction(StellarMessage const& msg,
+                                 TransactionFramePtr transaction);
     void recvGetSCPQuorumSet(StellarMessage const& msg);
     void recvSCPQuorumSet(StellarMessage const& msg);
     void recvSCPMessage(StellarMessage const& msg);
@@ -163,14 +168,17 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void sendDontHave(MessageType type, uint256 const& itemID);
     void sendPeers();
 
-    // NB: This is a move-argument because the write-buffer has to travel
-    // with the write-request through the async IO system, and we might have
-    // several queued at once. We have carefully arranged this to not copy
-    // data more than the once necessary into this buffer, but it can't be
-    // put in a reused/non-owned buffer without having to buffer/queue
-    // messages somewhere else. The async write request will point _into_
-    // this owned buffer. This is really the best we can do.
-    virtual void sendMessage(xdr::msg_ptr&& xdrBytes) = 0;
+    // Queue `msg` for sending. The message's body is shared with every
+    // other peer it is sent to. Implementations may reorder queued messages
+    // and must frame each one with authenticateMessage() only when it is
+    // about to be written, since MAC sequence numbers have to be sent in
+    // order.
+    virtual void
+    enqueueMessage(std::shared_ptr<SerializedMessage const> const& msg) = 0;
+
+    // Frame `msg` for the wire, taking the next MAC sequence number.
+    OutboundMessage
+    authenticateMessage(std::shared_ptr<SerializedMessage const> const& msg);
     virtual void
     connected()
     {
@@ -201,6 +209,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
 
     void sendMessage(StellarMessage const& msg);
 
+    // Send a message that has already been serialized, possibly for other
+    // peers as well.
+    void sendMessage(std::shared_ptr<SerializedMessage const> const& msg);
+
     PeerRole
     getRole() const
     {
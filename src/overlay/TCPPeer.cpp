@@ -6,6 +6,7 @@
 #include "database/Database.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "overlay/LoadManager.h"
@@ -27,10 +28,40 @@ using namespace std;
 // TCPPeer
 ///////////////////////////////////////////////////////////////////////
 
+// Per-peer limits on queued outbound bytes, by lane. A peer that lets
+// consensus traffic back up this far has stopped reading and is dropped;
+// floods shed their oldest messages instead, and bulk replies are refused
+// (the requester times out and asks someone else).
+static size_t const MAX_SCP_QUEUE_BYTES = MAX_MESSAGE_SIZE;
+static size_t const MAX_FLOOD_QUEUE_BYTES = 4 * 1024 * 1024;
+static size_t const MAX_FETCH_QUEUE_BYTES = 2 * MAX_MESSAGE_SIZE;
+
+// Flooded messages older than this are stale and shed rather than sent.
+static std::chrono::seconds const MAX_FLOOD_AGE(10);
+
+// Small messages are coalesced into one write, up to these limits.
+static size_t const MAX_WRITE_BATCH_BYTES = 256 * 1024;
+static size_t const MAX_WRITE_BATCH_MESSAGES = 64;
+
+TCPPeer::WriteQueue::WriteQueue(medida::MetricsRegistry& metrics,
+                                std::string const& lane)
+    : mMessagesCounter(
+          metrics.NewCounter({"overlay", "outbound-queue", lane + "-messages"}))
+    , mBytesCounter(
+          metrics.NewCounter({"overlay", "outbound-queue", lane + "-bytes"}))
+    , mDropMeter(metrics.NewMeter(
+          {"overlay", "outbound-queue", lane + "-dropped"}, "message"))
+{
+}
+
 TCPPeer::TCPPeer(Application& app, Peer::PeerRole role,
                  std::shared_ptr<TCPPeer::SocketType> socket)
     : Peer(app, role), mSocket(socket)
 {
+    mWriteQueues.reserve(LANE_COUNT);
+    mWriteQueues.emplace_back(app.getMetrics(), "scp");
+    mWriteQueues.emplace_back(app.getMetrics(), "flood");
+    mWriteQueues.emplace_back(app.getMetrics(), "fetch");
 }
 
 TCPPeer::pointer
@@ -99,6 +130,7 @@ TCPPeer::~TCPPeer()
 {
     assertThreadIsMain();
     mIdleTimer.cancel();
+    clearWriteQueues();
     if (mSocket)
     {
         // Ignore: this indicates an attempt to cancel events
@@ -120,8 +152,70 @@ TCPPeer::getIP()
     return mIP;
 }
 
+TCPPeer::WriteLane
+TCPPeer::laneFor(MessageType type)
+{
+    switch (type)
+    {
+    case TRANSACTION:
+        return LANE_FLOOD;
+    case TX_SET:
+    case PEERS:
+        return LANE_FETCH;
+    default:
+        return LANE_SCP;
+    }
+}
+
+size_t
+TCPPeer::queuedMessages() const
+{
+    size_t n = 0;
+    for (auto const& q : mWriteQueues)
+    {
+        n += q.mMessages.size();
+    }
+    return n;
+}
+
+void
+TCPPeer::pushQueued(WriteLane lane, QueuedMessage msg)
+{
+    auto& q = mWriteQueues[lane];
+    auto size = msg.mMessage->mBytes.size();
+    q.mMessages.emplace_back(std::move(msg));
+    q.mBytes += size;
+    q.mMessagesCounter.inc();
+    q.mBytesCounter.inc(size);
+}
+
+TCPPeer::QueuedMessage
+TCPPeer::popQueued(WriteLane lane)
+{
+    auto& q = mWriteQueues[lane];
+    auto msg = std::move(q.mMessages.front());
+    q.mMessages.pop_front();
+    auto size = msg.mMessage->mBytes.size();
+    q.mBytes -= size;
+    q.mMessagesCounter.dec();
+    q.mBytesCounter.dec(size);
+    return msg;
+}
+
+void
+TCPPeer::clearWriteQueues()
+{
+    for (auto& q : mWriteQueues)
+    {
+        q.mMessagesCounter.dec(q.mMessages.size());
+        q.mBytesCounter.dec(q.mBytes);
+        q.mMessages.clear();
+        q.mBytes = 0;
+    }
+}
+
 void
-TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
+TCPPeer::enqueueMessage(std::shared_ptr<SerializedMessage const> const& msg)
 {
     if (mState == CLOSING)
     {
@@ -134,12 +228,43 @@ TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
         CLOG(TRACE, "Overlay") << "TCPPeer:sendMessage to " << toString();
     assertThreadIsMain();
 
-    // places the buffer to write into the write queue
-    auto buf = std::make_shared<xdr::msg_ptr>(std::move(xdrBytes));
+    auto lane = laneFor(msg->mType);
+    auto& q = mWriteQueues[lane];
+    auto size = msg->mBytes.size();
+    switch (lane)
+    {
+    case LANE_SCP:
+        if (q.mBytes + size > MAX_SCP_QUEUE_BYTES)
+        {
+            CLOG(WARNING, "Overlay") << "Outbound SCP queue to " << toString()
+                                     << " is full, dropping peer";
+            q.mDropMeter.Mark();
+            drop();
+            return;
+        }
+        break;
+    case LANE_FLOOD:
+        while (!q.mMessages.empty() && q.mBytes + size > MAX_FLOOD_QUEUE_BYTES)
+        {
+            popQueued(lane);
+            q.mDropMeter.Mark();
+        }
+        break;
+    case LANE_FETCH:
+        if (!q.mMessages.empty() && q.mBytes + size > MAX_FETCH_QUEUE_BYTES)
+        {
+            q.mDropMeter.Mark();
+            return;
+        }
+        break;
+    default:
+        assert(false);
+    }
 
+    // places the message to write into the write queue
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
 
-    self->mWriteQueue.emplace(buf);
+    self->pushQueued(lane, QueuedMessage{msg, mApp.getClock().now()});
 
     if (!self->mWriting)
     {
@@ -149,6 +274,40 @@ TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
     }
 }
 
+void
+TCPPeer::fillWriteBatch()
+{
+    assert(mWriteBatch.empty());
+    auto now = mApp.getClock().now();
+    size_t bytes = 0;
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        auto lane = static_cast<WriteLane>(i);
+        auto& q = mWriteQueues[lane];
+        while (!q.mMessages.empty())
+        {
+            if (mWriteBatch.size() >= MAX_WRITE_BATCH_MESSAGES ||
+                (!mWriteBatch.empty() &&
+                 bytes + q.mMessages.front().mMessage->mBytes.size() >
+                     MAX_WRITE_BATCH_BYTES))
+            {
+                // Full: what is left, starting with this lane, goes next.
+                return;
+            }
+            auto queued = popQueued(lane);
+            if (lane == LANE_FLOOD && now - queued.mQueuedAt > MAX_FLOOD_AGE)
+            {
+                q.mDropMeter.Mark();
+                continue;
+            }
+            // MAC sequence numbers are taken here, in the order messages go
+            // out on the wire, not when they were queued.
+            mWriteBatch.emplace_back(authenticateMessage(queued.mMessage));
+            bytes += mWriteBatch.back().size();
+        }
+    }
+}
+
 void
 TCPPeer::shutdown()
 {
@@ -214,14 +373,16 @@ TCPPeer::messageSender()
 
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
 
+    fillWriteBatch();
+
     // if nothing to do, flush and return
-    if (mWriteQueue.empty())
+    if (mWriteBatch.empty())
     {
         mSocket->async_flush([self](asio::error_code const& ec, std::size_t) {
             self->writeHandler(ec, 0);
             if (!ec)
             {
-                if (!self->mWriteQueue.empty())
+                if (self->queuedMessages() != 0)
                 {
                     self->messageSender();
                 }
@@ -240,16 +401,27 @@ TCPPeer::messageSender()
         return;
     }
 
-    // peek the buffer from the queue
-    // do not remove it yet as we need the buffer for the duration of the
-    // write operation
-    auto buf = mWriteQueue.front();
+    // mWriteBatch holds the messages for the duration of the write
+    // operation; each contributes its own header and MAC around a body that
+    // may be shared with other peers.
+    std::vector<asio::const_buffer> buffers;
+    buffers.reserve(3 * mWriteBatch.size());
+    for (auto const& msg : mWriteBatch)
+    {
+        buffers.emplace_back(asio::buffer(msg.mHeader));
+        buffers.emplace_back(
+            asio::buffer(msg.mBody->mBytes.data(), msg.mBody->mBytes.size()));
+        buffers.emplace_back(
+            asio::buffer(msg.mMac.mac.data(), msg.mMac.mac.size()));
+    }
 
-    asio::async_write(*(mSocket.get()),
-                      asio::buffer((*buf)->raw_data(), (*buf)->raw_size()),
+    // Written straight to the socket, gathering the parts in one system
+    // call, rather than copied through the buffered stream's write buffer;
+    // the buffered stream is only used for reading.
+    asio::async_write(mSocket->next_layer(), buffers,
                       [self](asio::error_code const& ec, std::size_t length) {
                           self->writeHandler(ec, length);
-                          self->mWriteQueue.pop(); // done with front element
+                          self->mWriteBatch.clear(); // done with the batch
 
                           // continue processing the queue/flush
                           if (!ec)
@@ -290,7 +462,7 @@ TCPPeer::writeHandler(asio::error_code const& error,
     else if (bytes_transferred != 0)
     {
         LoadManager::PeerContext loadCtx(mApp, mPeerID);
-        mMessageWrite.Mark();
+        mMessageWrite.Mark(mWriteBatch.size());
         mByteWrite.Mark(bytes_transferred);
     }
 }
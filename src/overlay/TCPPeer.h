@@ -6,11 +6,14 @@
 
 #include "overlay/Peer.h"
 #include "util/Timer.h"
-#include <queue>
+#include <deque>
+#include <vector>
 
 namespace medida
 {
+class Counter;
 class Meter;
+class MetricsRegistry;
 }
 
 namespace stellar
@@ -31,14 +34,50 @@ class TCPPeer : public Peer
     std::vector<uint8_t> mIncomingHeader;
     std::vector<uint8_t> mIncomingBody;
 
-    std::queue<std::shared_ptr<xdr::msg_ptr>> mWriteQueue;
+    // Outbound messages wait in one queue per lane, and lower lanes are
+    // written first.
+    enum WriteLane
+    {
+        LANE_SCP = 0, // consensus traffic, handshake and small requests
+        LANE_FLOOD,   // flooded transactions
+        LANE_FETCH,   // bulk replies: transaction sets and peer lists
+        LANE_COUNT
+    };
+
+    struct QueuedMessage
+    {
+        std::shared_ptr<SerializedMessage const> mMessage;
+        VirtualClock::time_point mQueuedAt;
+    };
+
+    // Counters and meters are shared by all peers.
+    struct WriteQueue
+    {
+        WriteQueue(medida::MetricsRegistry& metrics, std::string const& lane);
+
+        std::deque<QueuedMessage> mMessages;
+        size_t mBytes{0};
+        medida::Counter& mMessagesCounter;
+        medida::Counter& mBytesCounter;
+        medida::Meter& mDropMeter;
+    };
+
+    std::vector<WriteQueue> mWriteQueues; // indexed by WriteLane
+    std::vector<OutboundMessage> mWriteBatch; // being written
     bool mWriting{false};
     bool mDelayedShutdown{false};
     bool mShutdownScheduled{false};
 
     void recvMessage();
-    void sendMessage(xdr::msg_ptr&& xdrBytes) override;
-
+    void enqueueMessage(
+        std::shared_ptr<SerializedMessage const> const& msg) override;
+
+    static WriteLane laneFor(MessageType type);
+    size_t queuedMessages() const;
+    void pushQueued(WriteLane lane, QueuedMessage msg);
+    QueuedMessage popQueued(WriteLane lane);
+    void clearWriteQueues();
+    void fillWriteBatch();
     void messageSender();
 
     int getIncomingMsgLength();
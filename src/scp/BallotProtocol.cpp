@@ -1340,6 +1340,9 @@ BallotProtocol::attemptBump()
         // if so, we move to that smallest counter
         allCounters.insert(targetCounter);
 
+        auto localNode = getLocalNode();
+        auto& evaluator = mSlot.getSCP().getQuorumEvaluator();
+
         // go through the counters, find the smallest not v-blocking
         for (auto it = allCounters.begin(); it != allCounters.end(); it++)
         {
@@ -1349,9 +1352,9 @@ BallotProtocol::attemptBump()
                 break;
             }
 
-            bool vBlocking = LocalNode::isVBlocking(
-                getLocalNode()->getQuorumSet(), mLatestEnvelopes,
-                [&](SCPStatement const& st) {
+            bool vBlocking = evaluator.isVBlocking(
+                localNode->getQuorumSet(), localNode->getQuorumSetHash(),
+                mLatestEnvelopes, [&](SCPStatement const& st) {
                     bool res;
                     auto const& pl = st.pledges;
                     if (pl.type() == SCP_ST_PREPARE)
@@ -2078,10 +2081,10 @@ BallotProtocol::checkHeardFromQuorum()
 {
     if (mCurrentBallot)
     {
-        if (LocalNode::isQuorum(
-                getLocalNode()->getQuorumSet(), mLatestEnvelopes,
-                std::bind(&Slot::getQuorumSetFromStatement, &mSlot, _1),
-                [&](SCPStatement const& st) {
+        auto localNode = getLocalNode();
+        if (mSlot.getSCP().getQuorumEvaluator().isQuorum(
+                localNode->getQuorumSet(), localNode->getQuorumSetHash(),
+                mLatestEnvelopes, [&](SCPStatement const& st) {
                     bool res;
                     if (st.pledges.type() == SCP_ST_PREPARE)
                     {
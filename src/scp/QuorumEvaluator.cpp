@@ -0,0 +1,273 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "scp/QuorumEvaluator.h"
+#include "scp/Slot.h"
+#include <algorithm>
+#include <bitset>
+
+namespace stellar
+{
+
+namespace
+{
+// number of validators of qSet (repeats included) that are in nodes
+size_t
+countCommon(QuorumEvaluator::CompiledQSet const& qSet,
+            QuorumEvaluator::NodeBits const& nodes)
+{
+    size_t res = 0;
+    size_t words = std::min(qSet.mValidators.size(), nodes.size());
+    for (size_t w = 0; w < words; ++w)
+    {
+        res += std::bitset<64>(qSet.mValidators[w] & nodes[w]).count();
+    }
+    for (auto i : qSet.mDuplicates)
+    {
+        if (QuorumEvaluator::testBit(nodes, i))
+        {
+            res++;
+        }
+    }
+    return res;
+}
+}
+
+void
+QuorumEvaluator::setBit(NodeBits& bits, uint32 i)
+{
+    if (bits.size() <= i / 64)
+    {
+        bits.resize(i / 64 + 1, 0);
+    }
+    bits[i / 64] |= uint64_t(1) << (i % 64);
+}
+
+void
+QuorumEvaluator::clearBit(NodeBits& bits, uint32 i)
+{
+    if (i / 64 < bits.size())
+    {
+        bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+}
+
+bool
+QuorumEvaluator::testBit(NodeBits const& bits, uint32 i)
+{
+    return i / 64 < bits.size() && (bits[i / 64] >> (i % 64)) & 1;
+}
+
+QuorumEvaluator::QuorumEvaluator(SCPDriver& driver)
+    : mDriver(driver), mCompiled(COMPILED_CACHE_SIZE)
+{
+}
+
+bool
+QuorumEvaluator::isQuorumSlice(CompiledQSet const& qSet, NodeBits const& nodes)
+{
+    // as in LocalNode, a threshold of 0 is never met
+    if (qSet.mThreshold == 0)
+    {
+        return false;
+    }
+
+    size_t count = countCommon(qSet, nodes);
+    if (count >= qSet.mThreshold)
+    {
+        return true;
+    }
+    for (auto const& inner : qSet.mInnerSets)
+    {
+        if (isQuorumSlice(inner, nodes) && ++count >= qSet.mThreshold)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+QuorumEvaluator::isVBlocking(CompiledQSet const& qSet, NodeBits const& nodes)
+{
+    // There is no v-blocking set for {\empty}
+    if (qSet.mThreshold == 0)
+    {
+        return false;
+    }
+
+    // at least one member is needed even if the threshold cannot be met
+    int64_t leftTillBlock =
+        int64_t(1 + qSet.mMembers) - int64_t(qSet.mThreshold);
+    size_t needed = size_t(std::max<int64_t>(1, leftTillBlock));
+
+    size_t count = countCommon(qSet, nodes);
+    if (count >= needed)
+    {
+        return true;
+    }
+    for (auto const& inner : qSet.mInnerSets)
+    {
+        if (isVBlocking(inner, nodes) && ++count >= needed)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+QuorumEvaluator::isVBlocking(
+    SCPQuorumSet const& qSet, Hash const& qSetHash,
+    std::map<NodeID, SCPEnvelope> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    maybeReset();
+    auto compiled = getCompiled(qSet, qSetHash);
+
+    NodeBits nodes;
+    for (auto const& it : map)
+    {
+        if (filter(it.second.statement))
+        {
+            setBit(nodes, intern(it.first));
+        }
+    }
+    return isVBlocking(*compiled, nodes);
+}
+
+bool
+QuorumEvaluator::isQuorum(
+    SCPQuorumSet const& qSet, Hash const& qSetHash,
+    std::map<NodeID, SCPEnvelope> const& map,
+    std::function<bool(SCPStatement const&)> const& filter)
+{
+    maybeReset();
+    auto compiled = getCompiled(qSet, qSetHash);
+
+    NodeBits nodes;
+    std::vector<std::pair<uint32, CompiledQSetPtr>> members;
+    for (auto const& it : map)
+    {
+        if (filter(it.second.statement))
+        {
+            auto i = intern(it.first);
+            setBit(nodes, i);
+            members.emplace_back(i, getCompiled(it.second.statement));
+        }
+    }
+
+    // drop nodes that do not have a slice within the set until none is left
+    // to drop; removing them as we go reaches the same fixed point as
+    // removing them a pass at a time
+    bool changed;
+    do
+    {
+        changed = false;
+        for (auto const& m : members)
+        {
+            if (testBit(nodes, m.first) &&
+                !(m.second && isQuorumSlice(*m.second, nodes)))
+            {
+                clearBit(nodes, m.first);
+                changed = true;
+            }
+        }
+    } while (changed);
+
+    return isQuorumSlice(*compiled, nodes);
+}
+
+void
+QuorumEvaluator::maybeReset()
+{
+    if (mNodeIndex.size() > MAX_INTERNED_NODES)
+    {
+        mNodeIndex.clear();
+        mCompiled.clear();
+        mSingletons.clear();
+    }
+}
+
+uint32
+QuorumEvaluator::intern(NodeID const& node)
+{
+    auto res = mNodeIndex.emplace(node, uint32(mNodeIndex.size()));
+    return res.first->second;
+}
+
+QuorumEvaluator::CompiledQSet
+QuorumEvaluator::compile(SCPQuorumSet const& qSet,
+                         std::function<uint32(NodeID const&)> const& index)
+{
+    CompiledQSet res;
+    res.mThreshold = qSet.threshold;
+    res.mMembers = qSet.validators.size() + qSet.innerSets.size();
+    for (auto const& v : qSet.validators)
+    {
+        auto i = index(v);
+        if (testBit(res.mValidators, i))
+        {
+            res.mDuplicates.emplace_back(i);
+        }
+        else
+        {
+            setBit(res.mValidators, i);
+        }
+    }
+    for (auto const& inner : qSet.innerSets)
+    {
+        res.mInnerSets.emplace_back(compile(inner, index));
+    }
+    return res;
+}
+
+QuorumEvaluator::CompiledQSetPtr
+QuorumEvaluator::getCompiled(SCPQuorumSet const& qSet, Hash const& qSetHash)
+{
+    if (mCompiled.exists(qSetHash))
+    {
+        return mCompiled.get(qSetHash);
+    }
+    auto res = std::make_shared<CompiledQSet const>(
+        compile(qSet, [this](NodeID const& n) { return intern(n); }));
+    mCompiled.put(qSetHash, res);
+    return res;
+}
+
+QuorumEvaluator::CompiledQSetPtr
+QuorumEvaluator::getCompiled(SCPStatement const& st)
+{
+    if (st.pledges.type() == SCP_ST_EXTERNALIZE)
+    {
+        auto i = intern(st.nodeID);
+        if (mSingletons.size() <= i)
+        {
+            mSingletons.resize(i + 1);
+        }
+        auto& res = mSingletons[i];
+        if (!res)
+        {
+            auto singleton = std::make_shared<CompiledQSet>();
+            singleton->mThreshold = 1;
+            singleton->mMembers = 1;
+            setBit(singleton->mValidators, i);
+            res = singleton;
+        }
+        return res;
+    }
+
+    Hash h = Slot::getCompanionQuorumSetHashFromStatement(st);
+    if (mCompiled.exists(h))
+    {
+        return mCompiled.get(h);
+    }
+    auto qSet = mDriver.getQSet(h);
+    if (!qSet)
+    {
+        return nullptr;
+    }
+    return getCompiled(*qSet, h);
+}
+}
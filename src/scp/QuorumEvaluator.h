@@ -0,0 +1,95 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SecretKey.h"
+#include "lib/util/lrucache.hpp"
+#include "scp/SCPDriver.h"
+#include "util/HashOfHash.h"
+#include "util/NonCopyable.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Evaluates quorum slices, quorums and v-blocking sets over compiled quorum
+ * sets; gives the same answers as the LocalNode helpers of the same names.
+ *
+ * Every node is interned to a dense index, so a set of nodes is a bitset and
+ * the validators of a quorum set are counted against it with popcount rather
+ * than a search per validator. Compiled quorum sets are cached by hash; the
+ * quorum sets of statements are resolved through the SCPDriver once per
+ * evaluation instead of once per node per pass of the fixed point.
+ *
+ * Indices are never reused while anything refers to them, so the intern
+ * table only grows; once it holds more than MAX_INTERNED_NODES nodes it is
+ * dropped, together with every compiled quorum set, at the start of the next
+ * evaluation.
+ */
+class QuorumEvaluator : NonMovableOrCopyable
+{
+  public:
+    // bit i is set iff the node interned as i is in the set
+    typedef std::vector<uint64_t> NodeBits;
+
+    struct CompiledQSet
+    {
+        uint32 mThreshold;
+        // validators.size() + innerSets.size() of the source quorum set
+        size_t mMembers;
+        NodeBits mValidators;
+        // indices of validators listed more than once, once per repeat
+        std::vector<uint32> mDuplicates;
+        std::vector<CompiledQSet> mInnerSets;
+    };
+    typedef std::shared_ptr<CompiledQSet const> CompiledQSetPtr;
+
+    static size_t const MAX_INTERNED_NODES = 10000;
+    static size_t const COMPILED_CACHE_SIZE = 1000;
+
+    explicit QuorumEvaluator(SCPDriver& driver);
+
+    // see LocalNode::isVBlocking
+    bool isVBlocking(SCPQuorumSet const& qSet, Hash const& qSetHash,
+                     std::map<NodeID, SCPEnvelope> const& map,
+                     std::function<bool(SCPStatement const&)> const& filter);
+
+    // see LocalNode::isQuorum; the quorum set of each statement is the one
+    // Slot::getQuorumSetFromStatement returns
+    bool isQuorum(SCPQuorumSet const& qSet, Hash const& qSetHash,
+                  std::map<NodeID, SCPEnvelope> const& map,
+                  std::function<bool(SCPStatement const&)> const& filter);
+
+    static bool isQuorumSlice(CompiledQSet const& qSet, NodeBits const& nodes);
+    static bool isVBlocking(CompiledQSet const& qSet, NodeBits const& nodes);
+
+    // compiles `qSet`, numbering its nodes with `index`
+    static CompiledQSet
+    compile(SCPQuorumSet const& qSet,
+            std::function<uint32(NodeID const&)> const& index);
+
+    static void setBit(NodeBits& bits, uint32 i);
+    static void clearBit(NodeBits& bits, uint32 i);
+    static bool testBit(NodeBits const& bits, uint32 i);
+
+  private:
+    SCPDriver& mDriver;
+    std::unordered_map<NodeID, uint32> mNodeIndex;
+    cache::lru_cache<Hash, CompiledQSetPtr> mCompiled;
+    // {{node}} quorum sets of EXTERNALIZE statements, by node index
+    std::vector<CompiledQSetPtr> mSingletons;
+
+    void maybeReset();
+    uint32 intern(NodeID const& node);
+    CompiledQSetPtr getCompiled(SCPQuorumSet const& qSet, Hash const& qSetHash);
+    // returns nullptr if the quorum set of `st` is not known
+    CompiledQSetPtr getCompiled(SCPStatement const& st);
+};
+}
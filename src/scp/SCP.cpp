@@ -20,7 +20,7 @@ using xdr::operator==;
 
 SCP::SCP(SCPDriver& driver, NodeID const& nodeID, bool isValidator,
          SCPQuorumSet const& qSetLocal)
-    : mDriver(driver)
+    : mDriver(driver), mQuorumEvaluator(driver)
 {
     mLocalNode =
         std::make_shared<LocalNode>(nodeID, isValidator, qSetLocal, this);
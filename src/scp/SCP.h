@@ -12,6 +12,7 @@
 
 #include "crypto/SecretKey.h"
 #include "lib/json/json-forwards.h"
+#include "scp/QuorumEvaluator.h"
 #include "scp/SCPDriver.h"
 
 namespace stellar
@@ -24,6 +25,7 @@ typedef std::shared_ptr<SCPQuorumSet> SCPQuorumSetPtr;
 class SCP
 {
     SCPDriver& mDriver;
+    QuorumEvaluator mQuorumEvaluator;
 
   public:
     SCP(SCPDriver& driver, NodeID const& nodeID, bool isValidator,
@@ -40,6 +42,13 @@ class SCP
         return mDriver;
     }
 
+    // shared by all slots, so that compiled quorum sets outlive a slot
+    QuorumEvaluator&
+    getQuorumEvaluator()
+    {
+        return mQuorumEvaluator;
+    }
+
     enum EnvelopeState
     {
         INVALID, // the envelope is considered invalid
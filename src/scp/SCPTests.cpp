@@ -11,6 +11,7 @@
 #include "scp/Slot.h"
 #include "simulation/Simulation.h"
 #include "util/Logging.h"
+#include "util/Math.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/printer.h"
@@ -514,6 +515,89 @@ TEST_CASE("v-blocking distance", "[scp]")
     check(qSet, good, 4);
 }
 
+TEST_CASE("quorum evaluator matches LocalNode", "[scp]")
+{
+    std::vector<SecretKey> keys;
+    for (int i = 0; i < 12; i++)
+    {
+        keys.emplace_back(
+            SecretKey::fromSeed(sha256("NODE_SEED_" + std::to_string(i))));
+    }
+
+    // validators may repeat and thresholds may be out of range, to cover
+    // the corner cases of LocalNode as well
+    std::function<SCPQuorumSet(int)> randomQSet = [&](int depth) {
+        SCPQuorumSet q;
+        auto nValidators = rand_uniform<size_t>(1, 4);
+        for (size_t i = 0; i < nValidators; i++)
+        {
+            q.validators.emplace_back(rand_element(keys).getPublicKey());
+        }
+        auto nInner = depth > 0 ? rand_uniform<size_t>(0, 2) : 0;
+        for (size_t i = 0; i < nInner; i++)
+        {
+            q.innerSets.emplace_back(randomQSet(depth - 1));
+        }
+        q.threshold = rand_uniform<uint32>(
+            0, uint32(q.validators.size() + q.innerSets.size() + 1));
+        return q;
+    };
+
+    TestSCP scp(keys[0].getPublicKey(), randomQSet(2));
+    auto& evaluator = scp.mSCP.getQuorumEvaluator();
+
+    std::vector<Hash> qSetHashes;
+    for (int i = 0; i < 8; i++)
+    {
+        auto q = std::make_shared<SCPQuorumSet>(randomQSet(1));
+        scp.storeQuorumSet(q);
+        qSetHashes.emplace_back(sha256(xdr::xdr_to_opaque(*q)));
+    }
+    // a quorum set the driver does not know
+    qSetHashes.emplace_back(sha256("unknown"));
+
+    auto qfun = [&](SCPStatement const& st) {
+        if (st.pledges.type() == SCP_ST_EXTERNALIZE)
+        {
+            return LocalNode::getSingletonQSet(st.nodeID);
+        }
+        return scp.getQSet(Slot::getCompanionQuorumSetHashFromStatement(st));
+    };
+    auto all = [](SCPStatement const&) { return true; };
+    auto notExternalized = [](SCPStatement const& st) {
+        return st.pledges.type() != SCP_ST_EXTERNALIZE;
+    };
+
+    SCPBallot b(1, xValue);
+    for (int round = 0; round < 200; round++)
+    {
+        auto qSet = randomQSet(2);
+        auto qSetHash = sha256(xdr::xdr_to_opaque(qSet));
+
+        std::map<NodeID, SCPEnvelope> envs;
+        for (auto const& k : keys)
+        {
+            if (rand_flip())
+            {
+                auto const& h = rand_element(qSetHashes);
+                envs[k.getPublicKey()] = rand_uniform(0, 3) == 0
+                                             ? makeExternalize(k, h, 0, b, 1)
+                                             : makePrepare(k, h, 0, b);
+            }
+        }
+
+        for (auto const& filter :
+             std::vector<std::function<bool(SCPStatement const&)>>{
+                 all, notExternalized})
+        {
+            REQUIRE(evaluator.isVBlocking(qSet, qSetHash, envs, filter) ==
+                    LocalNode::isVBlocking(qSet, envs, filter));
+            REQUIRE(evaluator.isQuorum(qSet, qSetHash, envs, filter) ==
+                    LocalNode::isQuorum(qSet, envs, qfun, filter));
+        }
+    }
+}
+
 typedef std::function<SCPEnvelope(SecretKey const& sk)> genEnvelope;
 
 using namespace std::placeholders;
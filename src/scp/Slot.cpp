@@ -343,9 +343,13 @@ bool
 Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
                       std::map<NodeID, SCPEnvelope> const& envs)
 {
+    auto localNode = getLocalNode();
+    auto& evaluator = mSCP.getQuorumEvaluator();
+
     // Checks if the nodes that claimed to accept the statement form a
     // v-blocking set
-    if (LocalNode::isVBlocking(getLocalNode()->getQuorumSet(), envs, accepted))
+    if (evaluator.isVBlocking(localNode->getQuorumSet(),
+                              localNode->getQuorumSetHash(), envs, accepted))
     {
         return true;
     }
@@ -358,10 +362,8 @@ Slot::federatedAccept(StatementPredicate voted, StatementPredicate accepted,
         return res;
     };
 
-    if (LocalNode::isQuorum(
-            getLocalNode()->getQuorumSet(), envs,
-            std::bind(&Slot::getQuorumSetFromStatement, this, _1),
-            ratifyFilter))
+    if (evaluator.isQuorum(localNode->getQuorumSet(),
+                           localNode->getQuorumSetHash(), envs, ratifyFilter))
     {
         return true;
     }
@@ -373,9 +375,10 @@ bool
 Slot::federatedRatify(StatementPredicate voted,
                       std::map<NodeID, SCPEnvelope> const& envs)
 {
-    return LocalNode::isQuorum(
-        getLocalNode()->getQuorumSet(), envs,
-        std::bind(&Slot::getQuorumSetFromStatement, this, _1), voted);
+    auto localNode = getLocalNode();
+    return mSCP.getQuorumEvaluator().isQuorum(localNode->getQuorumSet(),
+                                              localNode->getQuorumSetHash(),
+                                              envs, voted);
 }
 
 std::shared_ptr<LocalNode>
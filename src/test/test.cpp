@@ -79,6 +79,7 @@ getTestConfig(int instanceNumber, Config::TestDbMode mode)
         sstream << "stellar" << instanceNumber << ".log";
         thisConfig.LOG_FILE_PATH = sstream.str();
         thisConfig.BUCKET_DIR_PATH = rootDir + "bucket";
+        thisConfig.DISABLE_XDR_FSYNC = true;
 
         thisConfig.INVARIANT_CHECKS = {"AccountSubEntriesCountIsValid",
                                        "BucketListIsConsistentWithDatabase",
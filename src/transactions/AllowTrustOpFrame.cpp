@@ -65,18 +65,7 @@ AllowTrustOpFrame::doApply(Application& app, LedgerDelta& delta,
         return false;
     }
 
-    Asset ci;
-    ci.type(mAllowTrust.asset.type());
-    if (mAllowTrust.asset.type() == ASSET_TYPE_CREDIT_ALPHANUM4)
-    {
-        ci.alphaNum4().assetCode = mAllowTrust.asset.assetCode4();
-        ci.alphaNum4().issuer = getSourceID();
-    }
-    else if (mAllowTrust.asset.type() == ASSET_TYPE_CREDIT_ALPHANUM12)
-    {
-        ci.alphaNum12().assetCode = mAllowTrust.asset.assetCode12();
-        ci.alphaNum12().issuer = getSourceID();
-    }
+    Asset ci = getAsset();
 
     Database& db = ledgerManager.getDatabase();
     TrustFrame::pointer trustLine;
@@ -116,6 +105,24 @@ AllowTrustOpFrame::doCheckValid(Application& app)
         innerResult().code(ALLOW_TRUST_MALFORMED);
         return false;
     }
+    Asset ci = getAsset();
+
+    if (!isAssetValid(ci))
+    {
+        app.getMetrics()
+            .NewMeter({"op-allow-trust", "invalid", "malformed-invalid-asset"},
+                      "operation")
+            .Mark();
+        innerResult().code(ALLOW_TRUST_MALFORMED);
+        return false;
+    }
+
+    return true;
+}
+
+Asset
+AllowTrustOpFrame::getAsset() const
+{
     Asset ci;
     ci.type(mAllowTrust.asset.type());
     if (mAllowTrust.asset.type() == ASSET_TYPE_CREDIT_ALPHANUM4)
@@ -128,17 +135,13 @@ AllowTrustOpFrame::doCheckValid(Application& app)
         ci.alphaNum12().assetCode = mAllowTrust.asset.assetCode12();
         ci.alphaNum12().issuer = getSourceID();
     }
+    return ci;
+}
 
-    if (!isAssetValid(ci))
-    {
-        app.getMetrics()
-            .NewMeter({"op-allow-trust", "invalid", "malformed-invalid-asset"},
-                      "operation")
-            .Mark();
-        innerResult().code(ALLOW_TRUST_MALFORMED);
-        return false;
-    }
-
-    return true;
+void
+AllowTrustOpFrame::insertLedgerKeysToPrefetch(
+    std::vector<LedgerKey>& keys) const
+{
+    insertTrustLineKeys(keys, mAllowTrust.trustor, getAsset());
 }
 }
@@ -162,4 +162,11 @@ ChangeTrustOpFrame::doCheckValid(Application& app)
     }
     return true;
 }
+
+void
+ChangeTrustOpFrame::insertLedgerKeysToPrefetch(
+    std::vector<LedgerKey>& keys) const
+{
+    insertTrustLineKeys(keys, getSourceID(), mChangeTrust.line);
+}
 }
@@ -126,4 +126,11 @@ CreateAccountOpFrame::doCheckValid(Application& app)
 
     return true;
 }
+
+void
+CreateAccountOpFrame::insertLedgerKeysToPrefetch(
+    std::vector<LedgerKey>& keys) const
+{
+    insertAccountKey(keys, mCreateAccount.destination);
+}
 }
@@ -485,4 +485,12 @@ ManageOfferOpFrame::buildOffer(AccountID const& account,
     o.flags = flags;
     return o;
 }
+
+void
+ManageOfferOpFrame::insertLedgerKeysToPrefetch(
+    std::vector<LedgerKey>& keys) const
+{
+    insertTrustLineKeys(keys, getSourceID(), mManageOffer.selling);
+    insertTrustLineKeys(keys, getSourceID(), mManageOffer.buying);
+}
 }
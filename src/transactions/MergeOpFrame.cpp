@@ -142,4 +142,10 @@ MergeOpFrame::doCheckValid(Application& app)
     }
     return true;
 }
+
+void
+MergeOpFrame::insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys) const
+{
+    insertAccountKey(keys, mOperation.body.destination());
+}
 }
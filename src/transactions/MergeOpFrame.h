@@ -25,6 +25,8 @@ class MergeOpFrame : public OperationFrame
     bool doApply(Application& app, LedgerDelta& delta,
                  LedgerManager& ledgerManager) override;
     bool doCheckValid(Application& app) override;
+    void
+    insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys) const override;
 
     static AccountMergeResultCode
     getInnerCode(OperationResult const& res)
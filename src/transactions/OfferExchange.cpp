@@ -262,79 +262,73 @@ OfferExchange::convertWithOffers(
 
     Database& db = mLedgerManager.getDatabase();
 
-    size_t offerOffset = 0;
+    // offers are walked in (price, offerID) order; crossing an offer can
+    // only delete it or reduce its amount, so the last offer seen is a
+    // stable cursor into the order book
+    OfferFrame::pointer wheatOffer;
 
     bool needMore = (maxWheatReceive > 0 && maxSheepSend > 0);
 
     while (needMore)
     {
-        std::vector<OfferFrame::pointer> retList;
-        OfferFrame::loadBestOffers(5, offerOffset, wheat, sheep, retList, db);
-
-        offerOffset += retList.size();
+        wheatOffer =
+            OfferFrame::loadNextBestOffer(wheat, sheep, wheatOffer.get(), db);
+        if (!wheatOffer)
+        {
+            // still stuff to fill but no more offers
+            return eOK;
+        }
 
-        for (auto& wheatOffer : retList)
+        if (filter)
         {
-            if (filter)
+            OfferFilterResult r = filter(*wheatOffer);
+            switch (r)
             {
-                OfferFilterResult r = filter(*wheatOffer);
-                switch (r)
-                {
-                case eKeep:
-                    break;
-                case eStop:
-                    return eFilterStop;
-                case eSkip:
-                    continue;
-                }
+            case eKeep:
+                break;
+            case eStop:
+                return eFilterStop;
+            case eSkip:
+                continue;
             }
+        }
 
-            int64_t numWheatReceived;
-            int64_t numSheepSend;
-
-            CrossOfferResult cor =
-                crossOffer(*wheatOffer, maxWheatReceive, numWheatReceived,
-                           maxSheepSend, numSheepSend);
+        int64_t numWheatReceived;
+        int64_t numSheepSend;
 
-            assert(numSheepSend >= 0);
-            assert(numSheepSend <= maxSheepSend);
-            assert(numWheatReceived >= 0);
-            assert(numWheatReceived <= maxWheatReceive);
+        CrossOfferResult cor =
+            crossOffer(*wheatOffer, maxWheatReceive, numWheatReceived,
+                       maxSheepSend, numSheepSend);
 
-            switch (cor)
-            {
-            case eOfferTaken:
-                assert(offerOffset > 0);
-                offerOffset--; // adjust offset as an offer was deleted
-                break;
-            case eOfferPartial:
-                break;
-            case eOfferCantConvert:
-                return ePartial;
-            }
+        assert(numSheepSend >= 0);
+        assert(numSheepSend <= maxSheepSend);
+        assert(numWheatReceived >= 0);
+        assert(numWheatReceived <= maxWheatReceive);
 
-            sheepSend += numSheepSend;
-            maxSheepSend -= numSheepSend;
+        switch (cor)
+        {
+        case eOfferTaken:
+        case eOfferPartial:
+            break;
+        case eOfferCantConvert:
+            return ePartial;
+        }
 
-            wheatReceived += numWheatReceived;
-            maxWheatReceive -= numWheatReceived;
+        sheepSend += numSheepSend;
+        maxSheepSend -= numSheepSend;
 
-            needMore = (maxWheatReceive > 0 && maxSheepSend > 0);
-            if (!needMore)
-            {
-                return eOK;
-            }
-            else if (cor == eOfferPartial)
-            {
-                return ePartial;
-            }
-        }
+        wheatReceived += numWheatReceived;
+        maxWheatReceive -= numWheatReceived;
 
-        // still stuff to fill but no more offers
-        if (needMore && retList.size() < 5)
+        needMore = (maxWheatReceive > 0 && maxSheepSend > 0);
+        if (!needMore)
         {
             return eOK;
         }
+        else if (cor == eOfferPartial)
+        {
+            return ePartial;
+        }
     }
     return eOK;
 }
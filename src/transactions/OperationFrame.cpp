@@ -129,6 +129,36 @@ OperationFrame::getSourceID() const
                                     : mParentTx.getEnvelope().tx.sourceAccount;
 }
 
+void
+OperationFrame::insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys) const
+{
+}
+
+void
+OperationFrame::insertAccountKey(std::vector<LedgerKey>& keys,
+                                 AccountID const& accountID)
+{
+    LedgerKey k(ACCOUNT);
+    k.account().accountID = accountID;
+    keys.emplace_back(std::move(k));
+}
+
+void
+OperationFrame::insertTrustLineKeys(std::vector<LedgerKey>& keys,
+                                    AccountID const& accountID,
+                                    Asset const& asset)
+{
+    if (asset.type() == ASSET_TYPE_NATIVE || !isAssetValid(asset))
+    {
+        return;
+    }
+    LedgerKey k(TRUSTLINE);
+    k.trustLine().accountID = accountID;
+    k.trustLine().asset = asset;
+    keys.emplace_back(std::move(k));
+    insertAccountKey(keys, getIssuer(asset));
+}
+
 bool
 OperationFrame::loadAccount(int ledgerProtocolVersion, LedgerDelta* delta,
                             Database& db)
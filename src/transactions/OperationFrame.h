@@ -9,6 +9,7 @@
 #include "overlay/StellarXDR.h"
 #include "util/types.h"
 #include <memory>
+#include <vector>
 
 namespace medida
 {
@@ -46,6 +47,14 @@ class OperationFrame
                          LedgerManager& ledgerManager) = 0;
     virtual ThresholdLevel getThresholdLevel() const;
 
+    static void insertAccountKey(std::vector<LedgerKey>& keys,
+                                 AccountID const& accountID);
+    // adds the trust line of `accountID` for `asset` and the account of its
+    // issuer, nothing for the native asset
+    static void insertTrustLineKeys(std::vector<LedgerKey>& keys,
+                                    AccountID const& accountID,
+                                    Asset const& asset);
+
   public:
     static std::shared_ptr<OperationFrame>
     makeHelper(Operation const& op, OperationResult& res,
@@ -72,6 +81,11 @@ class OperationFrame
 
     AccountID const& getSourceID() const;
 
+    // adds the keys of the entries this operation is known to load before it
+    // is applied, see EntryFrame::prefetch
+    virtual void
+    insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys) const;
+
     // load account if needed
     // returns true on success
     bool loadAccount(int ledgerProtocolVersion, LedgerDelta* delta,
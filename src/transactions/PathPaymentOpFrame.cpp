@@ -386,4 +386,15 @@ PathPaymentOpFrame::doCheckValid(Application& app)
     }
     return true;
 }
+
+void
+PathPaymentOpFrame::insertLedgerKeysToPrefetch(
+    std::vector<LedgerKey>& keys) const
+{
+    // lines along the path depend on the offers crossed
+    insertAccountKey(keys, mPathPayment.destination);
+    insertTrustLineKeys(keys, getSourceID(), mPathPayment.sendAsset);
+    insertTrustLineKeys(keys, mPathPayment.destination,
+                        mPathPayment.destAsset);
+}
 }
@@ -171,4 +171,12 @@ PaymentOpFrame::doCheckValid(Application& app)
     }
     return true;
 }
+
+void
+PaymentOpFrame::insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys) const
+{
+    insertAccountKey(keys, mPayment.destination);
+    insertTrustLineKeys(keys, getSourceID(), mPayment.asset);
+    insertTrustLineKeys(keys, mPayment.destination, mPayment.asset);
+}
 }
@@ -59,17 +59,14 @@ SignatureChecker::checkSignature(AccountID const& accountID,
         }
     }
 
-    using VerifyT =
-        std::function<bool(DecoratedSignature const&, Signer const&)>;
+    using VerifyT = std::function<bool(size_t, Signer const&)>;
     auto verifyAll = [&](std::vector<Signer>& signers, VerifyT verify) {
         for (size_t i = 0; i < mSignatures.size(); i++)
         {
-            auto const& sig = mSignatures[i];
-
             for (auto it = signers.begin(); it != signers.end(); ++it)
             {
                 auto& signerKey = *it;
-                if (verify(sig, signerKey))
+                if (verify(i, signerKey))
                 {
                     mUsedSignatures[i] = true;
                     totalWeight += signerKey.weight;
@@ -87,19 +84,51 @@ SignatureChecker::checkSignature(AccountID const& accountID,
 
     auto verified =
         verifyAll(signers[SIGNER_KEY_TYPE_HASH_X],
-                  [&](DecoratedSignature const& sig, Signer const& signerKey) {
-                      return SignatureUtils::verifyHashX(sig, signerKey.key);
+                  [&](size_t i, Signer const& signerKey) {
+                      return SignatureUtils::verifyHashX(mSignatures[i],
+                                                         signerKey.key);
                   });
     if (verified)
     {
         return true;
     }
 
-    verified = verifyAll(
-        signers[SIGNER_KEY_TYPE_ED25519],
-        [&](DecoratedSignature const& sig, Signer const& signerKey) {
-            return SignatureUtils::verify(sig, signerKey.key, mContentsHash);
-        });
+    // verify every (signature, signer) pair whose hint matches with one
+    // pass over the verify cache
+    auto& edSigners = signers[SIGNER_KEY_TYPE_ED25519];
+    std::vector<PublicKey> edKeys;
+    for (auto const& signerKey : edSigners)
+    {
+        edKeys.emplace_back(KeyUtils::convertKey<PublicKey>(signerKey.key));
+    }
+    std::vector<PubKeyUtils::VerifySigItem> items;
+    std::vector<std::pair<size_t, size_t>> itemPairs;
+    for (size_t i = 0; i < mSignatures.size(); i++)
+    {
+        auto const& sig = mSignatures[i];
+        for (size_t k = 0; k < edKeys.size(); k++)
+        {
+            if (SignatureUtils::doesHintMatch(edKeys[k].ed25519(), sig.hint))
+            {
+                items.push_back({edKeys[k], sig.signature, mContentsHash});
+                itemPairs.emplace_back(i, k);
+            }
+        }
+    }
+    auto results = PubKeyUtils::verifySigsCached(items);
+    std::set<std::pair<size_t, SignerKey>> validPairs;
+    for (size_t j = 0; j < results.size(); j++)
+    {
+        if (results[j])
+        {
+            validPairs.emplace(itemPairs[j].first,
+                               edSigners[itemPairs[j].second].key);
+        }
+    }
+
+    verified = verifyAll(edSigners, [&](size_t i, Signer const& signerKey) {
+        return validPairs.count(std::make_pair(i, signerKey.key)) != 0;
+    });
     if (verified)
     {
         return true;
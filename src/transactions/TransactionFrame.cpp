@@ -26,7 +26,12 @@
 #include "medida/metrics_registry.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
 namespace stellar
 {
@@ -555,6 +560,30 @@ TransactionFrame::apply(LedgerDelta& delta, TransactionMeta& meta,
     return !errorEncountered;
 }
 
+void
+TransactionFrame::insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys)
+{
+    LedgerKey source(ACCOUNT);
+    source.account().accountID = getSourceID();
+    keys.emplace_back(std::move(source));
+
+    // operation frames are only bound to the results by resetResults, which
+    // must not run before processFeeSeqNum: use scratch ones
+    auto const& ops = mEnvelope.tx.operations;
+    std::vector<OperationResult> results(ops.size());
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+        if (ops[i].sourceAccount)
+        {
+            LedgerKey opSource(ACCOUNT);
+            opSource.account().accountID = *ops[i].sourceAccount;
+            keys.emplace_back(std::move(opSource));
+        }
+        auto op = OperationFrame::makeHelper(ops[i], results[i], *this);
+        op->insertLedgerKeysToPrefetch(keys);
+    }
+}
+
 StellarMessage
 TransactionFrame::toStellarMessage() const
 {
@@ -564,84 +593,264 @@ TransactionFrame::toStellarMessage() const
     return msg;
 }
 
-void
-TransactionFrame::storeTransaction(LedgerManager& ledgerManager,
-                                   TransactionMeta& tm, int txindex,
-                                   TransactionResultSet& resultSet) const
+namespace
 {
-    auto txBytes(xdr::xdr_to_opaque(mEnvelope));
+// Rows encoded by one task; below this, encoding is not worth a handoff.
+size_t const ENCODE_CHUNK_SIZE = 16;
 
-    resultSet.results.emplace_back(getResultPair());
-    auto txResultBytes(xdr::xdr_to_opaque(resultSet.results.back()));
+// Runs encode(begin, end) over [0, n) in chunks on the worker threads and
+// returns once all of them are done. The calling thread encodes chunks as
+// well, so this makes progress even while every worker is busy.
+void
+encodeInParallel(Application& app, size_t n,
+                 std::function<void(size_t, size_t)> encode)
+{
+    if (n <= ENCODE_CHUNK_SIZE)
+    {
+        encode(0, n);
+        return;
+    }
 
-    std::string txBody;
-    txBody = bn::encode_b64(txBytes);
+    struct Run
+    {
+        std::function<void(size_t, size_t)> mEncode;
+        size_t mSize;
+        size_t mChunks;
+        std::atomic<size_t> mNextChunk{0};
+        std::mutex mMutex;
+        std::condition_variable mDone;
+        size_t mFinished{0};
+        std::exception_ptr mError;
+
+        // Encodes chunks until none is left.
+        void
+        drain()
+        {
+            size_t i;
+            while ((i = mNextChunk++) < mChunks)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    mEncode(i * ENCODE_CHUNK_SIZE,
+                            std::min(mSize, (i + 1) * ENCODE_CHUNK_SIZE));
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (error && !mError)
+                {
+                    mError = error;
+                }
+                if (++mFinished == mChunks)
+                {
+                    mDone.notify_all();
+                }
+            }
+        }
+    };
+
+    auto run = std::make_shared<Run>();
+    run->mEncode = std::move(encode);
+    run->mSize = n;
+    run->mChunks = (n + ENCODE_CHUNK_SIZE - 1) / ENCODE_CHUNK_SIZE;
+
+    // Tasks that start after the last chunk was taken find nothing to do;
+    // they only keep `run` alive, never the caller's rows.
+    size_t nTasks = std::min<size_t>(
+        run->mChunks - 1, std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t i = 0; i < nTasks; ++i)
+    {
+        app.getWorkerIOService().post([run]() { run->drain(); });
+    }
+    run->drain();
 
-    std::string txResult;
-    txResult = bn::encode_b64(txResultBytes);
+    std::unique_lock<std::mutex> lock(run->mMutex);
+    run->mDone.wait(lock, [&run]() { return run->mFinished == run->mChunks; });
+    if (run->mError)
+    {
+        std::rethrow_exception(run->mError);
+    }
+}
+}
 
-    xdr::opaque_vec<> txMeta(xdr::xdr_to_opaque(tm));
+void
+TransactionFrame::addHistoryRow(TransactionMeta tm,
+                                TransactionResultSet& resultSet,
+                                std::vector<HistoryRow>& rows) const
+{
+    resultSet.results.emplace_back(getResultPair());
 
-    std::string meta;
-    meta = bn::encode_b64(txMeta);
+    rows.emplace_back();
+    auto& row = rows.back();
+    row.mTxID = getContentsHash();
+    row.mEnvelope = mEnvelope;
+    row.mResult = resultSet.results.back();
+    row.mMeta = std::move(tm);
+}
 
-    string txIDString(binToHex(getContentsHash()));
+void
+TransactionFrame::storeHistoryRows(Application& app, uint32 ledgerSeq,
+                                   std::vector<HistoryRow> const& rows)
+{
+    if (rows.empty())
+    {
+        return;
+    }
 
-    auto& db = ledgerManager.getDatabase();
-    auto prep = db.getPreparedStatement(
-        "INSERT INTO txhistory "
-        "( txid, ledgerseq, txindex,  txbody, txresult, txmeta) VALUES "
-        "(:id,  :seq,      :txindex, :txb,   :txres,   :meta)");
+    size_t n = rows.size();
+    std::vector<std::string> txIDs(n), txBodies(n), txResults(n), txMetas(n);
+    std::vector<int> txIndexes(n);
+    encodeInParallel(app, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const& row = rows[i];
+            txIDs[i] = binToHex(row.mTxID);
+            txIndexes[i] = static_cast<int>(i) + 1;
+            txBodies[i] = bn::encode_b64(xdr::xdr_to_opaque(row.mEnvelope));
+            txResults[i] = bn::encode_b64(xdr::xdr_to_opaque(row.mResult));
+            txMetas[i] = bn::encode_b64(xdr::xdr_to_opaque(row.mMeta));
+        }
+    });
+    std::vector<uint32> ledgerSeqs(n, ledgerSeq);
 
-    auto& st = prep.statement();
-    st.exchange(soci::use(txIDString));
-    st.exchange(soci::use(ledgerManager.getCurrentLedgerHeader().ledgerSeq));
-    st.exchange(soci::use(txindex));
-    st.exchange(soci::use(txBody));
-    st.exchange(soci::use(txResult));
-    st.exchange(soci::use(meta));
-    st.define_and_bind();
+    auto& db = app.getDatabase();
+    long long affected;
+    if (db.isSqlite())
     {
-        auto timer = db.getInsertTimer("txhistory");
-        st.execute(true);
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO txhistory "
+            "( txid, ledgerseq, txindex,  txbody, txresult, txmeta) VALUES "
+            "(:id,  :seq,      :txindex, :txb,   :txres,   :meta)");
+        auto& st = prep.statement();
+        st.exchange(soci::use(txIDs));
+        st.exchange(soci::use(ledgerSeqs));
+        st.exchange(soci::use(txIndexes));
+        st.exchange(soci::use(txBodies));
+        st.exchange(soci::use(txResults));
+        st.exchange(soci::use(txMetas));
+        st.define_and_bind();
+        {
+            auto timer = db.getInsertTimer("txhistory");
+            st.execute(true);
+        }
+        affected = st.get_affected_rows();
+    }
+    else
+    {
+        std::string strIDs = toPostgresArray(txIDs);
+        std::string strIndexes = toPostgresArray(txIndexes);
+        std::string strBodies = toPostgresArray(txBodies);
+        std::string strResults = toPostgresArray(txResults);
+        std::string strMetas = toPostgresArray(txMetas);
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO txhistory "
+            "( txid, ledgerseq, txindex, txbody, txresult, txmeta) "
+            "SELECT id, :seq, txindex, txb, txres, meta FROM "
+            "unnest(:id::TEXT[], :txindex::INT[], :txb::TEXT[], "
+            ":txres::TEXT[], :meta::TEXT[]) "
+            "AS x(id, txindex, txb, txres, meta)");
+        auto& st = prep.statement();
+        st.exchange(soci::use(ledgerSeq));
+        st.exchange(soci::use(strIDs));
+        st.exchange(soci::use(strIndexes));
+        st.exchange(soci::use(strBodies));
+        st.exchange(soci::use(strResults));
+        st.exchange(soci::use(strMetas));
+        st.define_and_bind();
+        {
+            auto timer = db.getInsertTimer("txhistory");
+            st.execute(true);
+        }
+        affected = st.get_affected_rows();
     }
 
-    if (st.get_affected_rows() != 1)
+    if (affected != static_cast<long long>(rows.size()))
     {
         throw std::runtime_error("Could not update data in SQL");
     }
 }
 
 void
-TransactionFrame::storeTransactionFee(LedgerManager& ledgerManager,
-                                      LedgerEntryChanges const& changes,
-                                      int txindex) const
+TransactionFrame::addFeeHistoryRow(LedgerEntryChanges changes,
+                                   std::vector<FeeHistoryRow>& rows) const
 {
-    xdr::opaque_vec<> txChanges(xdr::xdr_to_opaque(changes));
-
-    std::string txChanges64;
-    txChanges64 = bn::encode_b64(txChanges);
+    rows.emplace_back();
+    auto& row = rows.back();
+    row.mTxID = getContentsHash();
+    row.mChanges = std::move(changes);
+}
 
-    string txIDString(binToHex(getContentsHash()));
+void
+TransactionFrame::storeFeeHistoryRows(Application& app, uint32 ledgerSeq,
+                                      std::vector<FeeHistoryRow> const& rows)
+{
+    if (rows.empty())
+    {
+        return;
+    }
 
-    auto& db = ledgerManager.getDatabase();
-    auto prep = db.getPreparedStatement(
-        "INSERT INTO txfeehistory "
-        "( txid, ledgerseq, txindex,  txchanges) VALUES "
-        "(:id,  :seq,      :txindex, :txchanges)");
+    size_t n = rows.size();
+    std::vector<std::string> txIDs(n), txChanges(n);
+    std::vector<int> txIndexes(n);
+    encodeInParallel(app, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto const& row = rows[i];
+            txIDs[i] = binToHex(row.mTxID);
+            txIndexes[i] = static_cast<int>(i) + 1;
+            txChanges[i] = bn::encode_b64(xdr::xdr_to_opaque(row.mChanges));
+        }
+    });
+    std::vector<uint32> ledgerSeqs(n, ledgerSeq);
 
-    auto& st = prep.statement();
-    st.exchange(soci::use(txIDString));
-    st.exchange(soci::use(ledgerManager.getCurrentLedgerHeader().ledgerSeq));
-    st.exchange(soci::use(txindex));
-    st.exchange(soci::use(txChanges64));
-    st.define_and_bind();
+    auto& db = app.getDatabase();
+    long long affected;
+    if (db.isSqlite())
     {
-        auto timer = db.getInsertTimer("txfeehistory");
-        st.execute(true);
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO txfeehistory "
+            "( txid, ledgerseq, txindex,  txchanges) VALUES "
+            "(:id,  :seq,      :txindex, :txchanges)");
+        auto& st = prep.statement();
+        st.exchange(soci::use(txIDs));
+        st.exchange(soci::use(ledgerSeqs));
+        st.exchange(soci::use(txIndexes));
+        st.exchange(soci::use(txChanges));
+        st.define_and_bind();
+        {
+            auto timer = db.getInsertTimer("txfeehistory");
+            st.execute(true);
+        }
+        affected = st.get_affected_rows();
+    }
+    else
+    {
+        std::string strIDs = toPostgresArray(txIDs);
+        std::string strIndexes = toPostgresArray(txIndexes);
+        std::string strChanges = toPostgresArray(txChanges);
+        auto prep = db.getPreparedStatement(
+            "INSERT INTO txfeehistory "
+            "( txid, ledgerseq, txindex, txchanges) "
+            "SELECT id, :seq, txindex, txchanges FROM "
+            "unnest(:id::TEXT[], :txindex::INT[], :txchanges::TEXT[]) "
+            "AS x(id, txindex, txchanges)");
+        auto& st = prep.statement();
+        st.exchange(soci::use(ledgerSeq));
+        st.exchange(soci::use(strIDs));
+        st.exchange(soci::use(strIndexes));
+        st.exchange(soci::use(strChanges));
+        st.define_and_bind();
+        {
+            auto timer = db.getInsertTimer("txfeehistory");
+            st.execute(true);
+        }
+        affected = st.get_affected_rows();
     }
 
-    if (st.get_affected_rows() != 1)
+    if (affected != static_cast<long long>(rows.size()))
     {
         throw std::runtime_error("Could not update data in SQL");
     }
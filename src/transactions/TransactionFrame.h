@@ -152,20 +152,45 @@ class TransactionFrame
     // version without meta
     bool apply(LedgerDelta& delta, Application& app);
 
+    // adds the keys of the entries loaded by processFeeSeqNum and, as far as
+    // they are known in advance, by apply, see EntryFrame::prefetch
+    void insertLedgerKeysToPrefetch(std::vector<LedgerKey>& keys);
+
     StellarMessage toStellarMessage() const;
 
     AccountFrame::pointer loadAccount(int ledgerProtocolVersion,
                                       LedgerDelta* delta, Database& app,
                                       AccountID const& accountID);
 
-    // transaction history
-    void storeTransaction(LedgerManager& ledgerManager, TransactionMeta& tm,
-                          int txindex, TransactionResultSet& resultSet) const;
+    // Rows of txhistory and txfeehistory, collected while a ledger is
+    // applied. The rows of a ledger are encoded on the worker threads and
+    // written together, with txindex being their position in the vector,
+    // starting at 1.
+    struct HistoryRow
+    {
+        Hash mTxID;
+        TransactionEnvelope mEnvelope;
+        TransactionResultPair mResult;
+        TransactionMeta mMeta;
+    };
+    struct FeeHistoryRow
+    {
+        Hash mTxID;
+        LedgerEntryChanges mChanges;
+    };
+
+    // transaction history: adds the result of this transaction to
+    // `resultSet` and its row to `rows`
+    void addHistoryRow(TransactionMeta tm, TransactionResultSet& resultSet,
+                       std::vector<HistoryRow>& rows) const;
+    static void storeHistoryRows(Application& app, uint32 ledgerSeq,
+                                 std::vector<HistoryRow> const& rows);
 
     // fee history
-    void storeTransactionFee(LedgerManager& ledgerManager,
-                             LedgerEntryChanges const& changes,
-                             int txindex) const;
+    void addFeeHistoryRow(LedgerEntryChanges changes,
+                          std::vector<FeeHistoryRow>& rows) const;
+    static void storeFeeHistoryRows(Application& app, uint32 ledgerSeq,
+                                    std::vector<FeeHistoryRow> const& rows);
 
     // access to history tables
     static TransactionResultSet getTransactionHistoryResults(Database& db,
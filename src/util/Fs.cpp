@@ -12,6 +12,8 @@
 
 #ifdef _WIN32
 #include <direct.h>
+#include <fcntl.h>
+#include <io.h>
 #else
 #include <sys/stat.h>
 #endif
@@ -102,6 +104,26 @@ mkdir(std::string const& name)
     return b;
 }
 
+bool
+syncFile(std::string const& path)
+{
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+    return ok;
+}
+
+bool
+syncDir(std::string const& path)
+{
+    // directory entries cannot be flushed on their own here
+    return true;
+}
+
 void
 deltree(std::string const& d)
 {
@@ -225,6 +247,31 @@ exists(std::string const& name)
     return true;
 }
 
+static bool
+syncPath(std::string const& path, int flags)
+{
+    int fd = ::open(path.c_str(), flags);
+    if (fd == -1)
+    {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+bool
+syncFile(std::string const& path)
+{
+    return syncPath(path, O_RDONLY);
+}
+
+bool
+syncDir(std::string const& path)
+{
+    return syncPath(path, O_RDONLY | O_DIRECTORY);
+}
+
 bool
 mkdir(std::string const& name)
 {
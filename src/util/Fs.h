@@ -31,6 +31,12 @@ void unlockFile(std::string const& path);
 // Whether a path exists
 bool exists(std::string const& path);
 
+// Flush the data of a file, or the entries of a dir (so that a rename into it
+// survives a crash), to disk. Returns false on failure. Directories cannot be
+// flushed on Windows; syncDir does nothing there.
+bool syncFile(std::string const& path);
+bool syncDir(std::string const& path);
+
 // Delete a path and everything inside it (if a dir)
 void deltree(std::string const& path);
 
@@ -0,0 +1,195 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/Gzip.h"
+#include "crypto/SHA.h"
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace stellar
+{
+namespace gzip
+{
+
+namespace
+{
+// size of the buffers on either side of zlib
+size_t const CHUNK_SIZE = 256 * 1024;
+
+// windowBits selecting the gzip wrapper rather than the zlib one
+int const GZIP_WINDOW_BITS = 15 + 16;
+
+struct FileCloser
+{
+    void
+    operator()(FILE* f) const
+    {
+        fclose(f);
+    }
+};
+typedef std::unique_ptr<FILE, FileCloser> FilePtr;
+
+FilePtr
+openFile(std::string const& filename, char const* mode)
+{
+    FilePtr res(fopen(filename.c_str(), mode));
+    if (!res)
+    {
+        throw std::runtime_error("unable to open file: " + filename);
+    }
+    return res;
+}
+
+void
+writeAll(FILE* f, std::string const& filename, unsigned char const* data,
+         size_t size)
+{
+    if (size != 0 && fwrite(data, 1, size, f) != size)
+    {
+        throw std::runtime_error("unable to write file: " + filename);
+    }
+}
+
+void
+closeOutput(FilePtr& f, std::string const& filename)
+{
+    if (fclose(f.release()) != 0)
+    {
+        throw std::runtime_error("unable to write file: " + filename);
+    }
+}
+
+std::string
+zlibError(z_stream const& zs, std::string const& what, int ret)
+{
+    return what + ": " + (zs.msg ? zs.msg : std::to_string(ret));
+}
+}
+
+void
+compressFile(std::string const& in, std::string const& out)
+{
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("unable to initialize deflate");
+    }
+    std::unique_ptr<z_stream, int (*)(z_stream*)> guard(&zs, deflateEnd);
+
+    auto inFile = openFile(in, "rb");
+    auto outFile = openFile(out, "wb");
+    std::vector<unsigned char> inBuf(CHUNK_SIZE);
+    std::vector<unsigned char> outBuf(CHUNK_SIZE);
+
+    int flush;
+    do
+    {
+        size_t n = fread(inBuf.data(), 1, inBuf.size(), inFile.get());
+        if (ferror(inFile.get()))
+        {
+            throw std::runtime_error("unable to read file: " + in);
+        }
+        flush = feof(inFile.get()) ? Z_FINISH : Z_NO_FLUSH;
+        zs.next_in = inBuf.data();
+        zs.avail_in = static_cast<uInt>(n);
+        do
+        {
+            zs.next_out = outBuf.data();
+            zs.avail_out = static_cast<uInt>(outBuf.size());
+            int ret = deflate(&zs, flush);
+            if (ret == Z_STREAM_ERROR)
+            {
+                throw std::runtime_error(
+                    zlibError(zs, "unable to compress " + in, ret));
+            }
+            writeAll(outFile.get(), out, outBuf.data(),
+                     outBuf.size() - zs.avail_out);
+        } while (zs.avail_out == 0);
+    } while (flush != Z_FINISH);
+
+    closeOutput(outFile, out);
+}
+
+void
+decompressFile(std::string const& in, std::string const& out, SHA256* hasher)
+{
+    z_stream zs{};
+    if (inflateInit2(&zs, GZIP_WINDOW_BITS) != Z_OK)
+    {
+        throw std::runtime_error("unable to initialize inflate");
+    }
+    std::unique_ptr<z_stream, int (*)(z_stream*)> guard(&zs, inflateEnd);
+
+    auto inFile = openFile(in, "rb");
+    auto outFile = openFile(out, "wb");
+    std::vector<unsigned char> inBuf(CHUNK_SIZE);
+    std::vector<unsigned char> outBuf(CHUNK_SIZE);
+
+    // true between the end of a member and the start of the next one
+    bool atMemberEnd = false;
+    bool sawInput = false;
+    // inflate may hold back output that did not fit: only read more input
+    // once it left room in the output buffer
+    bool outputFull = false;
+    for (;;)
+    {
+        if (zs.avail_in == 0 && !outputFull)
+        {
+            size_t n = fread(inBuf.data(), 1, inBuf.size(), inFile.get());
+            if (ferror(inFile.get()))
+            {
+                throw std::runtime_error("unable to read file: " + in);
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            sawInput = true;
+            zs.next_in = inBuf.data();
+            zs.avail_in = static_cast<uInt>(n);
+        }
+
+        if (atMemberEnd)
+        {
+            // another member follows, as gzip -d accepts
+            if (inflateReset(&zs) != Z_OK)
+            {
+                throw std::runtime_error("unable to reset inflate");
+            }
+            atMemberEnd = false;
+        }
+
+        zs.next_out = outBuf.data();
+        zs.avail_out = static_cast<uInt>(outBuf.size());
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        {
+            throw std::runtime_error(
+                zlibError(zs, "unable to decompress " + in, ret));
+        }
+        outputFull = ret != Z_STREAM_END && zs.avail_out == 0;
+        size_t produced = outBuf.size() - zs.avail_out;
+        writeAll(outFile.get(), out, outBuf.data(), produced);
+        if (hasher && produced != 0)
+        {
+            hasher->add(ByteSlice(outBuf.data(), produced));
+        }
+        if (ret == Z_STREAM_END)
+        {
+            atMemberEnd = true;
+        }
+    }
+
+    if (!sawInput || !atMemberEnd)
+    {
+        throw std::runtime_error("unexpected end of file: " + in);
+    }
+    closeOutput(outFile, out);
+}
+}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <string>
+
+namespace stellar
+{
+
+class SHA256;
+
+namespace gzip
+{
+
+// Streaming gzip (de)compression with zlib, producing and accepting the same
+// format as the gzip tool. Both functions block, so they are meant to run on
+// worker threads; they throw std::runtime_error on any failure, in which
+// case `out` may be left partially written.
+
+// Compresses `in` into `out`.
+void compressFile(std::string const& in, std::string const& out);
+
+// Decompresses `in` into `out`, which may hold several concatenated gzip
+// members. If `hasher` is not null, every decompressed byte is also added to
+// it, so the output is hashed without being read back.
+void decompressFile(std::string const& in, std::string const& out,
+                    SHA256* hasher = nullptr);
+}
+}
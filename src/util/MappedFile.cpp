@@ -0,0 +1,98 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MappedFile.h"
+#include "util/Logging.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+
+namespace stellar
+{
+
+bool
+MappedFile::isSupported()
+{
+    return false;
+}
+
+MappedFile::MappedFile(std::string const& filename)
+{
+    throw std::runtime_error("file mapping is not supported: " + filename);
+}
+
+MappedFile::~MappedFile()
+{
+}
+}
+
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stellar
+{
+
+bool
+MappedFile::isSupported()
+{
+    return true;
+}
+
+MappedFile::MappedFile(std::string const& filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::runtime_error("unable to open file: " + filename + " (" +
+                                 strerror(errno) + ")");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("unable to stat file: " + filename + " (" +
+                                 strerror(errno) + ")");
+    }
+
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize != 0)
+    {
+        // mmap rejects empty mappings; an empty file is simply mSize == 0.
+        void* p = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("unable to map file: " + filename +
+                                     " (" + strerror(errno) + ")");
+        }
+        mData = static_cast<char const*>(p);
+
+        // Hint only: read ahead aggressively and drop pages behind the
+        // reader. Asking for the whole file up front (MADV_WILLNEED) would
+        // pull multi-gigabyte buckets into the page cache at once.
+        if (madvise(p, mSize, MADV_SEQUENTIAL) != 0)
+        {
+            CLOG(DEBUG, "Fs") << "madvise failed on " << filename << ": "
+                              << strerror(errno);
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+}
+}
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+/**
+ * A whole file mapped read-only into memory, with the kernel told that it
+ * will be read sequentially. Only available where mmap is (see
+ * isSupported()); callers fall back to ordinary reads elsewhere.
+ */
+class MappedFile : NonMovableOrCopyable
+{
+    char const* mData{nullptr};
+    size_t mSize{0};
+
+  public:
+    static bool isSupported();
+
+    // Map `filename`; throws std::runtime_error on failure.
+    explicit MappedFile(std::string const& filename);
+    ~MappedFile();
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+}
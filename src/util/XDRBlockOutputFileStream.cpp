@@ -0,0 +1,204 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/XDRBlockOutputFileStream.h"
+#include "crypto/ByteSlice.h"
+#include "util/Logging.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace stellar
+{
+
+namespace
+{
+bool
+syncFile(std::FILE* f)
+{
+    if (fflush(f) != 0)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+}
+
+size_t const XDRBlockOutputFileStream::BLOCK_SIZE;
+size_t const XDRBlockOutputFileStream::QUEUE_DEPTH;
+
+XDRBlockOutputFileStream::XDRBlockOutputFileStream(size_t blockSize)
+    : mBlockSize(blockSize), mHasher(SHA256::create())
+{
+}
+
+XDRBlockOutputFileStream::~XDRBlockOutputFileStream()
+{
+    stopWriter();
+    if (mFile)
+    {
+        fclose(mFile);
+    }
+}
+
+void
+XDRBlockOutputFileStream::open(std::string const& filename)
+{
+    assert(!mFile);
+    mFile = fopen(filename.c_str(), "wb");
+    if (!mFile)
+    {
+        std::string msg("failed to open XDR file: ");
+        msg += filename;
+        msg += ", reason: ";
+        msg += std::to_string(errno);
+        CLOG(FATAL, "Fs") << msg;
+        throw std::runtime_error(msg);
+    }
+    // Blocks are much larger than any stdio buffer would be.
+    setvbuf(mFile, nullptr, _IONBF, 0);
+    mFilename = filename;
+}
+
+void
+XDRBlockOutputFileStream::writeBlock(Block const& block)
+{
+    mHasher->add(ByteSlice(block.mData.data(), block.mUsed));
+    if (fwrite(block.mData.data(), 1, block.mUsed, mFile) != block.mUsed)
+    {
+        throw std::runtime_error("failed to write XDR file: " + mFilename +
+                                 ", reason: " + strerror(errno));
+    }
+}
+
+void
+XDRBlockOutputFileStream::runWriter()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;)
+    {
+        mCond.wait(lock, [this] { return !mFull.empty() || mClosing; });
+        if (mFull.empty())
+        {
+            return;
+        }
+        Block block = std::move(mFull.front());
+        mFull.pop_front();
+        // After a failure the remaining blocks are only recycled; the error is
+        // reported to the caller by the next submitBlock() or close().
+        bool failed = !mError.empty();
+        lock.unlock();
+        if (!failed)
+        {
+            try
+            {
+                writeBlock(block);
+            }
+            catch (std::runtime_error& e)
+            {
+                lock.lock();
+                mError = e.what();
+                lock.unlock();
+            }
+        }
+        lock.lock();
+        mFree.emplace_back(std::move(block.mData));
+        mCond.notify_all();
+    }
+}
+
+void
+XDRBlockOutputFileStream::submitBlock(bool last)
+{
+    if (mBlockUsed == 0)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mWriter.joinable())
+    {
+        mWriter = std::thread([this] { runWriter(); });
+    }
+    mCond.wait(lock, [this] {
+        return mFull.size() < QUEUE_DEPTH || !mError.empty();
+    });
+    if (!mError.empty())
+    {
+        throw std::runtime_error(mError);
+    }
+
+    mFull.push_back(Block{std::move(mBlock), mBlockUsed});
+    mCond.notify_all();
+    mBlockUsed = 0;
+    if (last)
+    {
+        return;
+    }
+    if (mFree.empty())
+    {
+        mBlock.clear();
+    }
+    else
+    {
+        mBlock = std::move(mFree.back());
+        mFree.pop_back();
+    }
+}
+
+void
+XDRBlockOutputFileStream::stopWriter()
+{
+    if (mWriter.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mClosing = true;
+        }
+        mCond.notify_all();
+        mWriter.join();
+    }
+}
+
+uint256
+XDRBlockOutputFileStream::close(bool doFsync)
+{
+    assert(mFile);
+    if (mWriter.joinable())
+    {
+        submitBlock(true);
+        stopWriter();
+        if (!mError.empty())
+        {
+            throw std::runtime_error(mError);
+        }
+    }
+    else if (mBlockUsed != 0)
+    {
+        // Everything fit in one block: no need for the writer thread.
+        writeBlock(Block{std::move(mBlock), mBlockUsed});
+    }
+    mBlockUsed = 0;
+
+    bool ok = !doFsync || syncFile(mFile);
+    ok = (fclose(mFile) == 0) && ok;
+    mFile = nullptr;
+    if (!ok)
+    {
+        throw std::runtime_error("failed to write XDR file: " + mFilename +
+                                 ", reason: " + strerror(errno));
+    }
+    return mHasher->finish();
+}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/SHA.h"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-types.h"
+#include "xdrpp/marshal.h"
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Writes a sequence of XDR objects to a file in the same format as
+ * XDROutputFileStream, while computing the SHA256 of everything written.
+ *
+ * Objects are serialized on the calling thread into large blocks. Full blocks
+ * are handed to a writer thread that hashes them and writes them out, so
+ * serializing the next block overlaps with hashing and writing the previous
+ * one. At most QUEUE_DEPTH full blocks wait for the writer, after which
+ * writeOne() blocks: the caller runs no further ahead than the disk.
+ *
+ * The writer thread is only started once the first block fills up, so small
+ * files are hashed and written on the calling thread when closed.
+ */
+class XDRBlockOutputFileStream : NonMovableOrCopyable
+{
+  public:
+    static size_t const BLOCK_SIZE = 1 << 20;
+    static size_t const QUEUE_DEPTH = 2;
+
+    explicit XDRBlockOutputFileStream(size_t blockSize = BLOCK_SIZE);
+    ~XDRBlockOutputFileStream();
+
+    // Throws std::runtime_error if `filename` cannot be opened.
+    void open(std::string const& filename);
+
+    // Writes out what is left, waits for the writer thread and closes the
+    // file, first flushing it to disk if `doFsync` is set. Returns the hash of
+    // everything written. Throws std::runtime_error if any write failed.
+    uint256 close(bool doFsync);
+
+    // Bytes written so far, which is the offset of the next object.
+    size_t
+    bytesPut() const
+    {
+        return mBytesPut;
+    }
+
+    template <typename T>
+    void
+    writeOne(T const& t)
+    {
+        uint32_t sz = (uint32_t)xdr::xdr_size(t);
+        assert(sz < 0x80000000);
+
+        if (mBlockUsed + sz + 4 > mBlock.size())
+        {
+            submitBlock();
+            if (sz + 4 > mBlock.size())
+            {
+                mBlock.resize(std::max<size_t>(mBlockSize, sz + 4));
+            }
+        }
+
+        // Write 4 bytes of size, big-endian, with XDR 'continuation' bit set on
+        // high bit of high byte.
+        char* p = mBlock.data() + mBlockUsed;
+        p[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
+        p[1] = static_cast<char>((sz >> 16) & 0xFF);
+        p[2] = static_cast<char>((sz >> 8) & 0xFF);
+        p[3] = static_cast<char>(sz & 0xFF);
+
+        xdr::xdr_put put(p + 4, p + 4 + sz);
+        xdr_argpack_archive(put, t);
+
+        mBlockUsed += sz + 4;
+        mBytesPut += sz + 4;
+    }
+
+  private:
+    struct Block
+    {
+        std::vector<char> mData;
+        size_t mUsed;
+    };
+
+    size_t const mBlockSize;
+    std::string mFilename;
+    std::FILE* mFile{nullptr};
+    std::unique_ptr<SHA256> mHasher;
+    size_t mBytesPut{0};
+
+    // block being filled by the calling thread, allocated on first use
+    std::vector<char> mBlock;
+    size_t mBlockUsed{0};
+
+    // shared with the writer thread
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<Block> mFull;
+    std::vector<std::vector<char>> mFree;
+    bool mClosing{false};
+    std::string mError;
+    std::thread mWriter;
+
+    // Hands the block being filled to the writer thread, starting it if
+    // needed, and gets an empty one unless `last` is set.
+    void submitBlock(bool last = false);
+    void writeBlock(Block const& block);
+    void runWriter();
+    void stopWriter();
+};
+}
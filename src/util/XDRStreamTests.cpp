@@ -0,0 +1,167 @@
+// Copyright 2018 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTestUtils.h"
+#include "lib/catch.hpp"
+#include "util/TmpDir.h"
+#include "util/XDRBlockOutputFileStream.h"
+#include "util/XDRStream.h"
+#include <fstream>
+#include <iterator>
+
+using namespace stellar;
+
+TEST_CASE("mapped and streamed XDR reads agree", "[xdrstream]")
+{
+    using xdr::operator==;
+
+    TmpDir tmp("xdrstream");
+    auto filename = tmp.getName() + "/entries.xdr";
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(100);
+    std::vector<size_t> offsets;
+    {
+        XDROutputFileStream out;
+        out.open(filename);
+        size_t bytes = 0;
+        for (auto const& e : entries)
+        {
+            offsets.emplace_back(bytes);
+            out.writeOne(e, nullptr, &bytes);
+        }
+        out.close();
+    }
+
+    auto readAll = [&](bool mapped) {
+        XDRInputFileStream in;
+        if (mapped)
+        {
+            in.openMapped(filename);
+        }
+        else
+        {
+            in.open(filename);
+        }
+        std::vector<LedgerEntry> res;
+        LedgerEntry e;
+        while (in && in.readOne(e))
+        {
+            res.emplace_back(e);
+        }
+        return res;
+    };
+
+    for (bool mapped : {false, true})
+    {
+        auto got = readAll(mapped);
+        REQUIRE(got.size() == entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            REQUIRE(got[i] == entries[i]);
+        }
+    }
+
+    SECTION("seek and pos")
+    {
+        XDRInputFileStream in;
+        in.openMapped(filename);
+        LedgerEntry e;
+        in.seek(offsets[42]);
+        REQUIRE(in.pos() == offsets[42]);
+        REQUIRE(in.readOne(e));
+        REQUIRE(e == entries[42]);
+        REQUIRE(in.pos() == offsets[43]);
+        in.seek(offsets.back());
+        REQUIRE(in.readOne(e));
+        REQUIRE(!in);
+        REQUIRE(!in.readOne(e));
+    }
+
+    SECTION("empty file")
+    {
+        auto empty = tmp.getName() + "/empty.xdr";
+        XDROutputFileStream out;
+        out.open(empty);
+        out.close();
+
+        XDRInputFileStream in;
+        in.openMapped(empty);
+        LedgerEntry e;
+        REQUIRE(!in);
+        REQUIRE(!in.readOne(e));
+    }
+
+    SECTION("truncated file")
+    {
+        auto truncated = tmp.getName() + "/truncated.xdr";
+        {
+            std::ifstream src(filename, std::ifstream::binary);
+            std::ofstream dst(truncated, std::ofstream::binary);
+            std::vector<char> buf(offsets[1] + 10);
+            src.read(buf.data(), buf.size());
+            dst.write(buf.data(), buf.size());
+        }
+
+        XDRInputFileStream in;
+        in.openMapped(truncated);
+        LedgerEntry e;
+        REQUIRE(in.readOne(e));
+        REQUIRE_THROWS_AS(in.readOne(e), xdr::xdr_runtime_error);
+    }
+}
+
+TEST_CASE("block and streamed XDR writes agree", "[xdrstream]")
+{
+    TmpDir tmp("xdrstream");
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(100);
+
+    auto slurp = [](std::string const& filename) {
+        std::ifstream in(filename, std::ifstream::binary);
+        return std::string(std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>());
+    };
+
+    auto streamed = tmp.getName() + "/streamed.xdr";
+    auto hasher = SHA256::create();
+    std::vector<size_t> offsets;
+    {
+        XDROutputFileStream out;
+        out.open(streamed);
+        size_t bytes = 0;
+        for (auto const& e : entries)
+        {
+            offsets.emplace_back(bytes);
+            out.writeOne(e, hasher.get(), &bytes);
+        }
+        offsets.emplace_back(bytes);
+        out.close();
+    }
+    auto hash = hasher->finish();
+
+    // A one-block file is written on the calling thread; tiny blocks go
+    // through the writer thread, and some entries do not fit in one.
+    for (size_t blockSize :
+         {XDRBlockOutputFileStream::BLOCK_SIZE, size_t(64), size_t(1000)})
+    {
+        auto blocks = tmp.getName() + "/blocks.xdr";
+        XDRBlockOutputFileStream out(blockSize);
+        out.open(blocks);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            REQUIRE(out.bytesPut() == offsets[i]);
+            out.writeOne(entries[i]);
+        }
+        REQUIRE(out.bytesPut() == offsets.back());
+        REQUIRE(out.close(blockSize == size_t(64)) == hash);
+        REQUIRE(slurp(blocks) == slurp(streamed));
+    }
+
+    SECTION("empty file")
+    {
+        auto empty = tmp.getName() + "/empty.xdr";
+        XDRBlockOutputFileStream out;
+        out.open(empty);
+        REQUIRE(out.close(true) == SHA256::create()->finish());
+        REQUIRE(slurp(empty).empty());
+    }
+}